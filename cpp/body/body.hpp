@@ -10,7 +10,13 @@
 class body : public AlgorithmBase {
 public:
     body();
+    using AlgorithmBase::detect;
     void detect(cv::Mat input_image) override;
+    void detect(const cv::Mat& input_image, AlgorithmResult& result) override;
+    void detect(const cv::Mat& input_image, AlgorithmResultBuffer& result) override;
+    void detect(const std::vector<cv::Mat>& input_images, std::vector<AlgorithmResult>& results) override;
+    bool input_spec(AlgorithmInputSpec& spec) const override;
+    void detect_prepared(const AlgorithmPreparedInput& input, AlgorithmResult& result) override;
     void init(std::string model_path) override;  
     void release() override;  
 
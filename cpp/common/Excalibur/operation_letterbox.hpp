@@ -0,0 +1,233 @@
+#pragma once
+#ifndef _OPERATION_LETTERBOX_HPP_
+#define _OPERATION_LETTERBOX_HPP_
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <Primitives/tensor.hpp>
+#include "operation_resize.hpp"
+
+namespace glasssix
+{
+	namespace excalibur
+	{
+		/// <summary>
+		/// Placement of the resized image inside the letterboxed output
+		/// </summary>
+		struct letterbox_geometry
+		{
+			float ratio;
+			int resized_width;
+			int resized_height;
+			int pad_top;
+			int pad_left;
+		};
+
+		/// <summary>
+		/// Fused letterbox for 8-bit 3-channel images: aspect-preserving bilinear resize, constant padding and
+		/// optional R/B swap in a single pass, written straight into a caller-provided buffer (e.g. NPU input memory).
+		/// Uses the fixed-point bilinear scheme of resize_cpu; the interpolation tables are kept while the source
+		/// and destination sizes stay the same.
+		/// </summary>
+		class letterbox
+		{
+		public:
+			/// <summary>
+			/// letterbox src into dst
+			/// </summary>
+			/// <param name="src">HWC source pixels, rows src_step bytes apart</param>
+			/// <param name="dst">HWC destination pixels, rows dst_step bytes apart; every pixel of dst_width x dst_height is written</param>
+			/// <param name="swap_rb">swap channel 0 and 2 (BGR to RGB)</param>
+			/// <param name="pad_value">value of the padding border</param>
+			letterbox_geometry run(const unsigned char* src, size_t src_step, int src_width, int src_height,
+				unsigned char* dst, size_t dst_step, int dst_width, int dst_height, bool swap_rb = true, unsigned char pad_value = 114)
+			{
+				letterbox_geometry geometry;
+				geometry.ratio = std::min((float)dst_width / (float)src_width, (float)dst_height / (float)src_height);
+				geometry.resized_width = (int)(src_width * geometry.ratio);
+				geometry.resized_height = (int)(src_height * geometry.ratio);
+				geometry.pad_top = (dst_height - geometry.resized_height) / 2;
+				geometry.pad_left = (dst_width - geometry.resized_width) / 2;
+
+				if (geometry.resized_width <= 0 || geometry.resized_height <= 0)
+				{
+					for (int row = 0; row < dst_height; row++)
+						memset(dst + row * dst_step, pad_value, dst_width * channels);
+					return geometry;
+				}
+
+				prepare_tables(src_width, src_height, geometry.resized_width, geometry.resized_height);
+
+				int prev_sy0 = -1, prev_sy1 = -1;
+				int* buf0 = buf0_.data();
+				int* buf1 = buf1_.data();
+				int left_bytes = geometry.pad_left * channels;
+				int resized_bytes = geometry.resized_width * channels;
+				int right_bytes = (dst_width - geometry.resized_width - geometry.pad_left) * channels;
+
+				for (int row = 0; row < dst_height; row++)
+				{
+					unsigned char* dst_row = dst + row * dst_step;
+					int dy = row - geometry.pad_top;
+					if (dy < 0 || dy >= geometry.resized_height)
+					{
+						memset(dst_row, pad_value, dst_width * channels);
+						continue;
+					}
+
+					int fy = yofs_[dy].ialpha, * swap_t;
+					int sy0 = yofs_[dy].idx, sy1 = sy0 + (fy > 0 && sy0 < src_height - 1);
+
+					// the two source rows are interpolated horizontally once and reused by the following output rows
+					int k;
+					if (sy0 == prev_sy0 && sy1 == prev_sy1)
+						k = 2;
+					else if (sy0 == prev_sy1)
+					{
+						CV_SWAP(buf0, buf1, swap_t);
+						k = 1;
+					}
+					else
+						k = 0;
+
+					for (; k < 2; k++)
+					{
+						int* _buf = k == 0 ? buf0 : buf1;
+						int sy = k == 0 ? sy0 : sy1;
+						if (k == 1 && sy1 == sy0)
+						{
+							memcpy(buf1, buf0, resized_bytes * sizeof(buf0[0]));
+							continue;
+						}
+						horizontal_row(src + sy * src_step, geometry.resized_width, _buf);
+					}
+
+					prev_sy0 = sy0;
+					prev_sy1 = sy1;
+
+					memset(dst_row, pad_value, left_bytes);
+					unsigned char* out = dst_row + left_bytes;
+					int c0 = swap_rb ? 2 : 0, c2 = swap_rb ? 0 : 2;
+					if (sy0 == sy1)
+					{
+						for (int dx = 0; dx < resized_bytes; dx += channels)
+						{
+							out[dx + c0] = (unsigned char)ICV_WARP_DESCALE_8U(ICV_WARP_MUL_ONE_8U(buf0[dx]));
+							out[dx + 1] = (unsigned char)ICV_WARP_DESCALE_8U(ICV_WARP_MUL_ONE_8U(buf0[dx + 1]));
+							out[dx + c2] = (unsigned char)ICV_WARP_DESCALE_8U(ICV_WARP_MUL_ONE_8U(buf0[dx + 2]));
+						}
+					}
+					else
+					{
+						for (int dx = 0; dx < resized_bytes; dx += channels)
+						{
+							out[dx + c0] = (unsigned char)ICV_WARP_DESCALE_8U(ICV_WARP_MUL_ONE_8U(buf0[dx]) + fy * (buf1[dx] - buf0[dx]));
+							out[dx + 1] = (unsigned char)ICV_WARP_DESCALE_8U(ICV_WARP_MUL_ONE_8U(buf0[dx + 1]) + fy * (buf1[dx + 1] - buf0[dx + 1]));
+							out[dx + c2] = (unsigned char)ICV_WARP_DESCALE_8U(ICV_WARP_MUL_ONE_8U(buf0[dx + 2]) + fy * (buf1[dx + 2] - buf0[dx + 2]));
+						}
+					}
+					memset(out + resized_bytes, pad_value, right_bytes);
+				}
+
+				return geometry;
+			}
+
+		private:
+			static constexpr int channels = 3;
+
+			// same tables as resize_cpu, with x offsets premultiplied by the channel count
+			void prepare_tables(int width, int height, int dst_width, int dst_height)
+			{
+				if (width == width_ && height == height_ && dst_width == dst_width_ && dst_height == dst_height_)
+					return;
+
+				width_ = width;
+				height_ = height;
+				dst_width_ = dst_width;
+				dst_height_ = dst_height;
+				xofs_.resize(dst_width);
+				yofs_.resize(dst_height);
+				buf0_.resize(dst_width * channels);
+				buf1_.resize(dst_width * channels);
+
+				int scale_x = ((width << ICV_WARP_SHIFT2) + dst_width / 2) / dst_width;
+				int scale_y = ((height << ICV_WARP_SHIFT2) + dst_height / 2) / dst_height;
+
+				xmax_ = dst_width;
+				for (int dx = 0; dx < dst_width; dx++)
+				{
+					int fx_1024x = ((dx * 2 + 1) * scale_x - (1 << ICV_WARP_SHIFT2)) / 2;
+					int sx = (fx_1024x >> ICV_WARP_SHIFT2);
+					fx_1024x = ((fx_1024x - (sx << ICV_WARP_SHIFT2)) >> ICV_SHIFT_DIFF);
+
+					if (sx < 0)
+					{
+						sx = 0;
+						fx_1024x = 0;
+					}
+
+					if (sx >= width - 1)
+					{
+						fx_1024x = 0;
+						sx = width - 1;
+
+						if (xmax_ >= dst_width)
+						{
+							xmax_ = dx;
+						}
+					}
+
+					xofs_[dx].idx = sx * channels;
+					xofs_[dx].ialpha = fx_1024x;
+				}
+
+				for (int dy = 0; dy < dst_height; dy++)
+				{
+					int fy_1024x = ((dy * 2 + 1) * scale_y - (1 << ICV_WARP_SHIFT2)) / 2;
+					int sy = (fy_1024x >> ICV_WARP_SHIFT2);
+					fy_1024x = ((fy_1024x - (sy << ICV_WARP_SHIFT2)) >> ICV_SHIFT_DIFF);
+
+					if (sy < 0)
+					{
+						sy = 0;
+						fy_1024x = 0;
+					}
+
+					yofs_[dy].idx = sy;
+					yofs_[dy].ialpha = fy_1024x;
+				}
+			}
+
+			void horizontal_row(const unsigned char* src_row, int dst_width, int* buf) const
+			{
+				int dx = 0;
+				for (; dx < xmax_; dx++)
+				{
+					int sx = xofs_[dx].idx;
+					int fx = xofs_[dx].ialpha;
+					int* out = buf + dx * channels;
+					for (int c = 0; c < channels; c++)
+					{
+						int t = src_row[sx + c];
+						out[c] = ICV_WARP_MUL_ONE_8U(t) + fx * (src_row[sx + channels + c] - t);
+					}
+				}
+
+				for (; dx < dst_width; dx++)
+					for (int c = 0; c < channels; c++)
+						buf[dx * channels + c] = ICV_WARP_MUL_ONE_8U(src_row[xofs_[dx].idx + c]);
+			}
+
+			int width_ = 0;
+			int height_ = 0;
+			int dst_width_ = 0;
+			int dst_height_ = 0;
+			int xmax_ = 0;
+			std::vector<CvResizeAlpha> xofs_;
+			std::vector<CvResizeAlpha> yofs_;
+			std::vector<int> buf0_;
+			std::vector<int> buf1_;
+		};
+	}
+}
+#endif // !_OPERATION_LETTERBOX_HPP_
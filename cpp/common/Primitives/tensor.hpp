@@ -133,7 +133,7 @@ namespace glasssix
 				}
 			}
 
-			std::vector<int> data_shape() const 
+			const std::vector<int>& data_shape() const 
 			{
 				return shape_;
 			}
@@ -0,0 +1,310 @@
+#pragma once
+
+#include "singleton.hpp"
+
+#include <mutex>
+#include <deque>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <algorithm>
+#include <vector>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <condition_variable>
+
+namespace glasssix
+{
+	/// <summary>
+	/// A thread pool where every worker owns a task deque: it runs its own tasks newest first and, when idle,
+	/// steals the oldest task of another worker. The thread calling parallel_for() helps with queued tasks while
+	/// it waits, so nested calls from inside a task do not deadlock.
+	/// instance() is the process-wide pool with one worker less than the hardware threads.
+	/// </summary>
+	class work_stealing_pool : public singleton<work_stealing_pool>
+	{
+	public:
+		work_stealing_pool(const work_stealing_pool&) = delete;
+		work_stealing_pool& operator=(const work_stealing_pool&) = delete;
+
+		/// <summary>
+		/// Creates the pool.
+		/// </summary>
+		/// <param name="threads">Number of worker threads; 0 runs every task on the calling thread</param>
+		explicit work_stealing_pool(std::size_t threads = default_threads())
+		{
+			for (std::size_t i = 0; i < threads; i++)
+				workers_.emplace_back(std::make_unique<worker>());
+			for (std::size_t i = 0; i < threads; i++)
+				workers_[i]->thread = std::thread([this, i]() { run_worker(i); });
+		}
+
+		~work_stealing_pool()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				stop_ = true;
+			}
+			cv_.notify_all();
+			for (auto& entry : workers_)
+				entry->thread.join();
+		}
+
+		std::size_t threads() const
+		{
+			return workers_.size();
+		}
+
+		/// <summary>
+		/// Calls body(i) for every i in [0, count) and returns when all calls have finished.
+		/// [0, count) is split into one contiguous range per runner (the calling thread and up to threads() workers);
+		/// a runner works through its own range front to back, and once it is empty steals the back half of another
+		/// runner's range, so neighbouring indices mostly run on the same thread and uneven calls still balance.
+		/// The calls run concurrently in no particular order; the first exception thrown is rethrown here and
+		/// the indices not started yet are skipped.
+		/// </summary>
+		template<typename Body>
+		void parallel_for(std::size_t count, Body&& body)
+		{
+			if (count == 0)
+				return;
+
+			std::size_t helpers = std::min(count, workers_.size() + 1) - 1;
+			if (helpers == 0)
+			{
+				for (std::size_t i = 0; i < count; i++)
+					body(i);
+				return;
+			}
+
+			std::size_t runners = helpers + 1;
+			std::vector<index_range> ranges(runners);
+			for (std::size_t r = 0; r < runners; r++)
+			{
+				ranges[r].begin = count * r / runners;
+				ranges[r].end = count * (r + 1) / runners;
+			}
+
+			task_group group;
+			group.pending = helpers;
+			auto runner = [&group, &ranges, &body](std::size_t self) {
+				std::size_t i;
+				while (!group.cancelled.load(std::memory_order_relaxed) && claim(ranges, self, i))
+				{
+					try
+					{
+						body(i);
+					}
+					catch (...)
+					{
+						group.fail(std::current_exception());
+					}
+				}
+			};
+
+			for (std::size_t r = 1; r < runners; r++)
+				push([&group, &runner, r]() {
+					runner(r);
+					group.finish();
+				});
+
+			runner(0);
+			while (!group.done())
+			{
+				if (!run_one())
+					group.wait();
+			}
+
+			if (group.error)
+				std::rethrow_exception(group.error);
+		}
+
+		static std::size_t default_threads()
+		{
+			std::size_t hardware = std::thread::hardware_concurrency();
+			return hardware > 1 ? hardware - 1 : 0;
+		}
+
+	private:
+		using task = std::function<void()>;
+
+		struct worker
+		{
+			std::mutex mutex;
+			std::deque<task> tasks;
+			std::thread thread;
+		};
+
+		// the indices [begin, end) a parallel_for() runner has left to call
+		struct index_range
+		{
+			std::mutex mutex;
+			std::size_t begin = 0;
+			std::size_t end = 0;
+		};
+
+		struct task_group
+		{
+			std::atomic<bool> cancelled{ false };
+			std::size_t pending;
+			std::exception_ptr error;
+			std::mutex mutex;
+			std::condition_variable cv;
+
+			void fail(std::exception_ptr exception)
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (!error)
+					error = exception;
+				cancelled.store(true, std::memory_order_relaxed);
+			}
+
+			// the waiting thread may return as soon as pending reaches 0, so the group is not touched after unlocking
+			void finish()
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (--pending == 0)
+					cv.notify_all();
+			}
+
+			bool done()
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				return pending == 0;
+			}
+
+			void wait()
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				cv.wait(lock, [this]() { return pending == 0; });
+			}
+		};
+
+		// takes the next index of the runner's own range, or steals the back half of the first non-empty range after it.
+		// Only one range is locked at a time; a thief that has emptied a victim publishes the stolen rest as its own range
+		static bool claim(std::vector<index_range>& ranges, std::size_t self, std::size_t& index)
+		{
+			{
+				index_range& own = ranges[self];
+				std::lock_guard<std::mutex> lock(own.mutex);
+				if (own.begin < own.end)
+				{
+					index = own.begin++;
+					return true;
+				}
+			}
+
+			for (std::size_t n = 1; n < ranges.size(); n++)
+			{
+				index_range& victim = ranges[(self + n) % ranges.size()];
+				std::size_t begin;
+				std::size_t end;
+				{
+					std::lock_guard<std::mutex> lock(victim.mutex);
+					if (victim.begin == victim.end)
+						continue;
+					begin = victim.begin + (victim.end - victim.begin) / 2;
+					end = victim.end;
+					victim.end = begin;
+				}
+
+				index = begin;
+				if (begin + 1 < end)
+				{
+					index_range& own = ranges[self];
+					std::lock_guard<std::mutex> lock(own.mutex);
+					own.begin = begin + 1;
+					own.end = end;
+				}
+				return true;
+			}
+			return false;
+		}
+
+		// pushes to the deque of the calling worker, or spreads tasks from other threads across the workers
+		void push(task&& item)
+		{
+			std::size_t target = current_pool_ == this
+				? current_worker_
+				: next_worker_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+			// counted before it becomes visible, so takers never see more tasks than queued_
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				++queued_;
+			}
+			{
+				std::lock_guard<std::mutex> lock(workers_[target]->mutex);
+				workers_[target]->tasks.push_back(std::move(item));
+			}
+			cv_.notify_one();
+		}
+
+		// a worker takes from the back of its own deque; everything else is stolen from the front
+		bool take(std::size_t start, bool owner, task& item)
+		{
+			for (std::size_t n = 0; n < workers_.size(); n++)
+			{
+				worker& victim = *workers_[(start + n) % workers_.size()];
+				std::lock_guard<std::mutex> lock(victim.mutex);
+				if (victim.tasks.empty())
+					continue;
+
+				if (owner && n == 0)
+				{
+					item = std::move(victim.tasks.back());
+					victim.tasks.pop_back();
+				}
+				else
+				{
+					item = std::move(victim.tasks.front());
+					victim.tasks.pop_front();
+				}
+				queued_.fetch_sub(1, std::memory_order_relaxed);
+				return true;
+			}
+			return false;
+		}
+
+		bool run_one()
+		{
+			bool owner = current_pool_ == this;
+			std::size_t start = owner ? current_worker_ : next_worker_.load(std::memory_order_relaxed) % workers_.size();
+			task item;
+			if (!take(start, owner, item))
+				return false;
+			item();
+			return true;
+		}
+
+		void run_worker(std::size_t self)
+		{
+			current_pool_ = this;
+			current_worker_ = self;
+			while (true)
+			{
+				task item;
+				if (take(self, true, item))
+				{
+					item();
+					continue;
+				}
+
+				std::unique_lock<std::mutex> lock(mutex_);
+				cv_.wait(lock, [this]() { return stop_ || queued_.load(std::memory_order_relaxed) > 0; });
+				if (stop_)
+					return;
+			}
+		}
+
+		std::vector<std::unique_ptr<worker>> workers_;
+		std::atomic<std::size_t> next_worker_{ 0 };
+		std::atomic<std::size_t> queued_{ 0 };
+		std::mutex mutex_;
+		std::condition_variable cv_;
+		bool stop_ = false;
+
+		static inline thread_local work_stealing_pool* current_pool_ = nullptr;
+		static inline thread_local std::size_t current_worker_ = 0;
+	};
+}
@@ -2,17 +2,31 @@
 #ifndef _RKNN2WRAPPER_HPP_
 #define _RKNN2WRAPPER_HPP_
 
+#include <mutex>
+#include <thread>
+#include <algorithm>
+#include <future>
 #include <exception>
+#include <functional>
 #include <unordered_map>
 
 #include "../Primitives/tensor.hpp"
 #include "../Primitives/fmt/format.h"
+#include "../Primitives/bounded_blocking_queue.hpp"
 
 #if defined(BUILD_RV1106) 
 #include "rknn_api_rv1106.h"
+#include "rknn_output_conversions.hpp"
 #else
 #include "rknn_api.h"
 #endif
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 namespace glasssix
 {
 	namespace rknnwrapper
@@ -75,112 +89,108 @@ namespace glasssix
 			return model;
 		}
 
-#if defined(BUILD_RV1106) 
-		static float deqnt_affine_to_f32(int8_t qnt, int32_t zp, float scale)
+		// Callers name the model by its packaged file; the file loaded is the .rknn next to it, the path with
+		// its four-character extension replaced.
+		static std::string resolve_model_path(std::string racy)
 		{
-			return ((float)qnt - (float)zp) * scale;
+			return racy.replace(racy.length() - 4, 4, "rknn");
 		}
 
-		static void NC1HWC2_int8_to_NCHW_float(const int8_t *src, float *dst, int *dims, int channel, int h, int w, int32_t qnt_zps, float &qnt_scales)
+		/// <summary>
+		/// A .rknn file held in memory only while rknn_init reads it. The file is mapped rather than read,
+		/// so loading costs no heap copy; where mmap is unavailable it falls back to load_model.
+		/// </summary>
+		class model_file
 		{
-			int batch = dims[0];
-			int C1 = dims[1];
-			int C2 = dims[4];
-			int hw_src = dims[2] * dims[3];
-			int hw_dst = h * w;
-			for (int i = 0; i < batch; i++)
-			{
-				src = src + i * C1 * hw_src * C2;
-				dst = dst + i * channel * hw_dst;
-				for (int c = 0; c < channel; ++c)
+		public:
+			model_file(const model_file&) = delete;
+			model_file& operator=(const model_file&) = delete;
+
+			explicit model_file(const std::string& path) :data_(nullptr), size_(0), mapped_(false)
+			{
+#if !defined(_WIN32)
+				int fd = open(path.c_str(), O_RDONLY);
+				if (fd >= 0)
 				{
-				int plane = c / C2;
-				const int8_t *src_c = plane * hw_src * C2 + src;
-				int offset = c % C2;
-				for (int cur_h = 0; cur_h < h; ++cur_h)
-					for (int cur_w = 0; cur_w < w; ++cur_w)
+					struct stat st;
+					if (fstat(fd, &st) == 0 && st.st_size > 0)
 					{
-					int cur_hw = cur_h * w + cur_w;
-					dst[c * hw_dst + cur_h * w + cur_w] = deqnt_affine_to_f32(src_c[C2 * cur_hw + offset] , qnt_zps, qnt_scales )  ;
+						// Private and writable so a runtime that patches the buffer gets copy-on-write pages
+						// instead of a fault; untouched pages stay shared with the page cache.
+						void* addr = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+						if (addr != MAP_FAILED)
+						{
+							data_ = static_cast<unsigned char*>(addr);
+							size_ = static_cast<size_t>(st.st_size);
+							mapped_ = true;
+						}
 					}
+					close(fd);
 				}
+				if (mapped_)
+					return;
+#endif
+				int model_size = 0;
+				data_ = load_model(path.c_str(), &model_size);
+				size_ = static_cast<size_t>(model_size);
 			}
-		}
 
-		static void NCHW_int8_to_NCHW_float(const int8_t *src, float *dst, int32_t qnt_zps, float &qnt_scales,int length)
-		{
-			for (int i = 0; i < length; i++)
+			~model_file()
 			{
-				dst[i] = deqnt_affine_to_f32(src[i] , qnt_zps, qnt_scales )  ;
+				release();
 			}
-		}
-
-		static float f16_2_f32(const uint16_t &f16)
-		{
-			uint32_t sign = (f16 >> 15) & 0x1;
-			uint32_t exponent = ((f16 >> 10) & 0x1f) - 15 + 127;
-			uint32_t mantissa = (f16 & 0x3ff) << 13;
-			uint32_t bits = (sign << 31) | (exponent << 23) | mantissa;
-			float f = *((float*) &bits);
-			// std::cout << "float: " << f << std::endl;
-			return f;
-		}
 
-		static void NC1HWC2_f16_to_NCHW_float(const uint16_t *src, float *dst, int *dims, int channel, int h, int w)
-		{
-			int batch = dims[0];
-			int C1 = dims[1];
-			int C2 = dims[4];
-			int hw_src = dims[2] * dims[3];
-			int hw_dst = h * w;
-			for (int i = 0; i < batch; i++)
-			{
-				src = src + i * C1 * hw_src * C2;
-				dst = dst + i * channel * hw_dst;
-				for (int c = 0; c < channel; ++c)
-				{
-				int plane = c / C2;//c2==0
-				const uint16_t *src_c = plane * hw_src * C2 + src;
-				int offset = c % C2;
-				for (int cur_h = 0; cur_h < h; ++cur_h)
-					for (int cur_w = 0; cur_w < w; ++cur_w)
-					{
-					int cur_hw = cur_h * w + cur_w;
-					dst[c * hw_dst + cur_h * w + cur_w] = f16_2_f32( src_c[C2 * cur_hw + offset] )  ;
-					}
-				}
+			void release()
+			{
+				if (data_ == nullptr)
+					return;
+#if !defined(_WIN32)
+				if (mapped_)
+					munmap(data_, size_);
+				else
+#endif
+					free(data_);
+				data_ = nullptr;
+				size_ = 0;
 			}
-		}
 
-		static void tensorf16_2_f32(const uint16_t *source ,float* dst,int length)
-		{
-			for(int i=0;i<length;i++)
+			unsigned char* data() const
 			{
-				dst[i]= f16_2_f32(source[i]);
+				return data_;
 			}
-		}
 
-#endif
+			size_t size() const
+			{
+				return size_;
+			}
 
+		private:
+			unsigned char* data_;
+			size_t size_;
+			bool mapped_;
+		};
 
+		/// <summary>
+		/// A raw int8 output with its affine quantization: real = (q - zp) * scale.
+		/// </summary>
+		struct quantized_tensor
+		{
+			std::shared_ptr<memory::tensor<std::int8_t>> data;
+			int32_t zp;
+			float scale;
+		};
 
 		class rknn_wrapper
 		{
 		public:
 			rknn_wrapper() = delete;
 			rknn_wrapper(uint32_t flag):ctx_(0), flag_(flag){}
-			rknn_wrapper(const std::vector<std::string>& phai, std::string racy, int device = -1, uint32_t flag = 0) :rknn_wrapper(flag)
+			rknn_wrapper(const std::vector<std::string>& phai, std::string racy, int device = -1, uint32_t flag = 0, bool zero_copy_input = false) :rknn_wrapper(flag)
 			{
-				int model_data_size = 0;
-				unsigned char* model_data = load_model(racy.replace(racy.length() - 4, 4, "rknn").c_str(), &model_data_size);
-				
-				int ret = rknn_init(&ctx_, reinterpret_cast<void*>(model_data), model_data_size, flag_, nullptr);
-				free(model_data);
-				model_data = nullptr;
-				if(ret != 0)
-					throw rknn_exception(ret, "rknn_init fail!");
-				
-				ret = rknn_query(ctx_, RKNN_QUERY_IN_OUT_NUM, &io_num_, sizeof(io_num_));
+				model_path_ = resolve_model_path(racy);
+				init_context();
+
+				int ret = rknn_query(ctx_, RKNN_QUERY_IN_OUT_NUM, &io_num_, sizeof(io_num_));
 				if (ret != RKNN_SUCC) 
 				{
 					throw rknn_exception(ret, "rknn_query io_num_ fail!");
@@ -221,15 +231,57 @@ namespace glasssix
 					output_tensor_shape_index_[output_attrs[i].index] = shape;
 					dump_tensor_attr(&(output_attrs[i]));
 				}
+
+#if !defined(BUILD_RV1106)
+				model_batch_ = input_attrs[0].dims[0] > 1 ? static_cast<int>(input_attrs[0].dims[0]) : 1;
+				if (zero_copy_input)
+					bind_input_mem();
+#endif
 			}
-			
+
 			~rknn_wrapper()
 			{
+				stop_submission_thread();
+#if defined(BUILD_RV1106)
+				release_io_binding();
+#else
+				if (input_mem_ != nullptr)
+					rknn_destroy_mem(ctx_, input_mem_);
+#endif
 				int ret = rknn_destroy(ctx_);
 				if(ret != 0)
 					printf("rknn_destroy fail!\n");
 			}
 			
+			// Duplicates the loaded model into a new context that shares the weights of this one, then pins it
+			// to core_mask. Falls back to loading the model file again when rknn_dup_context is unavailable.
+			std::shared_ptr<rknn_wrapper> dup(rknn_core_mask core_mask = RKNN_NPU_CORE_AUTO)
+			{
+				std::shared_ptr<rknn_wrapper> result(new rknn_wrapper(*this, false));
+				result->set_core_mask(core_mask);
+				return result;
+			}
+
+			// Loads the model again into a new context whose weights are the ones already in NPU memory for
+			// this context (RKNN_FLAG_SHARE_WEIGHT_MEM); only the internal buffers are allocated anew.
+			// This wrapper must outlive the returned one.
+			std::shared_ptr<rknn_wrapper> share_weights(rknn_core_mask core_mask = RKNN_NPU_CORE_AUTO)
+			{
+				std::shared_ptr<rknn_wrapper> result(new rknn_wrapper(*this, true));
+				result->set_core_mask(core_mask);
+				return result;
+			}
+
+			void set_core_mask(rknn_core_mask core_mask)
+			{
+				if (core_mask == RKNN_NPU_CORE_AUTO)
+					return;
+
+				int ret = rknn_set_core_mask(ctx_, core_mask);
+				if (ret < 0)
+					printf("rknn_set_core_mask %d fail! ret=%d\n", static_cast<int>(core_mask), ret);
+			}
+
 			std::string version()
 			{
 				rknn_sdk_version version;
@@ -243,35 +295,29 @@ namespace glasssix
 #if defined(BUILD_RV1106) 
 			std::unordered_map<std::string, std::shared_ptr<memory::tensor<float>>> forward(const std::uint8_t* input_data, std::vector<int> data_shape, rknn_tensor_format fmt)
 			{
+				std::lock_guard<std::mutex> lock(run_mutex_);
 				CHECK_EQ(1, io_num_.n_input);
-				int ret_=0;
-				std::unordered_map<std::string, std::shared_ptr<memory::tensor<float>>> result;
 				int size = data_shape[1] * data_shape[2] * data_shape[3]*sizeof(uint8_t);
-				std::vector<std::vector<float>> temp(io_num_.n_output);
-				for (int num_i = 0; num_i < data_shape[0]; num_i++)
-				{
-					rknn_input inputs[1];
-					std::memset(inputs, 0, sizeof(inputs));
-					inputs[0].type = RKNN_TENSOR_UINT8;
-					inputs[0].size = size;
-					inputs[0].fmt = fmt;
 
-					rknn_tensor_mem *input_mems[1];
-					input_mems[0] = rknn_create_mem(ctx_, input_attrs[0].size_with_stride);
+				prepare_io_binding(data_shape, fmt);
+
+				auto& output_tensors = acquire_output_tensors(data_shape[0]);
 
-					int width = input_attrs[0].dims[2];
-  					int stride = input_attrs[0].w_stride;
+				int width = input_attrs[0].dims[2];
+				int stride = input_attrs[0].w_stride;
+				for (int num_i = 0; num_i < data_shape[0]; num_i++)
+				{
+					const uint8_t *src_ptr = input_data + num_i * size;
 					if (width == stride)
 					{
-						memcpy(input_mems[0]->virt_addr, input_data, width * input_attrs[0].dims[1] * input_attrs[0].dims[3]);
+						memcpy(io_binding_.input_mem->virt_addr, src_ptr, width * input_attrs[0].dims[1] * input_attrs[0].dims[3]);
 					}
 					else
 					{
 						int height = input_attrs[0].dims[1];
 						int channel = input_attrs[0].dims[3];
 						// copy from src to dst with stride
-						const uint8_t *src_ptr = input_data;
-						uint8_t *dst_ptr = (uint8_t *)input_mems[0]->virt_addr;
+						uint8_t *dst_ptr = (uint8_t *)io_binding_.input_mem->virt_addr;
 						// width-channel elements
 						int src_wc_elems = width * channel;
 						int dst_wc_elems = stride * channel;
@@ -283,433 +329,645 @@ namespace glasssix
 						}
 					}
 
-					rknn_tensor_attr orig_output_attrs[io_num_.n_output];
-  					memset(orig_output_attrs, 0, io_num_.n_output * sizeof(rknn_tensor_attr));
-					for (uint32_t i = 0; i < io_num_.n_output; i++)
-					{
-						orig_output_attrs[i].index = i;
-						// query info
-						ret_ = rknn_query(ctx_, RKNN_QUERY_NATIVE_OUTPUT_ATTR, &(orig_output_attrs[i]), sizeof(rknn_tensor_attr));
-						if (ret_ != RKNN_SUCC)
-						{
-							printf("rknn_query fail! ret_=%d\n", ret_);
-						}
-						// dump_tensor_attr(&orig_output_attrs[i]); for debug
-					}
-
-
-					rknn_tensor_mem *output_mems[io_num_.n_output];
-
-					for (uint32_t i = 0; i < io_num_.n_output; ++i)
-					{
-						output_mems[i] = rknn_create_mem(ctx_, orig_output_attrs[i].size_with_stride);
-					}
-					ret_ = rknn_set_io_mem(ctx_, input_mems[0], &input_attrs[0]);
-
-					for (uint32_t i = 0; i < io_num_.n_output; ++i)
-					{
-						// set output memory and attribute
-						ret_ = rknn_set_io_mem(ctx_, output_mems[i], &orig_output_attrs[i]);
-						if (ret_ < 0)
-						{
-							printf("rknn_set_io_mem fail! ret_=%d\n", ret_);
-						}
-					}
-					// Run
-					{
-						ret_ = rknn_run(ctx_, NULL);
-						if (ret_ < 0)
-						{
-							printf("rknn run error %d\n", ret_);
-						}
-					}
-					
-					std::vector<float> out_scales;
-					std::vector<int32_t> out_zps;
+					int ret = rknn_run(ctx_, NULL);
+					if (ret < 0)
+						throw rknn_exception(ret, "rknn_run fail!");
 
-					for (int i = 0; i < io_num_.n_output; ++i)
-					{
-                        {
-						    out_scales.push_back(orig_output_attrs[i].scale);
-						    out_zps.push_back(orig_output_attrs[i].zp);
-                        }
-					}
-				
 					for (uint32_t i = 0; i < io_num_.n_output; i++)
 					{
-						std::vector<float> temp(output_attrs[i].n_elems);	
-
-						std::vector<int> temp_shape = output_tensor_shape_index_[i];
-						temp_shape[0] = data_shape[0];
-						auto output_tensor = std::make_shared<memory::tensor<float>>(temp_shape);
-						// int8_t *datas=  (int8_t *)output_mems[i]->virt_addr;
-						// int8_t datas1= ((int8_t *)output_mems[i]->virt_addr)[0];
-						if(orig_output_attrs[i].type==RKNN_TENSOR_INT8)
+						rknn_tensor_attr& native_attr = io_binding_.output_attrs[i];
+						void* virt_addr = io_binding_.output_mems[i]->virt_addr;
+						float* dst = output_tensors[i]->mutable_cpu_data() + num_i * output_attrs[i].n_elems;
+						int channel = output_attrs[i].dims[1];
+						int h = output_attrs[i].n_dims > 2 ? output_attrs[i].dims[2] : 1;
+						int w = output_attrs[i].n_dims > 3 ? output_attrs[i].dims[3] : 1;
+
+						if (native_attr.type == RKNN_TENSOR_INT8)
 						{
-
-							if( orig_output_attrs[i].fmt==RKNN_TENSOR_NC1HWC2 )
-							{
-								int channel = output_attrs[i].dims[1];
-								int h = output_attrs[i].n_dims > 2 ? output_attrs[i].dims[2] : 1;
-								int w = output_attrs[i].n_dims > 3 ? output_attrs[i].dims[3] : 1;
-								int hw = h * w;
-								NC1HWC2_int8_to_NCHW_float((int8_t *)output_mems[i]->virt_addr, output_tensor->mutable_cpu_data(), (int *)orig_output_attrs[i].dims,
-														channel, h, w , out_zps[i] , out_scales[i]);
-							}
+							if (native_attr.fmt == RKNN_TENSOR_NC1HWC2)
+								NC1HWC2_int8_to_NCHW_float((int8_t *)virt_addr, dst, (int *)native_attr.dims, channel, h, w, native_attr.zp, native_attr.scale);
 							else
-							{
-								NCHW_int8_to_NCHW_float((int8_t *)output_mems[i]->virt_addr,output_tensor->mutable_cpu_data() ,out_zps[i] , out_scales[i],output_attrs[i].n_elems );								
-							}
+								int8_to_f32((int8_t *)virt_addr, dst, output_attrs[i].n_elems, native_attr.zp, native_attr.scale);
 						}
-						
-						if(orig_output_attrs[i].type==RKNN_TENSOR_FLOAT16)
+
+						if (native_attr.type == RKNN_TENSOR_FLOAT16)
 						{
-							if( orig_output_attrs[i].fmt==RKNN_TENSOR_NC1HWC2 )
-							{
-								int channel = output_attrs[i].dims[1];
-								int h = output_attrs[i].n_dims > 2 ? output_attrs[i].dims[2] : 1;
-								int w = output_attrs[i].n_dims > 3 ? output_attrs[i].dims[3] : 1;
-								int hw = h * w;
-								NC1HWC2_f16_to_NCHW_float((uint16_t *)output_mems[i]->virt_addr, output_tensor->mutable_cpu_data(), 
-															(int *)orig_output_attrs[i].dims, channel, h, w );
-							}
+							if (native_attr.fmt == RKNN_TENSOR_NC1HWC2)
+								NC1HWC2_f16_to_NCHW_float((uint16_t *)virt_addr, dst, (int *)native_attr.dims, channel, h, w);
 							else
-							{					
-								tensorf16_2_f32((uint16_t *)output_mems[i]->virt_addr ,output_tensor->mutable_cpu_data() , output_attrs[i].n_elems);
-							}								
+								f16_to_f32((uint16_t *)virt_addr, dst, output_attrs[i].n_elems);
 						}
-						// float *data= output_tensor->mutable_cpu_data();
-						// std::cout<<" "<<output_name_index_[i]<<std::endl;
-						result[output_name_index_[i]] = output_tensor;
-						// int m=10;
-					}
-
-					rknn_destroy_mem(ctx_, input_mems[0]);
-					for (uint32_t i = 0; i < io_num_.n_output; ++i)
-					{
-						rknn_destroy_mem(ctx_, output_mems[i]);
 					}
 				}
-				return result;
+				return make_result(output_tensors);
+			}
+
+#else
+			bool zero_copy_input() const
+			{
+				return input_mem_ != nullptr;
+			}
+
+			// Writable HWC view of the NPU-visible input memory (zero-copy mode only).
+			// Rows are w_stride pixels apart; forward() skips the copy when handed this view back.
+			// Do not write into it while forward_async() calls are pending: their runs read the same memory.
+			cv::Mat input_view()
+			{
+				if (input_mem_ == nullptr)
+					throw rknn_exception(RKNN_ERR_CTX_INVALID, "zero-copy input is not enabled!");
+
+				return cv::Mat(input_height_, input_width_, CV_8UC(input_channels_), input_mem_->virt_addr, static_cast<size_t>(input_stride_) * input_channels_);
 			}
 
-#else		
+			// Ownership of results, for every forward overload, forward_async and forward_quantized: the returned
+			// tensors come from the wrapper's output cache and stay valid for as long as the caller references
+			// them, since the wrapper never writes into a referenced tensor. Drop the map and any copies of its
+			// tensors once the outputs are decoded, so that the next call reuses their memory; results kept
+			// across frames make later calls allocate new tensors.
 			std::unordered_map<std::string, std::shared_ptr<memory::tensor<float>>> forward(cv::Mat& image, rknn_tensor_format fmt = rknn_tensor_format::RKNN_TENSOR_NHWC)
 			{
+				std::lock_guard<std::mutex> lock(run_mutex_);
 				//input_data
 				CHECK_EQ(1, io_num_.n_input);
 				int size = image.channels() * image.rows * image.cols *sizeof(uint8_t);
-				std::vector<std::vector<float>> temp(io_num_.n_output);
-				for (int num_i = 0; num_i < 1; num_i++)
-				{
-					rknn_input inputs[1];
-					std::memset(inputs, 0, sizeof(inputs));
-					inputs[0].index = 0;
-					inputs[0].type = RKNN_TENSOR_UINT8;
-					inputs[0].size = size;
-					inputs[0].fmt = fmt;
-					inputs[0].buf = const_cast<std::uint8_t*>(image.data);
+				auto& output_tensors = acquire_output_tensors(1);
 
-					int ret = rknn_inputs_set(ctx_, io_num_.n_input, inputs);
-					if (ret < 0)
-						throw rknn_exception(ret, "rknn_input_set fail!");
-					
-					ret = rknn_run(ctx_, nullptr);
-					if (ret < 0)
-						throw rknn_exception(ret, "rknn_run fail!");
+				set_uint8_input(image.data, 1, image.rows, image.cols, image.channels(), image.step, size, fmt);
+				run_into(output_tensors, 0, 1);
 
-					rknn_output outputs[io_num_.n_output];
-					std::memset(outputs, 0, sizeof(outputs));
-					for (size_t i = 0; i < io_num_.n_output; i++)
-						outputs[i].want_float = 1;
+				return make_result(output_tensors);
+			}
 
-					ret = rknn_outputs_get(ctx_, io_num_.n_output, outputs, NULL);
-					if (ret < 0)
-						throw rknn_exception(ret, "rknn_outputs_get fail!");
-					
+			// Queues image on the submission thread and returns at once, so the caller can prepare the next
+			// frame while the NPU runs this one. image is copied into one of two staging buffers; a third
+			// call waits until the older of the two frames in flight has finished. The wrapper keeps each future,
+			// and with it the result's tensors, until its slot is reused two calls later.
+			// forward_async() itself is called from one thread at a time. The blocking forward() overloads may be
+			// called meanwhile: every run takes run_mutex_, so they queue behind the frames already submitted.
+			std::shared_future<std::unordered_map<std::string, std::shared_ptr<memory::tensor<float>>>> forward_async(const cv::Mat& image, rknn_tensor_format fmt = rknn_tensor_format::RKNN_TENSOR_NHWC)
+			{
+				using result_type = std::unordered_map<std::string, std::shared_ptr<memory::tensor<float>>>;
 
-					for (size_t i = 0; i < io_num_.n_output; i++)
-						temp[outputs[i].index].insert(temp[outputs[i].index].end(), reinterpret_cast<float*>(outputs[i].buf), reinterpret_cast<float*>(outputs[i].buf) + outputs[i].size / sizeof(float));
-					
-					rknn_outputs_release(ctx_, io_num_.n_output, outputs);
-				}
+				start_submission_thread();
 
-				std::unordered_map<std::string, std::shared_ptr<memory::tensor<float>>> result;
+				std::size_t slot = async_slot_;
+				async_slot_ = (async_slot_ + 1) % 2;
+				if (async_results_[slot].valid())
+					async_results_[slot].wait();
+
+				image.copyTo(async_inputs_[slot]);
+				auto task = std::make_shared<std::packaged_task<result_type()>>([this, slot, fmt]() {
+					return forward(async_inputs_[slot], fmt);
+					});
+				async_results_[slot] = task->get_future().share();
+				submission_queue_->enqueue([task]() { (*task)(); });
 
-				for (size_t index = 0; index < io_num_.n_output; index++)
+				return async_results_[slot];
+			}
+
+			// Runs the model and hands back the int8 outputs as the NPU produced them, with the zp/scale of
+			// each output attached, so the caller only dequantizes the elements it actually reads.
+			std::unordered_map<std::string, quantized_tensor> forward_quantized(cv::Mat& image, rknn_tensor_format fmt = rknn_tensor_format::RKNN_TENSOR_NHWC)
+			{
+				std::lock_guard<std::mutex> lock(run_mutex_);
+				CHECK_EQ(1, io_num_.n_input);
+				if (model_batch_ != 1)
+					throw rknn_exception(RKNN_ERR_MODEL_INVALID, "forward_quantized only supports batch-1 models!");
+
+				for (uint32_t i = 0; i < io_num_.n_output; i++)
+					if (output_attrs[i].type != RKNN_TENSOR_INT8)
+						throw rknn_exception(RKNN_ERR_OUTPUT_INVALID, fmt::format("output {} is {}, not INT8!", output_attrs[i].name, get_type_string(output_attrs[i].type)).c_str());
+
+				int size = image.channels() * image.rows * image.cols * sizeof(uint8_t);
+				set_uint8_input(image.data, 1, image.rows, image.cols, image.channels(), image.step, size, fmt);
+
+				int ret = rknn_run(ctx_, nullptr);
+				if (ret < 0)
+					throw rknn_exception(ret, "rknn_run fail!");
+
+				auto& output_tensors = acquire_cached_tensors(quantized_output_cache_, 1);
+
+				std::unordered_map<std::string, quantized_tensor> result;
+				rknn_output outputs[io_num_.n_output];
+				std::memset(outputs, 0, sizeof(outputs));
+				for (uint32_t i = 0; i < io_num_.n_output; i++)
 				{
-					std::vector<int> temp_shape = output_tensor_shape_index_[index];
-					temp_shape[0] = 1;
-					auto output_tensor = std::make_shared<memory::tensor<float>>(temp_shape);
-					std::copy(temp[index].begin(), temp[index].end(), output_tensor->mutable_cpu_data());
-					result[output_name_index_[index]] = output_tensor;
+					auto& output_tensor = output_tensors[i];
+					outputs[i].index = i;
+					outputs[i].want_float = 0;
+					outputs[i].is_prealloc = 1;
+					outputs[i].buf = output_tensor->mutable_cpu_data();
+					outputs[i].size = output_attrs[i].n_elems * sizeof(std::int8_t);
+
+					result[output_name_index_[i]] = quantized_tensor{ output_tensor, output_attrs[i].zp, output_attrs[i].scale };
 				}
-				
+
+				ret = rknn_outputs_get(ctx_, io_num_.n_output, outputs, NULL);
+				if (ret < 0)
+					throw rknn_exception(ret, "rknn_outputs_get fail!");
+
+				rknn_outputs_release(ctx_, io_num_.n_output, outputs);
 				return result;
 			}
 
 			std::unordered_map<std::string, std::shared_ptr<memory::tensor<float>>> forward(const std::shared_ptr<memory::tensor<std::uint8_t>>& input_tensor)
 			{
+				std::lock_guard<std::mutex> lock(run_mutex_);
 				CHECK_EQ(1, io_num_.n_input);
 				
 				int num = input_tensor->num();
 				int size = input_tensor->count(1, 4);
+				auto& output_tensors = acquire_output_tensors(num);
 				
-				std::vector<std::vector<float>> temp(io_num_.n_output);
-				for(int num_i = 0; num_i < num; num_i++)
+				for (int first = 0; first < num; first += model_batch_)
 				{
-					
-					rknn_input inputs[1];
-					std::memset(inputs, 0, sizeof(inputs));
-					inputs[0].index = 0;
-					inputs[0].type = RKNN_TENSOR_UINT8;
-					inputs[0].size = size;
-					inputs[0].fmt = static_cast<rknn_tensor_format>(input_tensor->order());
-					inputs[0].buf = const_cast<std::uint8_t *>(input_tensor->cpu_data() + num_i * size);
-
-					int ret = rknn_inputs_set(ctx_, io_num_.n_input, inputs);
-					if(ret < 0) 
-					{
-						throw rknn_exception(ret, "rknn_input_set fail!");
-					}
-					
-					ret = rknn_run(ctx_, nullptr);
-					if(ret < 0) 
-					{
-						throw rknn_exception(ret, "rknn_run fail!");
-					}
-					
-					rknn_output outputs[io_num_.n_output];
-					std::memset(outputs, 0, sizeof(outputs));
-					for(size_t i = 0; i < io_num_.n_output; i++)
-						outputs[i].want_float = 1;
-					
-					ret = rknn_outputs_get(ctx_, io_num_.n_output, outputs, NULL);
-					if(ret < 0) 
-					{
-						throw rknn_exception(ret, "rknn_outputs_get fail!");
-					}
-					
-					for(size_t i = 0; i < io_num_.n_output; i++)
-					{
-						temp[outputs[i].index].insert(temp[outputs[i].index].end(), reinterpret_cast<float *>(outputs[i].buf), reinterpret_cast<float*>(outputs[i].buf) + outputs[i].size / sizeof(float));
-					}
-					
-					rknn_outputs_release(ctx_, io_num_.n_output, outputs);
+					int count = std::min(model_batch_, num - first);
+					set_uint8_input(input_tensor->cpu_data() + static_cast<size_t>(first) * size, count, input_tensor->height(), input_tensor->width(), input_tensor->channels(),
+						static_cast<size_t>(input_tensor->width()) * input_tensor->channels(), size, static_cast<rknn_tensor_format>(input_tensor->order()));
+					run_into(output_tensors, first, count);
 				}
 				
-				std::unordered_map<std::string, std::shared_ptr<memory::tensor<float>>> result;
-				for (size_t index = 0; index < io_num_.n_output; index++)
-				{
-					std::vector<int> temp_shape = output_tensor_shape_index_[index];
-					temp_shape[0] = num;
-
-					auto output_tensor = std::make_shared<memory::tensor<float>>(temp_shape);
-
-					std::copy(temp[index].begin(), temp[index].end(), output_tensor->mutable_cpu_data());
-					result[output_name_index_[index]] = output_tensor;
-				}
-				return result;
+				return make_result(output_tensors);
 			}
 	
 			std::unordered_map<std::string, std::shared_ptr<memory::tensor<float>>> forward(const std::uint8_t* input_data, std::vector<int> data_shape, rknn_tensor_format fmt)
 			{
+				std::lock_guard<std::mutex> lock(run_mutex_);
 				CHECK_EQ(1, io_num_.n_input);
 
 				int size = data_shape[1] * data_shape[2] * data_shape[3]*sizeof(uint8_t);
-				// std::cout<<"pic size"<<size<<"\n";
-				std::vector<std::vector<float>> temp(io_num_.n_output);
-				for (int num_i = 0; num_i < data_shape[0]; num_i++)
+				auto& output_tensors = acquire_output_tensors(data_shape[0]);
+
+				for (int first = 0; first < data_shape[0]; first += model_batch_)
 				{
+					int count = std::min(model_batch_, data_shape[0] - first);
+					set_uint8_input(input_data + static_cast<size_t>(first) * size, count, data_shape[1], data_shape[2], data_shape[3], static_cast<size_t>(data_shape[2]) * data_shape[3], size, fmt);
+					run_into(output_tensors, first, count);
+				}
+
+				return make_result(output_tensors);
+			}
+			
+			void forward(const std::uint8_t* input_data, std::vector<int> data_shape, rknn_tensor_format fmt,int i)
+			{
+				forward(input_data, data_shape, fmt);
+			}
+			
+
+			std::unordered_map<std::string, std::shared_ptr<memory::tensor<float>>> forward(const float* input_data, std::vector<int> data_shape, rknn_tensor_format fmt)
+			{
+				std::lock_guard<std::mutex> lock(run_mutex_);
+				CHECK_EQ(1, io_num_.n_input);
+
+				int count = data_shape[1] * data_shape[2] * data_shape[3];
+				int size = count * sizeof(float);
+				auto& output_tensors = acquire_output_tensors(data_shape[0]);
+
+				for (int first = 0; first < data_shape[0]; first += model_batch_)
+				{
+					int batch_count = std::min(model_batch_, data_shape[0] - first);
+					const float* batch_data = input_data + static_cast<size_t>(first) * count;
+					if (batch_count < model_batch_)
+					{
+						float_input_staging_.assign(static_cast<size_t>(model_batch_) * count, 0.f);
+						std::copy(batch_data, batch_data + static_cast<size_t>(batch_count) * count, float_input_staging_.begin());
+						batch_data = float_input_staging_.data();
+					}
+
 					rknn_input inputs[1];
 					std::memset(inputs, 0, sizeof(inputs));
 					inputs[0].index = 0;
-					inputs[0].type = RKNN_TENSOR_UINT8;
-					inputs[0].size = size;
+					inputs[0].type = RKNN_TENSOR_FLOAT32;
+					inputs[0].size = size * model_batch_;
 					inputs[0].fmt = fmt;
-					inputs[0].buf = const_cast<std::uint8_t*>(input_data + num_i * size);
+					inputs[0].buf = const_cast<float*>(batch_data);
 
 					int ret = rknn_inputs_set(ctx_, io_num_.n_input, inputs);
 					if (ret < 0)
 					{
 						throw rknn_exception(ret, "rknn_input_set fail!");
 					}
-					ret = rknn_run(ctx_, nullptr);
-					if (ret < 0)
-					{
-						throw rknn_exception(ret, "rknn_run fail!");
-					}
+					run_into(output_tensors, first, batch_count);
+				}
+
+				return make_result(output_tensors);
+			}
+#endif		
+		private:
+			rknn_context ctx_;
+			uint32_t flag_;
+			std::string model_path_;
+			rknn_input_output_num io_num_;
+			std::vector<rknn_tensor_attr> input_attrs;
+			std::vector<rknn_tensor_attr> output_attrs;
+			std::unordered_map<int, std::string> output_name_index_;
+			std::unordered_map<int, std::vector<int>> output_tensor_shape_index_;
 
-					rknn_output outputs[io_num_.n_output];
-					std::memset(outputs, 0, sizeof(outputs));
-					for (size_t i = 0; i < io_num_.n_output; i++)
-						outputs[i].want_float = 1;
+			// Held by every forward overload and forward_quantized() for the whole call, including the ones
+			// forward_async() queues on the submission thread: the context, its bound memory and the output caches
+			// are used by one call at a time.
+			std::mutex run_mutex_;
 
-					ret = rknn_outputs_get(ctx_, io_num_.n_output, outputs, NULL);
-					if (ret < 0)
-					{
-						throw rknn_exception(ret, "rknn_outputs_get fail!");
-					}
+			// Output tensors cached across calls, float for forward() and int8 for forward_quantized(). Each cache
+			// keeps up to output_cache_sets sets of tensors, one tensor per output. A set is handed out again once
+			// every reference to it has been dropped, by callers and by the futures held for forward_async(), so a
+			// caller keeping one result while both asynchronous slots hold theirs still allocates nothing. When
+			// every set is referenced, the cache drops its reference to one of them in turn and allocates a new set.
+			static constexpr std::size_t output_cache_sets = 3;
+
+			template <typename T>
+			struct output_cache
+			{
+				std::vector<std::vector<std::shared_ptr<memory::tensor<T>>>> sets;
+				std::size_t next_replaced = 0;
+			};
 
-					for (size_t i = 0; i < io_num_.n_output; i++)
+			output_cache<float> output_cache_;
+			output_cache<std::int8_t> quantized_output_cache_;
+
+			std::vector<std::shared_ptr<memory::tensor<float>>>& acquire_output_tensors(int num)
+			{
+				return acquire_cached_tensors(output_cache_, num);
+			}
+
+			template <typename T>
+			std::vector<std::shared_ptr<memory::tensor<T>>>& acquire_cached_tensors(output_cache<T>& cache, int num)
+			{
+				// An unreferenced set of the right batch size is reused as is; one of another size is reallocated first
+				std::vector<std::shared_ptr<memory::tensor<T>>>* replaced = nullptr;
+				for (auto& set : cache.sets)
+				{
+					bool unreferenced = true;
+					bool same_num = set.size() == io_num_.n_output;
+					for (std::size_t i = 0; i < set.size(); i++)
 					{
-						temp[outputs[i].index].insert(temp[outputs[i].index].end(), reinterpret_cast<float*>(outputs[i].buf), reinterpret_cast<float*>(outputs[i].buf) + outputs[i].size / sizeof(float));
+						unreferenced = unreferenced && set[i].use_count() == 1;
+						same_num = same_num && set[i]->num() == num;
 					}
+					if (unreferenced && same_num)
+						return set;
+					if (unreferenced && replaced == nullptr)
+						replaced = &set;
+				}
 
-					rknn_outputs_release(ctx_, io_num_.n_output, outputs);
+				if (replaced == nullptr && cache.sets.size() < output_cache_sets)
+				{
+					cache.sets.reserve(output_cache_sets);
+					cache.sets.emplace_back();
+					replaced = &cache.sets.back();
+				}
+				else if (replaced == nullptr)
+				{
+					replaced = &cache.sets[cache.next_replaced];
+					cache.next_replaced = (cache.next_replaced + 1) % output_cache_sets;
 				}
 
+				replaced->resize(io_num_.n_output);
+				for (uint32_t i = 0; i < io_num_.n_output; i++)
+				{
+					std::vector<int> temp_shape = output_tensor_shape_index_[i];
+					temp_shape[0] = num;
+					(*replaced)[i] = std::make_shared<memory::tensor<T>>(temp_shape);
+				}
+				return *replaced;
+			}
+
+			std::unordered_map<std::string, std::shared_ptr<memory::tensor<float>>> make_result(const std::vector<std::shared_ptr<memory::tensor<float>>>& output_tensors)
+			{
 				std::unordered_map<std::string, std::shared_ptr<memory::tensor<float>>> result;
+				for (uint32_t i = 0; i < io_num_.n_output; i++)
+					result[output_name_index_[i]] = output_tensors[i];
+				return result;
+			}
 
-				for (size_t index = 0; index < io_num_.n_output; index++)
+			// Used by dup() and share_weights(): the tensor attributes are copied, the context is duplicated
+			// or initialized on the weights of the parent.
+			rknn_wrapper(rknn_wrapper& parent, bool share_weight_mem) :ctx_(0), flag_(parent.flag_), model_path_(parent.model_path_), io_num_(parent.io_num_), input_attrs(parent.input_attrs),
+				output_attrs(parent.output_attrs), output_name_index_(parent.output_name_index_), output_tensor_shape_index_(parent.output_tensor_shape_index_)
+			{
+				if (share_weight_mem)
 				{
-					std::vector<int> temp_shape = output_tensor_shape_index_[index];
-					temp_shape[0] = data_shape[0];
+					init_context(parent.ctx_);
+				}
+				else
+				{
+					int ret = rknn_dup_context(&parent.ctx_, &ctx_);
+					if (ret != RKNN_SUCC)
+					{
+						printf("rknn_dup_context fail! ret=%d, reload %s\n", ret, model_path_.c_str());
+						init_context();
+					}
+				}
 
-					auto output_tensor = std::make_shared<memory::tensor<float>>(temp_shape);
+#if !defined(BUILD_RV1106)
+				model_batch_ = parent.model_batch_;
+				if (parent.input_mem_ != nullptr)
+					bind_input_mem();
+#endif
+			}
 
-					std::copy(temp[index].begin(), temp[index].end(), output_tensor->mutable_cpu_data());
-					result[output_name_index_[index]] = output_tensor;
+			// weight_source, when set, is a live context of the same model whose weight memory is reused.
+			void init_context(rknn_context weight_source = 0)
+			{
+				model_file model(model_path_);
+				if (model.data() == nullptr)
+					throw rknn_exception(RKNN_ERR_MODEL_INVALID, fmt::format("load model {} fail!", model_path_).c_str());
+
+				uint32_t flag = flag_;
+				rknn_init_extend extend;
+				std::memset(&extend, 0, sizeof(extend));
+				if (weight_source != 0)
+				{
+					flag |= RKNN_FLAG_SHARE_WEIGHT_MEM;
+					extend.ctx = weight_source;
 				}
-				
-				return result;
+
+				int ret = rknn_init(&ctx_, model.data(), static_cast<uint32_t>(model.size()), flag, weight_source != 0 ? &extend : nullptr);
+				model.release();
+				if(ret != 0)
+					throw rknn_exception(ret, "rknn_init fail!");
 			}
-			
-			void forward(const std::uint8_t* input_data, std::vector<int> data_shape, rknn_tensor_format fmt,int i)
+#if defined(BUILD_RV1106)
+			// Input/output memory bound to ctx_, kept for the lifetime of the wrapper.
+			struct io_binding
 			{
-				CHECK_EQ(1, io_num_.n_input);
+				rknn_tensor_mem* input_mem = nullptr;
+				rknn_tensor_attr input_attr;
+				std::vector<rknn_tensor_mem*> output_mems;
+				std::vector<rknn_tensor_attr> output_attrs; // native layout, carries zp/scale
+				std::vector<int> input_shape;
+				rknn_tensor_format input_fmt = RKNN_TENSOR_NHWC;
+			};
+			io_binding io_binding_;
+
+			// Builds the binding on first use and only rebuilds it when the input shape or format changes.
+			void prepare_io_binding(const std::vector<int>& data_shape, rknn_tensor_format fmt)
+			{
+				std::vector<int> input_shape(data_shape.begin() + 1, data_shape.end());
+				if (io_binding_.input_mem != nullptr && io_binding_.input_shape == input_shape && io_binding_.input_fmt == fmt)
+					return;
 
-				int size = data_shape[1] * data_shape[2] * data_shape[3]*sizeof(uint8_t);
-				// std::cout<<"pic size"<<size<<"\n";
-				std::vector<std::vector<float>> temp(io_num_.n_output);
-				for (int num_i = 0; num_i < data_shape[0]; num_i++)
-				{
-					rknn_input inputs[1];
-					std::memset(inputs, 0, sizeof(inputs));
-					inputs[0].index = 0;
-					inputs[0].type = RKNN_TENSOR_UINT8;
-					inputs[0].size = size;
-					inputs[0].fmt = fmt;
-					inputs[0].buf = const_cast<std::uint8_t*>(input_data + num_i * size);
+				release_io_binding();
 
-					int ret = rknn_inputs_set(ctx_, io_num_.n_input, inputs);
-					if (ret < 0)
-					{
-						throw rknn_exception(ret, "rknn_input_set fail!");
-					}
-					ret = rknn_run(ctx_, nullptr);
-					if (ret < 0)
-					{
-						throw rknn_exception(ret, "rknn_run fail!");
-					}
+				io_binding_.input_attr = input_attrs[0];
+				io_binding_.input_attr.type = RKNN_TENSOR_UINT8;
+				io_binding_.input_attr.fmt = fmt;
+				io_binding_.input_mem = rknn_create_mem(ctx_, io_binding_.input_attr.size_with_stride);
+				if (io_binding_.input_mem == nullptr)
+					throw rknn_exception(RKNN_ERR_MALLOC_FAIL, "rknn_create_mem input fail!");
 
-					rknn_output outputs[io_num_.n_output];
-					std::memset(outputs, 0, sizeof(outputs));
-					for (size_t i = 0; i < io_num_.n_output; i++)
-						outputs[i].want_float = 1;
+				int ret = rknn_set_io_mem(ctx_, io_binding_.input_mem, &io_binding_.input_attr);
+				if (ret < 0)
+					throw rknn_exception(ret, "rknn_set_io_mem input fail!");
 
-					ret = rknn_outputs_get(ctx_, io_num_.n_output, outputs, NULL);
+				io_binding_.output_attrs.resize(io_num_.n_output);
+				std::memset(io_binding_.output_attrs.data(), 0, io_num_.n_output * sizeof(rknn_tensor_attr));
+				io_binding_.output_mems.assign(io_num_.n_output, nullptr);
+				for (uint32_t i = 0; i < io_num_.n_output; i++)
+				{
+					io_binding_.output_attrs[i].index = i;
+					ret = rknn_query(ctx_, RKNN_QUERY_NATIVE_OUTPUT_ATTR, &(io_binding_.output_attrs[i]), sizeof(rknn_tensor_attr));
+					if (ret != RKNN_SUCC)
+						throw rknn_exception(ret, "rknn_query native output_attrs fail!");
+
+					io_binding_.output_mems[i] = rknn_create_mem(ctx_, io_binding_.output_attrs[i].size_with_stride);
+					if (io_binding_.output_mems[i] == nullptr)
+						throw rknn_exception(RKNN_ERR_MALLOC_FAIL, "rknn_create_mem output fail!");
+
+					ret = rknn_set_io_mem(ctx_, io_binding_.output_mems[i], &(io_binding_.output_attrs[i]));
 					if (ret < 0)
-					{
-						throw rknn_exception(ret, "rknn_outputs_get fail!");
-					}
+						throw rknn_exception(ret, "rknn_set_io_mem output fail!");
+				}
 
-					for (size_t i = 0; i < io_num_.n_output; i++)
-					{
-						temp[outputs[i].index].insert(temp[outputs[i].index].end(), reinterpret_cast<float*>(outputs[i].buf), reinterpret_cast<float*>(outputs[i].buf) + outputs[i].size / sizeof(float));
-					}
+				io_binding_.input_shape = std::move(input_shape);
+				io_binding_.input_fmt = fmt;
+			}
 
-					rknn_outputs_release(ctx_, io_num_.n_output, outputs);
+			void release_io_binding()
+			{
+				if (io_binding_.input_mem != nullptr)
+					rknn_destroy_mem(ctx_, io_binding_.input_mem);
+				io_binding_.input_mem = nullptr;
+
+				for (auto output_mem : io_binding_.output_mems)
+					if (output_mem != nullptr)
+						rknn_destroy_mem(ctx_, output_mem);
+				io_binding_.output_mems.clear();
+				io_binding_.input_shape.clear();
+			}
+#else
+			// Samples per rknn_run, from dims[0] of the model input. Short batches are zero-padded.
+			int model_batch_ = 1;
+			std::vector<std::uint8_t> input_staging_;
+			std::vector<float> float_input_staging_;
+			std::vector<std::vector<float>> output_staging_;
+
+			rknn_tensor_mem* input_mem_ = nullptr;
+			rknn_tensor_attr input_mem_attr_;
+			int input_height_ = 0;
+			int input_width_ = 0;
+			int input_channels_ = 0;
+			int input_stride_ = 0;
+
+			// Creates the NPU input memory once and binds it to the context, so later runs read the
+			// frame from it instead of having rknn_inputs_set copy the host buffer on every call.
+			void bind_input_mem()
+			{
+				CHECK_EQ(1, io_num_.n_input);
+				input_mem_attr_ = input_attrs[0];
+				if (input_mem_attr_.fmt == RKNN_TENSOR_NCHW)
+				{
+					input_channels_ = input_mem_attr_.dims[1];
+					input_height_ = input_mem_attr_.dims[2];
+					input_width_ = input_mem_attr_.dims[3];
+				}
+				else
+				{
+					input_height_ = input_mem_attr_.dims[1];
+					input_width_ = input_mem_attr_.dims[2];
+					input_channels_ = input_mem_attr_.dims[3];
 				}
+				input_stride_ = input_mem_attr_.w_stride == 0 ? input_width_ : input_mem_attr_.w_stride;
 
-				// std::unordered_map<std::string, std::shared_ptr<memory::tensor<float>>> result;
+				input_mem_attr_.type = RKNN_TENSOR_UINT8;
+				input_mem_attr_.fmt = RKNN_TENSOR_NHWC;
+				input_mem_attr_.pass_through = 0;
 
-				// for (size_t index = 0; index < io_num_.n_output; index++)
-				// {
-				// 	std::vector<int> temp_shape = output_tensor_shape_index_[index];
-				// 	temp_shape[0] = data_shape[0];
+				uint32_t mem_size = input_mem_attr_.size_with_stride;
+				if (mem_size == 0)
+					mem_size = static_cast<uint32_t>(model_batch_) * input_height_ * input_stride_ * input_channels_;
 
-				// 	auto output_tensor = std::make_shared<memory::tensor<float>>(temp_shape);
+				input_mem_ = rknn_create_mem(ctx_, mem_size);
+				if (input_mem_ == nullptr)
+					throw rknn_exception(RKNN_ERR_MALLOC_FAIL, "rknn_create_mem input fail!");
 
-				// 	std::copy(temp[index].begin(), temp[index].end(), output_tensor->mutable_cpu_data());
-				// 	result[output_name_index_[index]] = output_tensor;
-				// }
-				
-			
+				int ret = rknn_set_io_mem(ctx_, input_mem_, &input_mem_attr_);
+				if (ret < 0)
+				{
+					rknn_destroy_mem(ctx_, input_mem_);
+					input_mem_ = nullptr;
+					throw rknn_exception(ret, "rknn_set_io_mem input fail!");
+				}
 			}
-			
 
-			std::unordered_map<std::string, std::shared_ptr<memory::tensor<float>>> forward(const float* input_data, std::vector<int> data_shape, rknn_tensor_format fmt)
+			// Runs the batch already fed to the context; rknn_outputs_get writes the float results straight
+			// into the output tensors at samples [first, first + count). A batch padded past count is
+			// fetched into output_staging_ instead and only its real samples are copied out.
+			void run_into(std::vector<std::shared_ptr<memory::tensor<float>>>& output_tensors, int first, int count)
 			{
-				CHECK_EQ(1, io_num_.n_input);
+				int ret = rknn_run(ctx_, nullptr);
+				if (ret < 0)
+					throw rknn_exception(ret, "rknn_run fail!");
 
-				int size = data_shape[1] * data_shape[2] * data_shape[3]*sizeof(float);
-				// std::cout<<"pic size"<<size<<"\n";
-				std::vector<std::vector<float>> temp(io_num_.n_output);
-				for (int num_i = 0; num_i < data_shape[0]; num_i++)
-				{
-					rknn_input inputs[1];
-					std::memset(inputs, 0, sizeof(inputs));
-					inputs[0].index = 0;
-					inputs[0].type = RKNN_TENSOR_FLOAT32;
-					inputs[0].size = size;
-					inputs[0].fmt = fmt;
-					inputs[0].buf = const_cast<float*>(input_data + num_i * size);
+				bool padded = count < model_batch_;
+				if (padded)
+					output_staging_.resize(io_num_.n_output);
 
-					int ret = rknn_inputs_set(ctx_, io_num_.n_input, inputs);
-					if (ret < 0)
+				rknn_output outputs[io_num_.n_output];
+				std::memset(outputs, 0, sizeof(outputs));
+				for (uint32_t i = 0; i < io_num_.n_output; i++)
+				{
+					size_t sample_elems = output_attrs[i].n_elems / model_batch_;
+					float* dst = output_tensors[i]->mutable_cpu_data() + static_cast<size_t>(first) * sample_elems;
+					if (padded)
 					{
-						throw rknn_exception(ret, "rknn_input_set fail!");
+						output_staging_[i].resize(output_attrs[i].n_elems);
+						dst = output_staging_[i].data();
 					}
-					ret = rknn_run(ctx_, nullptr);
-					if (ret < 0)
+
+					outputs[i].index = i;
+					outputs[i].want_float = 1;
+					outputs[i].is_prealloc = 1;
+					outputs[i].buf = dst;
+					outputs[i].size = output_attrs[i].n_elems * sizeof(float);
+				}
+
+				ret = rknn_outputs_get(ctx_, io_num_.n_output, outputs, NULL);
+				if (ret < 0)
+					throw rknn_exception(ret, "rknn_outputs_get fail!");
+
+				rknn_outputs_release(ctx_, io_num_.n_output, outputs);
+
+				if (padded)
+				{
+					for (uint32_t i = 0; i < io_num_.n_output; i++)
 					{
-						throw rknn_exception(ret, "rknn_run fail!");
+						size_t sample_elems = output_attrs[i].n_elems / model_batch_;
+						std::copy(output_staging_[i].begin(), output_staging_[i].begin() + count * sample_elems,
+							output_tensors[i]->mutable_cpu_data() + static_cast<size_t>(first) * sample_elems);
 					}
+				}
+			}
 
-					rknn_output outputs[io_num_.n_output];
-					std::memset(outputs, 0, sizeof(outputs));
-					for (size_t i = 0; i < io_num_.n_output; i++)
-						outputs[i].want_float = 1;
+			// Double-buffered staging for forward_async() and the thread that submits it.
+			cv::Mat async_inputs_[2];
+			std::shared_future<std::unordered_map<std::string, std::shared_ptr<memory::tensor<float>>>> async_results_[2];
+			std::size_t async_slot_ = 0;
+#endif
+			std::unique_ptr<memory::bounded_blocking_queue<std::function<void()>>> submission_queue_;
+			std::thread submission_thread_;
 
-					ret = rknn_outputs_get(ctx_, io_num_.n_output, outputs, NULL);
-					if (ret < 0)
+			void start_submission_thread()
+			{
+				if (submission_thread_.joinable())
+					return;
+
+				submission_queue_ = std::make_unique<memory::bounded_blocking_queue<std::function<void()>>>(2);
+				submission_thread_ = std::thread([this]() {
+					std::function<void()> task;
+					while (true)
 					{
-						throw rknn_exception(ret, "rknn_outputs_get fail!");
+						submission_queue_->dequeue(task);
+						if (!task)
+							break;
+						task();
 					}
+					});
+			}
 
-					for (size_t i = 0; i < io_num_.n_output; i++)
+			// An empty task tells the submission thread to exit once the queued frames are done.
+			void stop_submission_thread()
+			{
+				if (!submission_thread_.joinable())
+					return;
+
+				submission_queue_->enqueue(std::function<void()>{});
+				submission_thread_.join();
+			}
+#if !defined(BUILD_RV1106)
+
+			// Feeds count uint8 samples, size bytes apart, as one model batch, through the bound input memory
+			// when zero-copy is enabled. A short batch is zero-padded up to model_batch_ on both paths.
+			void set_uint8_input(const std::uint8_t* data, int count, int rows, int cols, int channels, size_t step, int size, rknn_tensor_format fmt)
+			{
+				if (input_mem_ != nullptr && fmt == RKNN_TENSOR_NHWC)
+				{
+					for (int b = 0; b < count; b++)
+						write_input_mem(data + static_cast<size_t>(b) * size, rows, cols, channels, step, b);
+
+					// The slots past count still hold the previous batch's frames
+					size_t sample_bytes = static_cast<size_t>(input_height_) * input_stride_ * input_channels_;
+					size_t used_bytes = static_cast<size_t>(count) * sample_bytes;
+					size_t batch_bytes = std::min(static_cast<size_t>(model_batch_) * sample_bytes, static_cast<size_t>(input_mem_->size));
+					if (used_bytes < batch_bytes)
+						std::memset(static_cast<std::uint8_t*>(input_mem_->virt_addr) + used_bytes, 0, batch_bytes - used_bytes);
+					return;
+				}
+
+				if (count < model_batch_)
+				{
+					size_t row_bytes = static_cast<size_t>(cols) * channels;
+					input_staging_.assign(static_cast<size_t>(model_batch_) * size, 0);
+					for (int b = 0; b < count; b++)
 					{
-						temp[outputs[i].index].insert(temp[outputs[i].index].end(), reinterpret_cast<float*>(outputs[i].buf), reinterpret_cast<float*>(outputs[i].buf) + outputs[i].size / sizeof(float));
+						const std::uint8_t* src_ptr = data + static_cast<size_t>(b) * size;
+						std::uint8_t* dst_ptr = input_staging_.data() + static_cast<size_t>(b) * size;
+						for (int h = 0; h < rows; ++h)
+							memcpy(dst_ptr + h * row_bytes, src_ptr + h * step, row_bytes);
 					}
-
-					rknn_outputs_release(ctx_, io_num_.n_output, outputs);
+					data = input_staging_.data();
 				}
 
-				std::unordered_map<std::string, std::shared_ptr<memory::tensor<float>>> result;
+				rknn_input inputs[1];
+				std::memset(inputs, 0, sizeof(inputs));
+				inputs[0].index = 0;
+				inputs[0].type = RKNN_TENSOR_UINT8;
+				inputs[0].size = size * model_batch_;
+				inputs[0].fmt = fmt;
+				inputs[0].buf = const_cast<std::uint8_t*>(data);
 
-				for (size_t index = 0; index < io_num_.n_output; index++)
-				{
-					std::vector<int> temp_shape = output_tensor_shape_index_[index];
-					temp_shape[0] = data_shape[0];
+				int ret = rknn_inputs_set(ctx_, io_num_.n_input, inputs);
+				if (ret < 0)
+					throw rknn_exception(ret, "rknn_input_set fail!");
+			}
 
-					auto output_tensor = std::make_shared<memory::tensor<float>>(temp_shape);
+			// Copies one HWC uint8 sample into slot sample of the bound input memory honoring w_stride.
+			// Nothing is copied when the caller already wrote into input_view().
+			void write_input_mem(const std::uint8_t* data, int rows, int cols, int channels, size_t src_step, int sample = 0)
+			{
+				if (sample == 0 && data == static_cast<const std::uint8_t*>(input_mem_->virt_addr))
+					return;
+
+				if (rows != input_height_ || cols != input_width_ || channels != input_channels_)
+					throw rknn_exception(RKNN_ERR_INPUT_INVALID, fmt::format("zero-copy input expects {}x{}x{}, got {}x{}x{}!", input_height_, input_width_, input_channels_, rows, cols, channels).c_str());
 
-					std::copy(temp[index].begin(), temp[index].end(), output_tensor->mutable_cpu_data());
-					result[output_name_index_[index]] = output_tensor;
+				size_t dst_step = static_cast<size_t>(input_stride_) * input_channels_;
+				size_t row_bytes = static_cast<size_t>(cols) * channels;
+				std::uint8_t* dst_ptr = static_cast<std::uint8_t*>(input_mem_->virt_addr) + static_cast<size_t>(sample) * input_height_ * dst_step;
+				if (src_step == row_bytes && dst_step == row_bytes)
+				{
+					memcpy(dst_ptr, data, row_bytes * rows);
+					return;
+				}
+
+				for (int h = 0; h < rows; ++h)
+				{
+					memcpy(dst_ptr, data, row_bytes);
+					data += src_step;
+					dst_ptr += dst_step;
 				}
-				
-				return result;
 			}
-#endif		
-		private:
-			rknn_context ctx_;
-			uint32_t flag_;
-			rknn_input_output_num io_num_;
-			std::vector<rknn_tensor_attr> input_attrs;
-			std::vector<rknn_tensor_attr> output_attrs;
-			std::unordered_map<int, std::string> output_name_index_;
-			std::unordered_map<int, std::vector<int>> output_tensor_shape_index_;
+#endif
 
 			static std::vector<std::string> split_string(const std::string& s, const std::string& c)
 			{
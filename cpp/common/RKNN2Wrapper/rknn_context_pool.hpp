@@ -0,0 +1,134 @@
+#pragma once
+#ifndef _RKNN_CONTEXT_POOL_HPP_
+#define _RKNN_CONTEXT_POOL_HPP_
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "rknn2_wrapper.hpp"
+
+namespace glasssix
+{
+	namespace rknnwrapper
+	{
+		enum class dispatch_policy { round_robin, least_loaded };
+
+		/// <summary>
+		/// N copies of one loaded model, each pinned to an NPU core mask. forward() may be called from
+		/// several threads at once; every call runs on one context that no other thread is using.
+		/// Exposes the same forward() overloads as rknn_wrapper, so it can be used as a Yolo pipeline.
+		/// </summary>
+		class rknn_context_pool
+		{
+		public:
+			rknn_context_pool() = delete;
+			rknn_context_pool(const rknn_context_pool&) = delete;
+			rknn_context_pool& operator=(const rknn_context_pool&) = delete;
+
+			/// <param name="primary">The loaded model, used as the first context</param>
+			/// <param name="size">Number of contexts in total</param>
+			/// <param name="core_masks">Core mask of each context, cycled if shorter than size; empty keeps RKNN_NPU_CORE_AUTO</param>
+			/// <param name="policy">How forward() picks a context</param>
+			rknn_context_pool(std::shared_ptr<rknn_wrapper> primary, std::size_t size, const std::vector<rknn_core_mask>& core_masks = {}, dispatch_policy policy = dispatch_policy::least_loaded)
+				:policy_(policy), next_(0)
+			{
+				if (primary == nullptr || size == 0)
+					throw rknn_exception(RKNN_ERR_PARAM_INVALID, "rknn_context_pool needs a model and at least one context!");
+
+				auto mask_of = [&core_masks](std::size_t i) {
+					return core_masks.empty() ? RKNN_NPU_CORE_AUTO : core_masks[i % core_masks.size()];
+				};
+
+				primary->set_core_mask(mask_of(0));
+				slots_.emplace_back(std::make_unique<slot>(primary));
+				for (std::size_t i = 1; i < size; i++)
+					slots_.emplace_back(std::make_unique<slot>(primary->dup(mask_of(i))));
+			}
+
+			rknn_context_pool(const std::vector<std::string>& phai, std::string racy, std::size_t size, const std::vector<rknn_core_mask>& core_masks = {},
+				dispatch_policy policy = dispatch_policy::least_loaded, uint32_t flag = 0)
+				:rknn_context_pool(std::make_shared<rknn_wrapper>(phai, racy, -1, flag), size, core_masks, policy)
+			{}
+
+			/// <summary>
+			/// One mask per NPU core of an RK3588-class SoC: core 0, core 1, core 2.
+			/// </summary>
+			static std::vector<rknn_core_mask> per_core_masks()
+			{
+				return { RKNN_NPU_CORE_0, RKNN_NPU_CORE_1, RKNN_NPU_CORE_2 };
+			}
+
+			template<typename... Args>
+			auto forward(Args&&... args)
+			{
+				slot& current = acquire();
+				in_flight_guard guard{ current.in_flight };
+				std::lock_guard<std::mutex> lock(current.mutex);
+				return current.wrapper->forward(std::forward<Args>(args)...);
+			}
+
+			std::size_t size() const
+			{
+				return slots_.size();
+			}
+
+			std::shared_ptr<rknn_wrapper> context(std::size_t index) const
+			{
+				return slots_[index]->wrapper;
+			}
+
+		private:
+			struct slot
+			{
+				explicit slot(std::shared_ptr<rknn_wrapper> wrapper_) :wrapper(std::move(wrapper_)), in_flight(0) {}
+
+				std::shared_ptr<rknn_wrapper> wrapper;
+				std::mutex mutex;
+				std::atomic<int> in_flight;
+			};
+
+			struct in_flight_guard
+			{
+				std::atomic<int>& counter;
+				~in_flight_guard()
+				{
+					counter.fetch_sub(1, std::memory_order_relaxed);
+				}
+			};
+
+			// Picks a context and counts the caller in before it starts waiting for the context lock,
+			// so concurrent dispatchers see the queued work as load.
+			slot& acquire()
+			{
+				std::size_t start = next_.fetch_add(1, std::memory_order_relaxed) % slots_.size();
+				std::size_t chosen = start;
+
+				if (policy_ == dispatch_policy::least_loaded)
+				{
+					int best = slots_[start]->in_flight.load(std::memory_order_relaxed);
+					for (std::size_t i = 1; i < slots_.size() && best > 0; i++)
+					{
+						std::size_t index = (start + i) % slots_.size();
+						int load = slots_[index]->in_flight.load(std::memory_order_relaxed);
+						if (load < best)
+						{
+							best = load;
+							chosen = index;
+						}
+					}
+				}
+
+				slots_[chosen]->in_flight.fetch_add(1, std::memory_order_relaxed);
+				return *slots_[chosen];
+			}
+
+			dispatch_policy policy_;
+			std::atomic<std::size_t> next_;
+			std::vector<std::unique_ptr<slot>> slots_;
+		};
+	}
+}
+
+#endif
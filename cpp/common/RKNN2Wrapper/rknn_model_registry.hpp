@@ -0,0 +1,125 @@
+#pragma once
+#ifndef _RKNN_MODEL_REGISTRY_HPP_
+#define _RKNN_MODEL_REGISTRY_HPP_
+
+#include <mutex>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <sys/stat.h>
+
+#include "rknn2_wrapper.hpp"
+#include "../Primitives/singleton.hpp"
+#include "../Primitives/abi/sha3.hpp"
+
+namespace glasssix
+{
+	namespace rknnwrapper
+	{
+		/// <summary>
+		/// Process-wide table of loaded models keyed by the SHA3-256 of the .rknn file, so identical files
+		/// opened by different modules or instances are loaded once. Every caller gets its own context;
+		/// all contexts of a model run on the weights of the first one (rknn_wrapper::share_weights()).
+		/// The digest of a path is hashed again only when the file's size or modification time changes.
+		/// </summary>
+		class rknn_model_registry : public singleton<rknn_model_registry>
+		{
+			friend class singleton<rknn_model_registry>;
+		public:
+			rknn_model_registry(const rknn_model_registry&) = delete;
+			rknn_model_registry& operator=(const rknn_model_registry&) = delete;
+
+			/// <summary>
+			/// Returns a context for the model. The model is loaded on the first request for its content and
+			/// unloaded once the last context handed out for it is released.
+			/// </summary>
+			/// <param name="phai">Passed through to rknn_wrapper</param>
+			/// <param name="racy">The model path, as given to rknn_wrapper</param>
+			/// <param name="flag">rknn_init flags; models loaded with different flags are kept apart</param>
+			/// <param name="zero_copy_input">Bind the input memory; kept apart like flag</param>
+			std::shared_ptr<rknn_wrapper> acquire(const std::vector<std::string>& phai, std::string racy, uint32_t flag = 0, bool zero_copy_input = false)
+			{
+				std::string path = resolve_model_path(racy);
+
+				std::lock_guard<std::mutex> lock(mutex_);
+				std::string key = fmt::format("{}:{}:{}", cached_digest(path), flag, zero_copy_input ? 1 : 0);
+				std::shared_ptr<rknn_wrapper> primary = models_[key].lock();
+				if (primary == nullptr)
+				{
+					primary = std::make_shared<rknn_wrapper>(phai, racy, -1, flag, zero_copy_input);
+					models_[key] = primary;
+					return primary;
+				}
+
+				// The shared context is released before the primary it borrows the weights from.
+				std::shared_ptr<rknn_wrapper> shared = primary->share_weights();
+				rknn_wrapper* context = shared.get();
+				return std::shared_ptr<rknn_wrapper>(context, [shared, primary](rknn_wrapper*) mutable {
+					shared.reset();
+					primary.reset();
+					});
+			}
+
+		private:
+			// Digest of a file, valid while the file keeps the size and modification time it was hashed at
+			struct digest_entry
+			{
+				long long size = -1;
+				long long mtime = 0;
+				long long mtime_nsec = 0;
+				std::string digest;
+			};
+
+			rknn_model_registry() = default;
+
+			// Called with mutex_ held
+			std::string cached_digest(const std::string& path)
+			{
+				struct stat st;
+				if (stat(path.c_str(), &st) != 0)
+					throw rknn_exception(RKNN_ERR_MODEL_INVALID, fmt::format("load model {} fail!", path).c_str());
+
+				long long mtime_nsec = 0;
+#if defined(__linux__)
+				mtime_nsec = st.st_mtim.tv_nsec;
+#endif
+				digest_entry& entry = digests_[path];
+				if (entry.size != static_cast<long long>(st.st_size) || entry.mtime != static_cast<long long>(st.st_mtime) || entry.mtime_nsec != mtime_nsec)
+				{
+					entry.digest = content_digest(path);
+					entry.size = static_cast<long long>(st.st_size);
+					entry.mtime = static_cast<long long>(st.st_mtime);
+					entry.mtime_nsec = mtime_nsec;
+				}
+				return entry.digest;
+			}
+
+			static std::string content_digest(const std::string& path)
+			{
+				model_file model(path);
+				if (model.data() == nullptr)
+					throw rknn_exception(RKNN_ERR_MODEL_INVALID, fmt::format("load model {} fail!", path).c_str());
+
+				namespace sha3 = exposing::hashing::sha3;
+				auto digest = sha3::details::hash_digest<sha3::sha3_type::sha3_256>{}.update(model.data(), model.size()).finalize();
+
+				static const char hex_digits[] = "0123456789abcdef";
+				std::string result;
+				result.reserve(digest.size() * 2);
+				for (auto byte : digest)
+				{
+					result.push_back(hex_digits[byte >> 4]);
+					result.push_back(hex_digits[byte & 0x0F]);
+				}
+				return result;
+			}
+
+			std::mutex mutex_;
+			std::unordered_map<std::string, std::weak_ptr<rknn_wrapper>> models_;
+			std::unordered_map<std::string, digest_entry> digests_;
+		};
+	}
+}
+
+#endif
@@ -0,0 +1,222 @@
+#pragma once
+#ifndef _RKNN_OUTPUT_CONVERSIONS_HPP_
+#define _RKNN_OUTPUT_CONVERSIONS_HPP_
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+
+#include "../Primitives/simd_types.hpp"
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// _mm*_cvtepi8_epi32 needs SSE4.1 for 128-bit vectors and AVX2 for 256-bit ones.
+#if (SIMD_X86_INSTR_SET >= SIMD_X86_SSE4_1_VERSION && SIMD_X86_INSTR_SET <= SIMD_X86_SSE4_2_VERSION) || (SIMD_X86_INSTR_SET == SIMD_X86_AVX2_VERSION)
+#define RKNN_CONVERSIONS_X86_SIMD 1
+#endif
+
+namespace glasssix
+{
+	namespace rknnwrapper
+	{
+		// Scalar references. The SIMD kernels below must produce the same values bit for bit.
+
+		inline float deqnt_affine_to_f32_ref(std::int8_t qnt, std::int32_t zp, float scale)
+		{
+			return (static_cast<float>(qnt) - static_cast<float>(zp)) * scale;
+		}
+
+		// IEEE 754 half to single, including subnormals, infinities and NaNs. Signaling NaNs come back
+		// quiet with their payload, as F16C and the NEON converters return them.
+		inline float f16_to_f32_ref(std::uint16_t f16)
+		{
+			std::uint32_t sign = static_cast<std::uint32_t>(f16 & 0x8000) << 16;
+			std::uint32_t exponent = (f16 >> 10) & 0x1F;
+			std::uint32_t mantissa = f16 & 0x3FF;
+			std::uint32_t bits;
+
+			if (exponent == 0x1F)
+			{
+				bits = sign | 0x7F800000 | (mantissa << 13);
+				if (mantissa != 0)
+					bits |= 0x00400000;
+			}
+			else if (exponent != 0)
+			{
+				bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+			}
+			else if (mantissa == 0)
+			{
+				bits = sign;
+			}
+			else
+			{
+				// Subnormal: shift the leading one into the implicit bit and lower the exponent to match.
+				exponent = 127 - 15 + 1;
+				while ((mantissa & 0x400) == 0)
+				{
+					mantissa <<= 1;
+					exponent--;
+				}
+				bits = sign | (exponent << 23) | ((mantissa & 0x3FF) << 13);
+			}
+
+			float result;
+			std::memcpy(&result, &bits, sizeof(result));
+			return result;
+		}
+
+		inline void int8_to_f32_ref(const std::int8_t* src, float* dst, std::size_t length, std::int32_t zp, float scale)
+		{
+			for (std::size_t i = 0; i < length; i++)
+				dst[i] = deqnt_affine_to_f32_ref(src[i], zp, scale);
+		}
+
+		inline void f16_to_f32_ref(const std::uint16_t* src, float* dst, std::size_t length)
+		{
+			for (std::size_t i = 0; i < length; i++)
+				dst[i] = f16_to_f32_ref(src[i]);
+		}
+
+		// NC1HWC2 (C2 channels interleaved per plane) to NCHW, keeping the first channel channels.
+		template<typename T, typename Convert>
+		void NC1HWC2_to_NCHW_ref(const T* src, float* dst, const int* dims, int channel, int h, int w, Convert convert)
+		{
+			int batch = dims[0];
+			int C1 = dims[1];
+			int C2 = dims[4];
+			int hw_src = dims[2] * dims[3];
+			int hw_dst = h * w;
+			for (int i = 0; i < batch; i++)
+			{
+				const T* src_b = src + static_cast<std::size_t>(i) * C1 * hw_src * C2;
+				float* dst_b = dst + static_cast<std::size_t>(i) * channel * hw_dst;
+				for (int c = 0; c < channel; ++c)
+				{
+					const T* src_c = src_b + static_cast<std::size_t>(c / C2) * hw_src * C2;
+					int offset = c % C2;
+					for (int hw = 0; hw < hw_dst; ++hw)
+						dst_b[static_cast<std::size_t>(c) * hw_dst + hw] = convert(src_c[static_cast<std::size_t>(C2) * hw + offset]);
+				}
+			}
+		}
+
+		// Vectorized kernels.
+
+		inline void int8_to_f32(const std::int8_t* src, float* dst, std::size_t length, std::int32_t zp, float scale)
+		{
+			std::size_t i = 0;
+#if defined(__ARM_NEON)
+			// (q - zp) * scale; q - zp fits in int16 for every int8 q and zero point.
+			int16x8_t v_zp = vdupq_n_s16(static_cast<std::int16_t>(zp));
+			float32x4_t v_scale = vdupq_n_f32(scale);
+			for (; i + 16 <= length; i += 16)
+			{
+				int8x16_t q = vld1q_s8(src + i);
+				int16x8_t lo = vsubq_s16(vmovl_s8(vget_low_s8(q)), v_zp);
+				int16x8_t hi = vsubq_s16(vmovl_s8(vget_high_s8(q)), v_zp);
+				vst1q_f32(dst + i, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(lo))), v_scale));
+				vst1q_f32(dst + i + 4, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(lo))), v_scale));
+				vst1q_f32(dst + i + 8, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(hi))), v_scale));
+				vst1q_f32(dst + i + 12, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(hi))), v_scale));
+			}
+#elif defined(RKNN_CONVERSIONS_X86_SIMD)
+			mm_type v_zp = mm_set1_ps(static_cast<float>(zp));
+			mm_type v_scale = mm_set1_ps(scale);
+			for (; i + mm_align_size <= length; i += mm_align_size)
+			{
+				long long packed = 0;
+				std::memcpy(&packed, src + i, mm_align_size);
+				mm_type q = mm_cvtepi32_ps(mm_cvtepi8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(&packed))));
+				mm_store_ps(dst + i, mm_mul_ps(mm_sub_ps(q, v_zp), v_scale));
+			}
+#endif
+			for (; i < length; i++)
+				dst[i] = deqnt_affine_to_f32_ref(src[i], zp, scale);
+		}
+
+		inline void f16_to_f32(const std::uint16_t* src, float* dst, std::size_t length)
+		{
+			std::size_t i = 0;
+#if defined(__ARM_NEON) && (defined(__aarch64__) || (defined(__ARM_FP) && (__ARM_FP & 2)))
+			for (; i + 8 <= length; i += 8)
+			{
+				vst1q_f32(dst + i, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(src + i))));
+				vst1q_f32(dst + i + 4, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(src + i + 4))));
+			}
+#elif defined(__F16C__)
+			for (; i + 8 <= length; i += 8)
+				_mm256_storeu_ps(dst + i, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i))));
+#endif
+			for (; i < length; i++)
+				dst[i] = f16_to_f32_ref(src[i]);
+		}
+
+		namespace details
+		{
+			// Converts a run of a plane to float with the vector kernel, then scatters each of the C2
+			// interleaved channels to its NCHW row. The block stays in L1 between the two passes.
+			template<typename T, typename ConvertRun>
+			void NC1HWC2_to_NCHW(const T* src, float* dst, const int* dims, int channel, int h, int w, ConvertRun convert_run)
+			{
+				constexpr int block_elems = 1024;
+
+				int batch = dims[0];
+				int C1 = dims[1];
+				int C2 = dims[4];
+				int hw_src = dims[2] * dims[3];
+				int hw_dst = h * w;
+				if (C2 > block_elems)
+				{
+					NC1HWC2_to_NCHW_ref(src, dst, dims, channel, h, w, [&](T value) { float out; convert_run(&value, &out, 1); return out; });
+					return;
+				}
+
+				int block_hw = block_elems / C2;
+				float block[block_elems];
+
+				for (int i = 0; i < batch; i++)
+				{
+					const T* src_b = src + static_cast<std::size_t>(i) * C1 * hw_src * C2;
+					float* dst_b = dst + static_cast<std::size_t>(i) * channel * hw_dst;
+					for (int plane = 0; plane < C1 && plane * C2 < channel; plane++)
+					{
+						const T* src_p = src_b + static_cast<std::size_t>(plane) * hw_src * C2;
+						int plane_channels = std::min(C2, channel - plane * C2);
+						for (int hw0 = 0; hw0 < hw_dst; hw0 += block_hw)
+						{
+							int count = std::min(block_hw, hw_dst - hw0);
+							convert_run(src_p + static_cast<std::size_t>(hw0) * C2, block, static_cast<std::size_t>(count) * C2);
+							for (int offset = 0; offset < plane_channels; offset++)
+							{
+								float* dst_c = dst_b + static_cast<std::size_t>(plane * C2 + offset) * hw_dst + hw0;
+								const float* block_c = block + offset;
+								for (int k = 0; k < count; k++)
+									dst_c[k] = block_c[static_cast<std::size_t>(k) * C2];
+							}
+						}
+					}
+				}
+			}
+		}
+
+		inline void NC1HWC2_int8_to_NCHW_float(const std::int8_t* src, float* dst, const int* dims, int channel, int h, int w, std::int32_t zp, float scale)
+		{
+			details::NC1HWC2_to_NCHW(src, dst, dims, channel, h, w, [zp, scale](const std::int8_t* run, float* out, std::size_t length) {
+				int8_to_f32(run, out, length, zp, scale);
+				});
+		}
+
+		inline void NC1HWC2_f16_to_NCHW_float(const std::uint16_t* src, float* dst, const int* dims, int channel, int h, int w)
+		{
+			details::NC1HWC2_to_NCHW(src, dst, dims, channel, h, w, [](const std::uint16_t* run, float* out, std::size_t length) {
+				f16_to_f32(run, out, length);
+				});
+		}
+	}
+}
+
+#endif
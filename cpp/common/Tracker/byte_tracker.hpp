@@ -0,0 +1,460 @@
+#pragma once
+#ifndef _BYTE_TRACKER_HPP_
+#define _BYTE_TRACKER_HPP_
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include "../YoloFamily/yolo_kernels.hpp"
+#include "kalman_filter.hpp"
+#include "linear_assignment.hpp"
+
+namespace tracker {
+
+    struct byte_tracker_options
+    {
+        // 分数高于此值的检测参与第一轮匹配
+        float track_thresh = 0.5f;
+        // 分数在 (low_thresh, track_thresh) 内的检测只在第二轮与未匹配的跟踪目标匹配
+        float low_thresh = 0.1f;
+        // 未匹配的高分检测达到此分数才新建目标
+        float new_track_thresh = 0.6f;
+        // 各轮匹配的代价上限, 代价为 1 - IoU (fuse_score 时第一轮与第三轮为 1 - IoU * 检测分数)
+        float match_thresh = 0.8f;
+        float low_match_thresh = 0.5f;
+        float unconfirmed_match_thresh = 0.7f;
+        // 跟踪中与丢失的目标 1 - IoU 小于此值时视为同一目标, 保留存在更久的一个
+        float duplicate_thresh = 0.15f;
+        // 丢失超过 track_buffer * frame_rate / 30 帧的目标被删除
+        int frame_rate = 30;
+        int track_buffer = 30;
+        bool fuse_score = true;
+        // 只在同类别之间匹配; 默认与 ByteTrack 一样不区分类别
+        bool class_aware = false;
+        assignment_method assignment = assignment_method::hungarian;
+    };
+
+    struct tracked_object
+    {
+        int track_id;
+        // 本帧匹配的检测在输入中的下标
+        int detection;
+        // 滤波后的框
+        float x1;
+        float y1;
+        float x2;
+        float y2;
+        float score;
+        int category;
+    };
+
+    // ByteTrack: 高分检测先与跟踪中和丢失的目标按 IoU 匹配, 剩下的跟踪目标再与低分检测匹配, 找回被遮挡而分数变低的目标;
+    // 新建的目标需下一帧再次匹配才确认. 每个视频流一个实例, 不可多线程同时调用.
+    // 目标状态按结构数组 (SoA) 存放, 卡尔曼滤波对全部目标一次预测; 只为 IoU 足够的 (目标, 检测) 对建边, 分块求解分配.
+    // 所有缓冲区逐帧复用, 目标数稳定后不再分配内存.
+    class byte_tracker
+    {
+    public:
+        explicit byte_tracker(const byte_tracker_options& options = byte_tracker_options()) :
+            options_(options)
+        {}
+
+        const byte_tracker_options& options() const
+        {
+            return options_;
+        }
+
+        // 清空全部目标, 编号从 1 重新开始
+        void reset()
+        {
+            resize_tracks(0);
+            frame_id_ = 0;
+            next_id_ = 1;
+            output_.clear();
+        }
+
+        int frame_id() const
+        {
+            return frame_id_;
+        }
+
+        // 跟踪中与丢失的目标数
+        std::size_t track_count() const
+        {
+            return track_id_.size();
+        }
+
+        // 处理一帧检测, Object 需有 x1, y1, x2, y2, score, category (AlgorithmObject, ObjectInfo).
+        // 返回本帧已确认的跟踪目标, 引用内部缓冲区, 下一次调用前有效
+        template <typename Object>
+        const std::vector<tracked_object>& update(const Object* objects, std::size_t count)
+        {
+            frame_id_++;
+            split_detections(objects, count);
+            predict();
+
+            // 第一轮: 已确认的跟踪目标与丢失目标 对 高分检测
+            pool_.clear();
+            unconfirmed_.clear();
+            for (std::size_t i = 0; i < track_id_.size(); i++)
+                if (track_state_[i] == tracked && track_activated_[i])
+                    pool_.push_back(static_cast<int>(i));
+                else if (track_state_[i] == tracked)
+                    unconfirmed_.push_back(static_cast<int>(i));
+            for (std::size_t i = 0; i < track_id_.size(); i++)
+                if (track_state_[i] == lost)
+                    pool_.push_back(static_cast<int>(i));
+
+            associate(pool_, high_, options_.match_thresh, options_.fuse_score);
+            remaining_.clear();
+            for (std::size_t r = 0; r < pool_.size(); r++)
+            {
+                int track = pool_[r];
+                if (row_match_[r] >= 0)
+                    update_track(track, high_, row_match_[r]);
+                else if (track_state_[track] == tracked)
+                    remaining_.push_back(track);
+            }
+            keep_unmatched_columns(high_);
+
+            // 第二轮: 仍未匹配的跟踪中目标 对 低分检测, 匹配不上的转为丢失
+            associate(remaining_, low_, options_.low_match_thresh, false);
+            for (std::size_t r = 0; r < remaining_.size(); r++)
+                if (row_match_[r] >= 0)
+                    update_track(remaining_[r], low_, row_match_[r]);
+                else
+                    track_state_[remaining_[r]] = lost;
+
+            // 第三轮: 上一帧新建的未确认目标 对 剩下的高分检测, 匹配不上的直接删除
+            associate(unconfirmed_, high_, options_.unconfirmed_match_thresh, options_.fuse_score);
+            for (std::size_t r = 0; r < unconfirmed_.size(); r++)
+                if (row_match_[r] >= 0)
+                    update_track(unconfirmed_[r], high_, row_match_[r]);
+                else
+                    track_state_[unconfirmed_[r]] = removed;
+            keep_unmatched_columns(high_);
+
+            // 剩下的高分检测新建目标, 第一帧的目标直接确认
+            for (std::size_t d = 0; d < high_.size(); d++)
+                if (high_.score[d] >= options_.new_track_thresh)
+                    add_track(high_, d);
+
+            int max_time_lost = static_cast<int>(options_.frame_rate / 30.f * options_.track_buffer);
+            for (std::size_t i = 0; i < track_id_.size(); i++)
+                if (track_state_[i] == lost && frame_id_ - last_frame_[i] > max_time_lost)
+                    track_state_[i] = removed;
+
+            remove_duplicates();
+            compact();
+
+            output_.clear();
+            for (std::size_t i = 0; i < track_id_.size(); i++)
+                if (track_state_[i] == tracked && track_activated_[i])
+                {
+                    tracked_object object;
+                    object.track_id = track_id_[i];
+                    object.detection = track_detection_[i];
+                    kalman_.box(i, object.x1, object.y1, object.x2, object.y2);
+                    object.score = track_score_[i];
+                    object.category = track_category_[i];
+                    output_.push_back(object);
+                }
+            return output_;
+        }
+
+        template <typename Objects>
+        const std::vector<tracked_object>& update(const Objects& objects)
+        {
+            return update(objects.data(), objects.size());
+        }
+
+    private:
+        enum track_state : std::uint8_t
+        {
+            tracked,
+            lost,
+            removed
+        };
+
+        // 一组检测框, 按分量连续存放以便向量化计算 IoU; index 为在输入中的下标
+        struct box_set
+        {
+            std::vector<float> x1;
+            std::vector<float> y1;
+            std::vector<float> x2;
+            std::vector<float> y2;
+            std::vector<float> area;
+            std::vector<float> score;
+            std::vector<int> category;
+            std::vector<int> index;
+
+            std::size_t size() const
+            {
+                return x1.size();
+            }
+
+            void clear()
+            {
+                x1.clear();
+                y1.clear();
+                x2.clear();
+                y2.clear();
+                area.clear();
+                score.clear();
+                category.clear();
+                index.clear();
+            }
+
+            void push_back(float x1_, float y1_, float x2_, float y2_, float score_, int category_, int index_)
+            {
+                x1.push_back(x1_);
+                y1.push_back(y1_);
+                x2.push_back(x2_);
+                y2.push_back(y2_);
+                area.push_back((x2_ - x1_) * (y2_ - y1_));
+                score.push_back(score_);
+                category.push_back(category_);
+                index.push_back(index_);
+            }
+
+            // 按 keep 中非 0 的项原地压缩
+            void compact(const std::vector<char>& keep)
+            {
+                std::size_t out = 0;
+                for (std::size_t i = 0; i < size(); i++)
+                    if (keep[i])
+                    {
+                        x1[out] = x1[i];
+                        y1[out] = y1[i];
+                        x2[out] = x2[i];
+                        y2[out] = y2[i];
+                        area[out] = area[i];
+                        score[out] = score[i];
+                        category[out] = category[i];
+                        index[out] = index[i];
+                        out++;
+                    }
+                x1.resize(out);
+                y1.resize(out);
+                x2.resize(out);
+                y2.resize(out);
+                area.resize(out);
+                score.resize(out);
+                category.resize(out);
+                index.resize(out);
+            }
+        };
+
+        // 宽或高不为正 (含 NaN 坐标) 的检测直接跳过: 卡尔曼状态的宽高比 w / h 会成为 NaN 或 inf, 并随匹配扩散到其他目标
+        template <typename Object>
+        void split_detections(const Object* objects, std::size_t count)
+        {
+            high_.clear();
+            low_.clear();
+            for (std::size_t i = 0; i < count; i++)
+            {
+                const Object& object = objects[i];
+                if (!(object.x2 > object.x1) || !(object.y2 > object.y1))
+                    continue;
+                float score = object.score;
+                if (score > options_.track_thresh)
+                    high_.push_back(object.x1, object.y1, object.x2, object.y2, score, object.category, static_cast<int>(i));
+                else if (score > options_.low_thresh)
+                    low_.push_back(object.x1, object.y1, object.x2, object.y2, score, object.category, static_cast<int>(i));
+            }
+        }
+
+        // 跟踪中与丢失的目标前进一帧, 未确认的目标不预测; 非跟踪中的目标高度速度置 0
+        void predict()
+        {
+            predict_mode_.resize(track_id_.size());
+            for (std::size_t i = 0; i < track_id_.size(); i++)
+            {
+                if (track_state_[i] == lost)
+                    predict_mode_[i] = kalman_filter::predict_frozen;
+                else
+                    predict_mode_[i] = track_activated_[i] ? kalman_filter::predict : kalman_filter::skip;
+            }
+            kalman_.predict_all(predict_mode_.data());
+        }
+
+        // rows 中的目标对 columns 中的检测建边 (cost < threshold) 并求解分配, 结果在 row_match_ / col_match_
+        void associate(const std::vector<int>& rows, const box_set& columns, float threshold, bool fuse_score)
+        {
+            edges_.clear();
+            ious_.resize(columns.size());
+            if (!columns.size())
+            {
+                row_match_.assign(rows.size(), -1);
+                col_match_.clear();
+                return;
+            }
+
+            for (std::size_t r = 0; r < rows.size(); r++)
+            {
+                int track = rows[r];
+                float x1, y1, x2, y2;
+                kalman_.box(track, x1, y1, x2, y2);
+                yolo_wrapper::iou_one_to_many(x1, y1, x2, y2, (x2 - x1) * (y2 - y1),
+                    columns.x1.data(), columns.y1.data(), columns.x2.data(), columns.y2.data(), columns.area.data(), columns.size(), ious_.data());
+                for (std::size_t c = 0; c < columns.size(); c++)
+                {
+                    if (ious_[c] <= 0.f || (options_.class_aware && columns.category[c] != track_category_[track]))
+                        continue;
+                    float cost = 1.f - (fuse_score ? ious_[c] * columns.score[c] : ious_[c]);
+                    if (cost < threshold)
+                        edges_.push_back({ static_cast<int>(r), static_cast<int>(c), cost });
+                }
+            }
+            assignment_.solve(static_cast<int>(rows.size()), static_cast<int>(columns.size()), edges_, threshold, options_.assignment, row_match_, col_match_);
+        }
+
+        // 去掉上一次 associate 中已匹配的检测
+        void keep_unmatched_columns(box_set& columns)
+        {
+            keep_.resize(columns.size());
+            for (std::size_t c = 0; c < columns.size(); c++)
+                keep_[c] = col_match_[c] < 0;
+            columns.compact(keep_);
+        }
+
+        // 用第 d 个检测更新目标, 丢失的目标就此找回
+        void update_track(int track, const box_set& detections, int d)
+        {
+            float w = detections.x2[d] - detections.x1[d];
+            float h = detections.y2[d] - detections.y1[d];
+            kalman_.update(track, detections.x1[d] + w / 2, detections.y1[d] + h / 2, w / h, h);
+            track_state_[track] = tracked;
+            track_activated_[track] = 1;
+            last_frame_[track] = frame_id_;
+            track_score_[track] = detections.score[d];
+            track_category_[track] = detections.category[d];
+            track_detection_[track] = detections.index[d];
+        }
+
+        void add_track(const box_set& detections, std::size_t d)
+        {
+            float w = detections.x2[d] - detections.x1[d];
+            float h = detections.y2[d] - detections.y1[d];
+            kalman_.initiate(detections.x1[d] + w / 2, detections.y1[d] + h / 2, w / h, h);
+            track_id_.push_back(next_id_++);
+            track_state_.push_back(tracked);
+            track_activated_.push_back(frame_id_ == 1);
+            start_frame_.push_back(frame_id_);
+            last_frame_.push_back(frame_id_);
+            track_score_.push_back(detections.score[d]);
+            track_category_.push_back(detections.category[d]);
+            track_detection_.push_back(detections.index[d]);
+        }
+
+        // 跟踪中的目标与丢失的目标高度重叠时删掉存在时间较短的一个
+        void remove_duplicates()
+        {
+            lost_boxes_.clear();
+            for (std::size_t i = 0; i < track_id_.size(); i++)
+                if (track_state_[i] == lost)
+                {
+                    float x1, y1, x2, y2;
+                    kalman_.box(i, x1, y1, x2, y2);
+                    lost_boxes_.push_back(x1, y1, x2, y2, 0.f, 0, static_cast<int>(i));
+                }
+            if (!lost_boxes_.size())
+                return;
+
+            ious_.resize(lost_boxes_.size());
+            for (std::size_t i = 0; i < track_id_.size(); i++)
+            {
+                if (track_state_[i] != tracked)
+                    continue;
+
+                float x1, y1, x2, y2;
+                kalman_.box(i, x1, y1, x2, y2);
+                yolo_wrapper::iou_one_to_many(x1, y1, x2, y2, (x2 - x1) * (y2 - y1),
+                    lost_boxes_.x1.data(), lost_boxes_.y1.data(), lost_boxes_.x2.data(), lost_boxes_.y2.data(), lost_boxes_.area.data(), lost_boxes_.size(), ious_.data());
+                for (std::size_t c = 0; c < lost_boxes_.size(); c++)
+                {
+                    if (1.f - ious_[c] >= options_.duplicate_thresh)
+                        continue;
+
+                    int other = lost_boxes_.index[c];
+                    if (frame_id_ - start_frame_[i] > frame_id_ - start_frame_[other])
+                        track_state_[other] = removed;
+                    else
+                        track_state_[i] = removed;
+                }
+            }
+        }
+
+        // 按原顺序去掉已删除的目标
+        void compact()
+        {
+            std::size_t out = 0;
+            for (std::size_t i = 0; i < track_id_.size(); i++)
+            {
+                if (track_state_[i] == removed)
+                    continue;
+                if (out != i)
+                {
+                    kalman_.move(i, out);
+                    track_id_[out] = track_id_[i];
+                    track_state_[out] = track_state_[i];
+                    track_activated_[out] = track_activated_[i];
+                    start_frame_[out] = start_frame_[i];
+                    last_frame_[out] = last_frame_[i];
+                    track_score_[out] = track_score_[i];
+                    track_category_[out] = track_category_[i];
+                    track_detection_[out] = track_detection_[i];
+                }
+                out++;
+            }
+            resize_tracks(out);
+        }
+
+        void resize_tracks(std::size_t size)
+        {
+            kalman_.resize(size);
+            track_id_.resize(size);
+            track_state_.resize(size);
+            track_activated_.resize(size);
+            start_frame_.resize(size);
+            last_frame_.resize(size);
+            track_score_.resize(size);
+            track_category_.resize(size);
+            track_detection_.resize(size);
+        }
+
+        byte_tracker_options options_;
+        int frame_id_ = 0;
+        int next_id_ = 1;
+
+        // 目标状态, 下标与 kalman_ 一致
+        kalman_filter kalman_;
+        std::vector<int> track_id_;
+        std::vector<std::uint8_t> track_state_;
+        std::vector<std::uint8_t> track_activated_;
+        std::vector<int> start_frame_;
+        std::vector<int> last_frame_;
+        std::vector<float> track_score_;
+        std::vector<int> track_category_;
+        std::vector<int> track_detection_;
+
+        // 逐帧复用的缓冲区
+        box_set high_;
+        box_set low_;
+        box_set lost_boxes_;
+        std::vector<int> pool_;
+        std::vector<int> unconfirmed_;
+        std::vector<int> remaining_;
+        std::vector<std::uint8_t> predict_mode_;
+        std::vector<float> ious_;
+        std::vector<char> keep_;
+        std::vector<assignment_edge> edges_;
+        std::vector<int> row_match_;
+        std::vector<int> col_match_;
+        linear_assignment assignment_;
+        std::vector<tracked_object> output_;
+    };
+}
+
+#endif
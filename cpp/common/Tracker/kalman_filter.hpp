@@ -0,0 +1,178 @@
+#pragma once
+#ifndef _KALMAN_FILTER_HPP_
+#define _KALMAN_FILTER_HPP_
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace tracker {
+
+    // 一组目标框的匀速卡尔曼滤波, 状态为 (cx, cy, a, h) 及其速度, a 为宽高比, 噪声与 ByteTrack (DeepSORT) 相同.
+    // 运动模型, 观测与噪声在 4 个维度间互不耦合, 所以 8x8 协方差恒为 4 个 (位置, 速度) 的 2x2 块,
+    // 每个目标只需存 12 个数. 全部按结构数组 (SoA) 存放, predict_all 对所有目标连续计算, 可被编译器向量化.
+    class kalman_filter
+    {
+    public:
+        static constexpr int dims = 4;
+        static constexpr float std_weight_position = 1.f / 20;
+        static constexpr float std_weight_velocity = 1.f / 160;
+
+        std::size_t size() const
+        {
+            return size_;
+        }
+
+        void clear()
+        {
+            size_ = 0;
+        }
+
+        // 以观测 (cx, cy, a, h) 新建一个目标, 返回其下标
+        std::size_t initiate(float cx, float cy, float a, float h)
+        {
+            if (size_ == capacity_)
+                grow(capacity_ ? 2 * capacity_ : 64);
+
+            std::size_t i = size_++;
+            const float measurement[dims] = { cx, cy, a, h };
+            const float std_position[dims] = { 2 * std_weight_position * h, 2 * std_weight_position * h, 1e-2f, 2 * std_weight_position * h };
+            const float std_velocity[dims] = { 10 * std_weight_velocity * h, 10 * std_weight_velocity * h, 1e-5f, 10 * std_weight_velocity * h };
+            for (int d = 0; d < dims; d++)
+            {
+                position_[d][i] = measurement[d];
+                velocity_[d][i] = 0.f;
+                p00_[d][i] = std_position[d] * std_position[d];
+                p01_[d][i] = 0.f;
+                p11_[d][i] = std_velocity[d] * std_velocity[d];
+            }
+            return i;
+        }
+
+        // predict_all 中每个目标的处理方式
+        enum predict_mode : std::uint8_t
+        {
+            skip,           // 保持不变
+            predict,        // 前进一帧
+            predict_frozen  // 先把高度速度置 0 再前进一帧 (ByteTrack 对非跟踪状态的处理)
+        };
+
+        // 全部目标按 mode[i] 前进一帧; 两种结果都算出再选择, 循环中没有分支
+        void predict_all(const std::uint8_t* mode)
+        {
+            float* h = position_[3].data();
+            float* vh = velocity_[3].data();
+            for (std::size_t i = 0; i < size_; i++)
+                vh[i] = mode[i] == predict_frozen ? 0.f : vh[i];
+
+            for (int d = 0; d < dims; d++)
+            {
+                float* x = position_[d].data();
+                float* v = velocity_[d].data();
+                float* p00 = p00_[d].data();
+                float* p01 = p01_[d].data();
+                float* p11 = p11_[d].data();
+                // 宽高比的噪声是常数, 其余与当前高度成正比
+                float const_position = d == 2 ? 1e-2f * 1e-2f : 0.f;
+                float const_velocity = d == 2 ? 1e-5f * 1e-5f : 0.f;
+                float weight_position = d == 2 ? 0.f : std_weight_position * std_weight_position;
+                float weight_velocity = d == 2 ? 0.f : std_weight_velocity * std_weight_velocity;
+                for (std::size_t i = 0; i < size_; i++)
+                {
+                    bool active = mode[i] != skip;
+                    float h2 = h[i] * h[i];
+                    float q_position = const_position + weight_position * h2;
+                    float q_velocity = const_velocity + weight_velocity * h2;
+                    float p00_i = p00[i];
+                    float p01_i = p01[i];
+                    float p11_i = p11[i];
+                    p00[i] = active ? p00_i + 2 * p01_i + p11_i + q_position : p00_i;
+                    p01[i] = active ? p01_i + p11_i : p01_i;
+                    p11[i] = active ? p11_i + q_velocity : p11_i;
+                }
+                // 高度放在最后更新, 上面的噪声用的都是预测前的高度
+                for (std::size_t i = 0; i < size_; i++)
+                    x[i] = mode[i] != skip ? x[i] + v[i] : x[i];
+            }
+        }
+
+        // 用观测 (cx, cy, a, h) 校正第 i 个目标
+        void update(std::size_t i, float cx, float cy, float a, float h)
+        {
+            const float measurement[dims] = { cx, cy, a, h };
+            float height = position_[3][i];
+            for (int d = 0; d < dims; d++)
+            {
+                float std_measurement = d == 2 ? 1e-1f : std_weight_position * height;
+                float s = p00_[d][i] + std_measurement * std_measurement;
+                float k0 = p00_[d][i] / s;
+                float k1 = p01_[d][i] / s;
+                float innovation = measurement[d] - position_[d][i];
+                position_[d][i] += k0 * innovation;
+                velocity_[d][i] += k1 * innovation;
+
+                float p00 = p00_[d][i];
+                float p01 = p01_[d][i];
+                p00_[d][i] = p00 - k0 * p00;
+                p01_[d][i] = p01 - k0 * p01;
+                p11_[d][i] -= k1 * p01;
+            }
+        }
+
+        // 第 i 个目标当前的框 (x1, y1, x2, y2)
+        void box(std::size_t i, float& x1, float& y1, float& x2, float& y2) const
+        {
+            float h = position_[3][i];
+            float w = position_[2][i] * h;
+            x1 = position_[0][i] - w / 2;
+            y1 = position_[1][i] - h / 2;
+            x2 = x1 + w;
+            y2 = y1 + h;
+        }
+
+        // 把第 from 个目标移到第 to 个位置 (to <= from), 用于按顺序压缩
+        void move(std::size_t from, std::size_t to)
+        {
+            for (int d = 0; d < dims; d++)
+            {
+                position_[d][to] = position_[d][from];
+                velocity_[d][to] = velocity_[d][from];
+                p00_[d][to] = p00_[d][from];
+                p01_[d][to] = p01_[d][from];
+                p11_[d][to] = p11_[d][from];
+            }
+        }
+
+        void resize(std::size_t size)
+        {
+            if (size > capacity_)
+                grow(size);
+            size_ = size;
+        }
+
+    private:
+        void grow(std::size_t capacity)
+        {
+            capacity_ = capacity;
+            for (int d = 0; d < dims; d++)
+            {
+                position_[d].resize(capacity);
+                velocity_[d].resize(capacity);
+                p00_[d].resize(capacity);
+                p01_[d].resize(capacity);
+                p11_[d].resize(capacity);
+            }
+        }
+
+        std::size_t size_ = 0;
+        std::size_t capacity_ = 0;
+        // 每一维一列: 均值的位置与速度, 2x2 协方差块的 (0,0), (0,1), (1,1)
+        std::vector<float> position_[dims];
+        std::vector<float> velocity_[dims];
+        std::vector<float> p00_[dims];
+        std::vector<float> p01_[dims];
+        std::vector<float> p11_[dims];
+    };
+}
+
+#endif
@@ -0,0 +1,289 @@
+#pragma once
+#ifndef _LINEAR_ASSIGNMENT_HPP_
+#define _LINEAR_ASSIGNMENT_HPP_
+
+#include <vector>
+#include <cstddef>
+#include <limits>
+#include <numeric>
+#include <algorithm>
+
+namespace tracker {
+
+    enum class assignment_method
+    {
+        hungarian,  // 总代价最小 (与 lapjv 加 cost_limit 相同的结果)
+        greedy      // 按代价从小到大依次匹配
+    };
+
+    // 代价矩阵中 cost < threshold 的一项
+    struct assignment_edge
+    {
+        int row;
+        int col;
+        float cost;
+    };
+
+    // 带阈值的稀疏线性分配: 只给出 cost < threshold 的边, 其余行列对视为不可匹配, 未匹配的行或列各计 threshold / 2.
+    // 先按边把行列分成连通块, 块之间互不影响, 各块单独求解; 跟踪场景下块通常只有几个节点, 500 x 500 也远小于整体求解的开销.
+    // 节点数超过 max_hungarian_nodes 的块退回贪心, 以限制拥挤场景的最坏耗时. 缓冲区逐帧复用.
+    class linear_assignment
+    {
+    public:
+        std::size_t max_hungarian_nodes = 128;
+
+        // 结果写入 row_match[rows] 与 col_match[cols], 未匹配为 -1
+        void solve(int rows, int cols, const std::vector<assignment_edge>& edges, float threshold, assignment_method method,
+            std::vector<int>& row_match, std::vector<int>& col_match)
+        {
+            row_match.assign(rows, -1);
+            col_match.assign(cols, -1);
+            if (edges.empty())
+                return;
+
+            if (method == assignment_method::greedy)
+            {
+                order_.resize(edges.size());
+                std::iota(order_.begin(), order_.end(), 0);
+                greedy(edges, order_, row_match, col_match);
+                return;
+            }
+
+            split_components(rows, cols, edges);
+            for (std::size_t component = 0; component + 1 < component_begin_.size(); component++)
+            {
+                int begin = component_begin_[component];
+                int end = component_begin_[component + 1];
+                if (end - begin == 1)
+                {
+                    const assignment_edge& edge = edges[order_[begin]];
+                    row_match[edge.row] = edge.col;
+                    col_match[edge.col] = edge.row;
+                    continue;
+                }
+                hungarian(edges, begin, end, threshold, row_match, col_match);
+            }
+        }
+
+    private:
+        // 并查集: 行 r 为节点 r, 列 c 为节点 rows + c
+        int find(int node)
+        {
+            while (parent_[node] != node)
+            {
+                parent_[node] = parent_[parent_[node]];
+                node = parent_[node];
+            }
+            return node;
+        }
+
+        // 按连通块把边的下标排进 order_, 块 k 为 [component_begin_[k], component_begin_[k + 1]), 块内保持原顺序
+        void split_components(int rows, int cols, const std::vector<assignment_edge>& edges)
+        {
+            parent_.resize(rows + cols);
+            std::iota(parent_.begin(), parent_.end(), 0);
+            for (const auto& edge : edges)
+            {
+                int a = find(edge.row);
+                int b = find(rows + edge.col);
+                if (a != b)
+                    parent_[std::max(a, b)] = std::min(a, b);
+            }
+
+            // 块按首次出现的顺序编号, 再做一次计数排序
+            component_of_.assign(rows + cols, -1);
+            edge_component_.resize(edges.size());
+            component_begin_.clear();
+            for (std::size_t e = 0; e < edges.size(); e++)
+            {
+                int root = find(edges[e].row);
+                if (component_of_[root] < 0)
+                {
+                    component_of_[root] = static_cast<int>(component_begin_.size());
+                    component_begin_.push_back(0);
+                }
+                edge_component_[e] = component_of_[root];
+                component_begin_[edge_component_[e]]++;
+            }
+
+            int offset = 0;
+            for (auto& begin : component_begin_)
+            {
+                int count = begin;
+                begin = offset;
+                offset += count;
+            }
+            component_begin_.push_back(offset);
+
+            order_.resize(edges.size());
+            fill_.assign(component_begin_.begin(), component_begin_.end() - 1);
+            for (std::size_t e = 0; e < edges.size(); e++)
+                order_[fill_[edge_component_[e]]++] = static_cast<int>(e);
+        }
+
+        void greedy(const std::vector<assignment_edge>& edges, std::vector<int>& order, std::vector<int>& row_match, std::vector<int>& col_match)
+        {
+            std::stable_sort(order.begin(), order.end(), [&edges](int a, int b) { return edges[a].cost < edges[b].cost; });
+            for (int e : order)
+            {
+                const assignment_edge& edge = edges[e];
+                if (row_match[edge.row] < 0 && col_match[edge.col] < 0)
+                {
+                    row_match[edge.row] = edge.col;
+                    col_match[edge.col] = edge.row;
+                }
+            }
+        }
+
+        // 一个连通块 order_[begin, end): 建 (n_r + n_c) 阶扩展方阵, 右上与左下为 threshold / 2 (行或列不匹配), 右下为 0,
+        // 左上无边处为足够大的代价, 用带势的 Hungarian (最短增广路) 求最小总代价
+        void hungarian(const std::vector<assignment_edge>& edges, int begin, int end, float threshold,
+            std::vector<int>& row_match, std::vector<int>& col_match)
+        {
+            local_rows_.clear();
+            local_cols_.clear();
+            if (row_local_.size() < row_match.size())
+                row_local_.resize(row_match.size());
+            if (col_local_.size() < col_match.size())
+                col_local_.resize(col_match.size());
+            for (int k = begin; k < end; k++)
+            {
+                const assignment_edge& edge = edges[order_[k]];
+                row_local_[edge.row] = -1;
+                col_local_[edge.col] = -1;
+            }
+            for (int k = begin; k < end; k++)
+            {
+                const assignment_edge& edge = edges[order_[k]];
+                if (row_local_[edge.row] < 0)
+                {
+                    row_local_[edge.row] = static_cast<int>(local_rows_.size());
+                    local_rows_.push_back(edge.row);
+                }
+                if (col_local_[edge.col] < 0)
+                {
+                    col_local_[edge.col] = static_cast<int>(local_cols_.size());
+                    local_cols_.push_back(edge.col);
+                }
+            }
+
+            int n_rows = static_cast<int>(local_rows_.size());
+            int n_cols = static_cast<int>(local_cols_.size());
+            if (static_cast<std::size_t>(n_rows + n_cols) > max_hungarian_nodes)
+            {
+                block_order_.assign(order_.begin() + begin, order_.begin() + end);
+                greedy(edges, block_order_, row_match, col_match);
+                return;
+            }
+
+            int n = n_rows + n_cols;
+            double unmatched = threshold / 2.0;
+            double blocked = 2.0 * threshold + 1.0;
+            cost_.assign(static_cast<std::size_t>(n) * n, 0.0);
+            for (int r = 0; r < n; r++)
+                for (int c = 0; c < n; c++)
+                {
+                    double& cost = cost_[static_cast<std::size_t>(r) * n + c];
+                    if (r < n_rows && c < n_cols)
+                        cost = blocked;
+                    else if (r < n_rows || c < n_cols)
+                        cost = unmatched;
+                }
+            for (int k = begin; k < end; k++)
+            {
+                const assignment_edge& edge = edges[order_[k]];
+                cost_[static_cast<std::size_t>(row_local_[edge.row]) * n + col_local_[edge.col]] = edge.cost;
+            }
+
+            solve_square(n);
+            for (int c = 1; c <= n; c++)
+            {
+                int r = match_[c] - 1;
+                int col = c - 1;
+                if (r < n_rows && col < n_cols && cost_[static_cast<std::size_t>(r) * n + col] < threshold)
+                {
+                    row_match[local_rows_[r]] = local_cols_[col];
+                    col_match[local_cols_[col]] = local_rows_[r];
+                }
+            }
+        }
+
+        // n 阶方阵 cost_ 的最小代价完美匹配, match_[c] 为第 c 列 (1 起) 匹配的行 (1 起)
+        void solve_square(int n)
+        {
+            const double infinity = std::numeric_limits<double>::infinity();
+            u_.assign(n + 1, 0.0);
+            v_.assign(n + 1, 0.0);
+            match_.assign(n + 1, 0);
+            way_.assign(n + 1, 0);
+            for (int row = 1; row <= n; row++)
+            {
+                match_[0] = row;
+                int col0 = 0;
+                min_value_.assign(n + 1, infinity);
+                used_.assign(n + 1, 0);
+                do
+                {
+                    used_[col0] = 1;
+                    int row0 = match_[col0];
+                    double delta = infinity;
+                    int col1 = 0;
+                    const double* cost_row = cost_.data() + static_cast<std::size_t>(row0 - 1) * n;
+                    for (int col = 1; col <= n; col++)
+                        if (!used_[col])
+                        {
+                            double current = cost_row[col - 1] - u_[row0] - v_[col];
+                            if (current < min_value_[col])
+                            {
+                                min_value_[col] = current;
+                                way_[col] = col0;
+                            }
+                            if (min_value_[col] < delta)
+                            {
+                                delta = min_value_[col];
+                                col1 = col;
+                            }
+                        }
+                    for (int col = 0; col <= n; col++)
+                        if (used_[col])
+                        {
+                            u_[match_[col]] += delta;
+                            v_[col] -= delta;
+                        }
+                        else
+                            min_value_[col] -= delta;
+                    col0 = col1;
+                } while (match_[col0] != 0);
+
+                do
+                {
+                    int col1 = way_[col0];
+                    match_[col0] = match_[col1];
+                    col0 = col1;
+                } while (col0 != 0);
+            }
+        }
+
+        std::vector<int> parent_;
+        std::vector<int> component_of_;
+        std::vector<int> edge_component_;
+        std::vector<int> component_begin_;
+        std::vector<int> fill_;
+        std::vector<int> order_;
+        std::vector<int> block_order_;
+
+        std::vector<int> local_rows_;
+        std::vector<int> local_cols_;
+        std::vector<int> row_local_;
+        std::vector<int> col_local_;
+        std::vector<double> cost_;
+        std::vector<double> u_;
+        std::vector<double> v_;
+        std::vector<double> min_value_;
+        std::vector<int> match_;
+        std::vector<int> way_;
+        std::vector<char> used_;
+    };
+}
+
+#endif
@@ -4,10 +4,21 @@
 
 #include <opencv2/opencv.hpp>
 #include <vector>
+#include <mutex>
+#include <future>
 #include <algorithm>
+#include <utility>
+#include <type_traits>
 #include "../Excalibur/pipeline.hpp"
+#include "../Excalibur/operation_letterbox.hpp"
 #include "../Primitives/tensor_conversions.hpp"
+#include "../Primitives/work_stealing_pool.hpp"
 #include "../RKNN2Wrapper/rknn2_wrapper.hpp"
+#include "../debug_dump.hpp"
+#include "yolo_kernels.hpp"
+#include "detection_batch.hpp"
+#include "nms.hpp"
+#include "yolo_head.hpp"
 
 using namespace glasssix;
 namespace yolo_wrapper {
@@ -62,6 +73,97 @@ namespace yolo_wrapper {
         return static_cast<float> (log(x / (1 - x)));
     }
 
+    static inline float dequantize(int8_t q, int32_t zp, float scale)
+    {
+        return (static_cast<float>(q) - static_cast<float>(zp)) * scale;
+    }
+
+    // 量化域阈值: 满足 (q - zp) * scale > threshold 的最小 q, 不存在时返回 128
+    static int quantized_threshold(float threshold, int32_t zp, float scale)
+    {
+        for (int q = -128; q <= 127; q++)
+            if (dequantize(static_cast<int8_t>(q), zp, scale) > threshold)
+                return q;
+        return 128;
+    }
+
+    // 解码器读取一层输出元素的方式: threshold 把 (反 sigmoid 后的) 阈值换算到元素所在的域, operator() 把元素转成 float.
+    // float 输出原样使用; int8 输出在量化域比较阈值, 只反量化通过阈值的候选框
+    struct float_elements
+    {
+        using value_type = float;
+
+        float threshold(float value) const { return value; }
+        float operator()(float value) const { return value; }
+    };
+
+    struct int8_elements
+    {
+        using value_type = int8_t;
+        int32_t zp;
+        float scale;
+
+        int threshold(float value) const { return quantized_threshold(value, zp, scale); }
+        float operator()(int8_t value) const { return dequantize(value, zp, scale); }
+    };
+
+    // int8 分数的 threshold_compact, 顺序相同; threshold 为 quantized_threshold 给出的量化域阈值, q >= threshold 的通过
+    static size_t threshold_compact(const int8_t* scores, size_t cell_stride, size_t cell_begin, size_t cell_end, int classes, int threshold, int* cells, int* labels)
+    {
+        size_t count = 0;
+        for (int label = 0; label < classes; label++)
+        {
+            const int8_t* class_scores = scores + static_cast<size_t>(label) * cell_stride;
+            for (size_t k = cell_begin; k < cell_end; k++)
+                if (class_scores[k] >= threshold)
+                {
+                    cells[count] = static_cast<int>(k);
+                    labels[count] = label;
+                    count++;
+                }
+        }
+        return count;
+    }
+
+    // int8 分数的 threshold_compact_best_class, 同分取编号小的类别
+    static size_t threshold_compact_best_class(const int8_t* scores, size_t cell_stride, size_t cell_begin, size_t cell_end, int classes, int threshold, int* cells, int* labels)
+    {
+        size_t count = 0;
+        for (size_t k = cell_begin; k < cell_end; k++)
+        {
+            int8_t best = scores[k];
+            int best_label = 0;
+            for (int label = 1; label < classes; label++)
+            {
+                int8_t value = scores[static_cast<size_t>(label) * cell_stride + k];
+                if (value > best)
+                {
+                    best = value;
+                    best_label = label;
+                }
+            }
+            if (best >= threshold)
+            {
+                cells[count] = static_cast<int>(k);
+                labels[count] = best_label;
+                count++;
+            }
+        }
+        return count;
+    }
+
+    // int8 输出的 gather_columns, 取出的同时反量化
+    static void gather_columns(const int8_t* src, int rows, size_t cols, const int* indices, size_t count, float* dst, const int8_elements& elements)
+    {
+        for (int row = 0; row < rows; row++)
+        {
+            const int8_t* src_row = src + row * cols;
+            float* dst_row = dst + row * count;
+            for (size_t k = 0; k < count; k++)
+                dst_row[k] = elements(src_row[indices[k]]);
+        }
+    }
+
     static int safe_region(float location, int border)
     {
         location = location > 0.f ? location : 0.f;
@@ -69,6 +171,37 @@ namespace yolo_wrapper {
         return std::round(location);
     }
 
+    // 流水线能否把 NPU 输入内存直接交给调用方填写 (rknn_wrapper 的零拷贝输入)
+    template <typename Pipeline, typename = void>
+    struct has_input_view : std::false_type {};
+
+    template <typename Pipeline>
+    struct has_input_view<Pipeline, std::void_t<decltype(std::declval<Pipeline&>().input_view()), decltype(std::declval<Pipeline&>().zero_copy_input())>> : std::true_type {};
+
+    // 流水线是否提供 forward_async (见 rknn_wrapper::forward_async)
+    template <typename Pipeline, typename = void>
+    struct has_forward_async : std::false_type {};
+
+    template <typename Pipeline>
+    struct has_forward_async<Pipeline, std::void_t<decltype(std::declval<Pipeline&>().forward_async(std::declval<const cv::Mat&>()))>> : std::true_type {};
+
+    // 多帧输出中第 sample 帧的输出, 不拷贝: 形状同原输出但首维为 1, 数据指向原张量, 原张量须在使用期间保持有效
+    inline std::unordered_map<std::string, std::shared_ptr<memory::tensor<float>>> sample_outputs(
+        const std::unordered_map<std::string, std::shared_ptr<memory::tensor<float>>>& outputs, int sample)
+    {
+        std::unordered_map<std::string, std::shared_ptr<memory::tensor<float>>> result;
+        for (const auto& output : outputs)
+        {
+            std::vector<int> shape = output.second->data_shape();
+            int sample_count = output.second->count(1, static_cast<int>(shape.size()));
+            auto view = std::make_shared<memory::tensor<float>>(1, sample_count, output.second->mutable_cpu_data() + static_cast<size_t>(sample) * sample_count, -1, output.second->order());
+            shape[0] = 1;
+            view->reshape(shape);
+            result.emplace(output.first, std::move(view));
+        }
+        return result;
+    }
+
 }
 
 struct key_point
@@ -112,32 +245,102 @@ class YoloBase {
 protected:
     cv::Mat infer_image;
     cv::Mat image;
+    cv::Mat convert_image_;
+    excalibur::letterbox letterbox_;
     int model_input_height_;
     int model_input_width_;
     T pipeline;
     pic_process_param pic_process_param_;
+    // get_objects_batch 的多帧输入 (各帧上下相接) 与各帧的 letterbox 参数
+    cv::Mat batch_input_;
+    std::vector<pic_process_param> batch_params_;
+
+    // 逐帧复用的后处理缓冲区: 检测框, 候选格子及其类别, NMS.
+    // 解码到出结果的整个过程持有 decode_mutex_, get_objects_async 的 future 可在其他线程上 get()
+    std::mutex decode_mutex_;
+    detection_batch detections_;
+    std::vector<int> candidate_index_;
+    std::vector<int> candidate_label_;
+    yolo_wrapper::nms_engine nms_;
+    yolo_wrapper::nms_param nms_param_;
+    bool best_class_only_ = false;
+
+    // 并行解码: 每个任务一份检测框, 按任务顺序合并
+    bool parallel_decode_ = true;
+    std::vector<detection_batch> task_detections_;
+    std::vector<size_t> merge_cursors_;
+    // 并行解码时每个任务大约处理的格子数, 按整行划分
+    static constexpr int decode_task_cells = 2048;
 
 public:
     YoloBase(int model_input_width, int model_input_height, T pipe) : pipeline(pipe), model_input_height_(model_input_height), model_input_width_(model_input_width) {}
 
+    // NMS 后最多保留的目标数, 0 为不限
+    void set_top_k(std::size_t top_k)
+    {
+        nms_param_.top_k = top_k;
+    }
+
+    // 选择 NMS 方式; 密集人群可用 soft_* / diou / matrix 减少重叠目标被误删, sigma 与 score_threshold 见 nms_param
+    void set_nms(yolo_wrapper::nms_method method, float sigma = 0.5f, float score_threshold = 0.001f)
+    {
+        nms_param_.method = method;
+        nms_param_.sigma = sigma;
+        nms_param_.score_threshold = score_threshold;
+    }
+
+    // 每个格子只保留分数最高的类别; 默认每个超过阈值的 (格子, 类别) 都作为候选
+    void set_best_class_only(bool best_class_only)
+    {
+        best_class_only_ = best_class_only;
+    }
+
+    // 解码是否在共享线程池 (work_stealing_pool::instance()) 上并行, 默认开启; 关闭后在调用线程上依次执行同样的任务, 结果相同
+    void set_parallel_decode(bool parallel_decode)
+    {
+        parallel_decode_ = parallel_decode;
+    }
+
     void preprocess_detection(cv::Mat& src, cv::Size input_shape = cv::Size(640, 640), bool BGR2RGB = true)
     {
-        this->pic_process_param_.ratio = std::min((float)input_shape.width / (float)src.cols, (float)input_shape.height / (float)src.rows);
-        cv::Mat cut_image;
-        if (src.rows != input_shape.height || src.cols != input_shape.width)
+        this->infer_image.create(input_shape, CV_8UC3);
+        preprocess_detection(src, this->infer_image, BGR2RGB);
+    }
+
+    // 缩放、填充 (114)、通道交换一次完成, 直接写入 dst; dst 为模型输入尺寸的 CV_8UC3, 可以是 NPU 输入内存
+    void preprocess_detection(const cv::Mat& src, cv::Mat& dst, bool BGR2RGB = true)
+    {
+        const cv::Mat* input = &src;
+        if (src.type() != CV_8UC3)
         {
-            cv::resize(src, cut_image, cv::Size((int)(src.cols * this->pic_process_param_.ratio), (int)(src.rows * this->pic_process_param_.ratio)), cv::INTER_LINEAR);
-            this->pic_process_param_.pad_h = std::round((input_shape.height - cut_image.rows) / 2);
-            this->pic_process_param_.pad_w = std::round((input_shape.width - cut_image.cols) / 2);
-            cv::copyMakeBorder(cut_image, this->infer_image, this->pic_process_param_.pad_h, input_shape.height - cut_image.rows - this->pic_process_param_.pad_h, this->pic_process_param_.pad_w, input_shape.width - cut_image.cols - this->pic_process_param_.pad_w, cv::BORDER_CONSTANT, cv::Scalar{ 114,114,114 });
+            cv::cvtColor(src, convert_image_, src.channels() == 4 ? cv::COLOR_BGRA2BGR : cv::COLOR_GRAY2BGR);
+            input = &convert_image_;
         }
-        else
-            src.copyTo(this->infer_image);
-        if (BGR2RGB)
-            cv::cvtColor(this->infer_image, this->infer_image, cv::COLOR_BGR2RGB);
+
+        auto geometry = letterbox_.run(input->data, input->step, input->cols, input->rows, dst.data, dst.step, dst.cols, dst.rows, BGR2RGB);
+        this->pic_process_param_.ratio = geometry.ratio;
+        this->pic_process_param_.pad_h = geometry.pad_top;
+        this->pic_process_param_.pad_w = geometry.pad_left;
     }
 
-    virtual std::vector<std::vector<float>> yoloconcat(std::vector<std::shared_ptr<glasssix::memory::tensor<float>>>& outs, float conf) = 0;
+    // 同步推理的输入缓冲区: 流水线支持零拷贝输入时直接是 NPU 输入内存, 否则为 infer_image
+    cv::Mat model_input(cv::Size input_shape)
+    {
+        if constexpr (yolo_wrapper::has_input_view<std::decay_t<decltype(*pipeline)>>::value)
+        {
+            if (pipeline->zero_copy_input())
+            {
+                cv::Mat view = pipeline->input_view();
+                if (view.size() == input_shape && view.type() == CV_8UC3)
+                    return view;
+            }
+        }
+        infer_image.create(input_shape, CV_8UC3);
+        return infer_image;
+    }
+
+    // 解码各层输出, 通过阈值的检测框 (中心点 xywh) 写入 detections
+    virtual void yoloconcat(std::vector<std::shared_ptr<glasssix::memory::tensor<float>>>& outs, float conf, detection_batch& detections) = 0;
 
     virtual std::vector<std::shared_ptr<glasssix::memory::tensor<float>>> sort_model_result(std::unordered_map<std::string, std::shared_ptr<memory::tensor<float>>>& model_results)
     {
@@ -155,31 +358,27 @@ public:
         return output;
     }
 
-    std::vector<std::vector<float>> centre_xywh2WH(std::vector<std::vector<float>>& net_result, int pad_h, int pad_w, float scale)
+    // 原地把中心点 xywh 换算为原图上的左上角 xywh
+    void centre_xywh2WH(detection_batch& detections, int pad_h, int pad_w, float scale)
     {
-        std::vector<std::vector<float>> output;
-        if (!net_result.size())
-            return output;
-
-        for (auto& centrexywh : net_result)
+        for (size_t i = 0; i < detections.size(); i++)
         {
-            std::vector<float> temp(centrexywh.size());
-            temp = centrexywh;
-            temp[0] = static_cast<double>((centrexywh[0] - centrexywh[2] / 2) - pad_w) * scale;
-            temp[1] = static_cast<double>((centrexywh[1] - centrexywh[3] / 2) - pad_h) * scale;
-            temp[2] = static_cast<double>(centrexywh[2]) * scale;
-            temp[3] = static_cast<double>(centrexywh[3]) * scale;
-            temp[4] = centrexywh[4];
-            temp[5] = centrexywh[5];
-            for (size_t i = 0; i < (centrexywh.size() - 6) / 3; i++)
+            float centre_x = detections.x[i];
+            float centre_y = detections.y[i];
+            float w = detections.w[i];
+            float h = detections.h[i];
+            detections.x[i] = static_cast<double>((centre_x - w / 2) - pad_w) * scale;
+            detections.y[i] = static_cast<double>((centre_y - h / 2) - pad_h) * scale;
+            detections.w[i] = static_cast<double>(w) * scale;
+            detections.h[i] = static_cast<double>(h) * scale;
+
+            float* key_points = detections.key_points_of(i);
+            for (int k = 0; k < detections.key_point_count(); k++)
             {
-                temp[6 + i * 3 + 0] = (temp[6 + i * 3 + 0] - pad_w) * scale;
-                temp[6 + i * 3 + 1] = (temp[6 + i * 3 + 1] - pad_h) * scale;
+                key_points[k * detection_batch::key_point_stride + 0] = (key_points[k * detection_batch::key_point_stride + 0] - pad_w) * scale;
+                key_points[k * detection_batch::key_point_stride + 1] = (key_points[k * detection_batch::key_point_stride + 1] - pad_h) * scale;
             }
-
-            output.push_back(temp);
         }
-        return output;
     }
 
     float intersectionOverUnion(const Box& box1, const Box& box2) {
@@ -200,105 +399,289 @@ public:
         return intersection_area / union_area;
     }
 
-    std::vector<int> object_nms(const std::vector<Box>& boxes, float iou_threshold)
+    float intersectionOverUnion(const detection_batch& boxes, int a, int b) {
+        float x1 = std::max(boxes.x[a], boxes.x[b]);
+        float y1 = std::max(boxes.y[a], boxes.y[b]);
+        float x2 = std::min(boxes.x[a] + boxes.w[a], boxes.x[b] + boxes.w[b]);
+        float y2 = std::min(boxes.y[a] + boxes.h[a], boxes.y[b] + boxes.h[b]);
+
+        if (x1 >= x2 || y1 >= y2) {
+            return 0.0f;
+        }
+
+        float intersection_area = (x2 - x1) * (y2 - y1);
+        float area1 = boxes.w[a] * boxes.h[a];
+        float area2 = boxes.w[b] * boxes.h[b];
+        float union_area = area1 + area2 - intersection_area;
+
+        return intersection_area / union_area;
+    }
+
+    // 返回保留框的下标 (按分数降序), 不同类别互不抑制; 结果引用内部缓冲区, 下一次调用前有效.
+    // soft_* 与 matrix 方式会把衰减后的分数写回 boxes.score
+    const std::vector<int>& object_nms(detection_batch& boxes, float iou_threshold)
     {
-        std::vector<int> indices(boxes.size());
-        for (size_t i = 0; i < boxes.size(); i++)
-            indices[i] = i;
+        return nms_.run(boxes, iou_threshold, nms_param_);
+    }
 
-        std::vector<float> scores;
-        for (size_t i = 0; i < boxes.size(); ++i)
-            scores.push_back(boxes[i][4]);
+    // template<typename Pipeline_Type>
+    // class CheckDerived : public std::conditional<std::is_base_of< glasssix::rknnwrapper::rknn_wrapper, Pipeline_Type>::value, std::true_type, std::false_type>::type { };
 
-        std::sort(indices.begin(), indices.end(), [&scores](int a, int b) {
-            return scores[a] > scores[b];
-            });
 
-        std::vector<int> keep;
-        while (indices.size() > 0)
-        {
-            int idx = indices[0];
-            keep.push_back(idx);
+    // 获取检测到的对象. 单帧时预处理、推理、后处理只能依次执行, 多帧请用下面的重载
+    std::vector<ObjectInfo> get_objects(cv::Mat image, float conf = 0.5, float iou_threshold = 0.65)
+    {
+        auto model_results = infer(image);
+
+        std::lock_guard<std::mutex> lock(decode_mutex_);
+        decode(model_results, conf);
+        return objects_from_candidates(detections_, image, iou_threshold, pic_process_param_);
+    };
 
-            std::vector<int> new_indices;
-            for (size_t i = 1; i < indices.size(); ++i)
+    // 多帧检测, 结果与逐帧调用 get_objects 相同. 流水线支持 forward_async 时前后帧重叠:
+    // 第 i 帧在 NPU 上推理时, 调用线程 letterbox 第 i + 1 帧, 然后解码第 i 帧
+    std::vector<std::vector<ObjectInfo>> get_objects(const std::vector<cv::Mat>& images, float conf = 0.5, float iou_threshold = 0.65)
+    {
+        std::vector<std::vector<ObjectInfo>> results;
+        results.reserve(images.size());
+        if constexpr (yolo_wrapper::has_forward_async<std::decay_t<decltype(*pipeline)>>::value)
+        {
+            std::future<std::vector<ObjectInfo>> pending;
+            for (const cv::Mat& image : images)
             {
-                int cur_idx = indices[i];
-                if (intersectionOverUnion(boxes[idx], boxes[cur_idx]) <= iou_threshold)
-                    new_indices.push_back(cur_idx);
+                auto next = get_objects_async(image, conf, iou_threshold);
+                if (pending.valid())
+                    results.push_back(pending.get());
+                pending = std::move(next);
             }
-            indices = new_indices;
+            if (pending.valid())
+                results.push_back(pending.get());
+        }
+        else
+        {
+            for (const cv::Mat& image : images)
+                results.push_back(get_objects(image, conf, iou_threshold));
         }
-        return keep;
+        return results;
     }
 
-    void box_result_move_to_disjoint_region(std::vector<std::vector<float>>& sou_data, int bias = 100000)
+    // 与 get_objects 相同, 但不构造 ObjectInfo: 目标逐个交给 sink (参数见 visit_candidates), 便于写入调用方复用的结果区
+    template <typename Sink>
+    void get_objects(const cv::Mat& image, float conf, float iou_threshold, Sink&& sink)
     {
-        for (size_t i = 0; i < sou_data.size(); i++)
-            sou_data[i][0] = sou_data[i][0] + sou_data[i][5] * bias;
+        auto model_results = infer(image);
+
+        std::lock_guard<std::mutex> lock(decode_mutex_);
+        decode(model_results, conf);
+        visit_candidates(detections_, image.cols, image.rows, iou_threshold, pic_process_param_, std::forward<Sink>(sink));
     }
 
-    // template<typename Pipeline_Type>  
-    // class CheckDerived : public std::conditional<std::is_base_of< glasssix::rknnwrapper::rknn_wrapper, Pipeline_Type>::value, std::true_type, std::false_type>::type { }; 
+    // 多帧一次推理: 各帧 letterbox 到连续的输入缓冲区, 由 pipeline 的多帧 forward 按模型 batch 分块运行, 然后逐帧解码.
+    // 结果与逐帧调用 get_objects 相同, 逐个交给 sink(frame, x1, y1, x2, y2, category, score, key_points, key_point_count)
+    template <typename Sink>
+    void get_objects_batch(const std::vector<cv::Mat>& images, float conf, float iou_threshold, Sink&& sink)
+    {
+        if (images.empty())
+            return;
 
+        int count = static_cast<int>(images.size());
+        batch_input_.create(count * model_input_height_, model_input_width_, CV_8UC3);
+        batch_params_.resize(count);
+        for (int i = 0; i < count; i++)
+        {
+            cv::Mat input_image(model_input_height_, model_input_width_, CV_8UC3, batch_input_.ptr(i * model_input_height_));
+            preprocess_detection(images[i], input_image);
+            batch_params_[i] = pic_process_param_;
+        }
 
-    // 获取检测到的对象
-    std::vector<ObjectInfo> get_objects(cv::Mat image, float conf = 0.5, float iou_threshold = 0.65)
+        auto model_results = pipeline->forward(batch_input_.data, std::vector<int>{ count, model_input_height_, model_input_width_, 3 }, RKNN_TENSOR_NHWC);
+
+        std::lock_guard<std::mutex> lock(decode_mutex_);
+        for (int i = 0; i < count; i++)
+        {
+            auto frame_results = count == 1 ? model_results : yolo_wrapper::sample_outputs(model_results, i);
+            decode(frame_results, conf);
+            visit_candidates(detections_, images[i].cols, images[i].rows, iou_threshold, batch_params_[i],
+                [&sink, i](auto... object) { sink(static_cast<size_t>(i), object...); });
+        }
+    }
+
+    // 多个模型共用一次预处理: input 是调用方已按 input_size() letterbox 好的模型输入, 只读, 可被多个实例同时使用;
+    // param 为这次 letterbox 的缩放与填充, image_size 为原图尺寸. 结果同样逐个交给 sink
+    template <typename Sink>
+    void get_objects_prepared(const cv::Mat& input, const pic_process_param& param, cv::Size image_size, float conf, float iou_threshold, Sink&& sink)
+    {
+        cv::Mat input_image = input;
+        auto model_results = pipeline->forward(input_image);
+
+        std::lock_guard<std::mutex> lock(decode_mutex_);
+        decode(model_results, conf);
+        visit_candidates(detections_, image_size.width, image_size.height, iou_threshold, param, std::forward<Sink>(sink));
+    }
+
+    cv::Size input_size() const
+    {
+        return cv::Size(model_input_width_, model_input_height_);
+    }
+
+    // 异步获取检测对象: 预处理后立即提交推理并返回, 调用方可以继续准备下一帧.
+    // 后处理在 get() 时于调用线程执行, 同一时刻最多两帧在 NPU 上排队.
+    // get_objects* 由一个线程调用; future 可交给其他线程 get(), 解码在 decode_mutex_ 下进行. 实例须活到 future 取完结果
+    std::future<std::vector<ObjectInfo>> get_objects_async(cv::Mat image, float conf = 0.5, float iou_threshold = 0.65)
     {
-        std::vector<ObjectInfo> out;
         auto new_shape = cv::Size(model_input_width_, model_input_height_);
         preprocess_detection(image, new_shape);
-        
-        cv::imwrite("./test.jpg",infer_image);
 
-        auto model_results = pipeline->forward(infer_image);    // 最好做编译器检查 检查是不是pipeline是不是genpipeline继承类
+        auto model_results = pipeline->forward_async(infer_image);
+        pic_process_param param = pic_process_param_;
 
-        std::vector<std::shared_ptr<memory::tensor<float>>> model_results_vector = sort_model_result(model_results);
+        return std::async(std::launch::deferred, [this, model_results, image, conf, iou_threshold, param]() {
+            auto results = model_results.get();
 
-        auto real_output = yoloconcat(model_results_vector, conf);
+            std::lock_guard<std::mutex> lock(decode_mutex_);
+            decode(results, conf);
+            return objects_from_candidates(detections_, image, iou_threshold, param);
+            });
+    }
+
+protected:
+    // 分数 [classes][cells] 阈值筛选, 候选写入 candidate_index_ / candidate_label_ 的前若干个并返回个数.
+    // 两个缓冲区只扩不缩, 多余部分不清零
+    template <typename ClassCount = int>
+    size_t select_candidates(const float* scores, size_t cells, ClassCount classes, float threshold)
+    {
+        return select_candidates(scores, cells, 0, cells, classes, threshold, candidate_index_, candidate_label_);
+    }
+
+    // 只筛选格子 [cell_begin, cell_end), 结果写入给定的缓冲区; 可在多个线程上对不同缓冲区同时调用.
+    // scores 为 float 或 int8 (threshold 为量化域阈值, 见 yolo_wrapper::int8_elements)
+    template <typename Element, typename ClassCount, typename Threshold>
+    size_t select_candidates(const Element* scores, size_t cell_stride, size_t cell_begin, size_t cell_end, ClassCount classes, Threshold threshold,
+        std::vector<int>& candidate_index, std::vector<int>& candidate_label) const
+    {
+        bool best_class = best_class_only_ && classes > 1;
+        size_t cells = cell_end - cell_begin;
+        size_t capacity = best_class ? cells : cells * classes;
+        if (candidate_index.size() < capacity)
+        {
+            candidate_index.resize(capacity);
+            candidate_label.resize(capacity);
+        }
+
+        if (best_class)
+            return yolo_wrapper::threshold_compact_best_class(scores, cell_stride, cell_begin, cell_end, classes, threshold, candidate_index.data(), candidate_label.data());
+        return yolo_wrapper::threshold_compact(scores, cell_stride, cell_begin, cell_end, classes, threshold, candidate_index.data(), candidate_label.data());
+    }
+
+    // 执行 task_count 个解码任务, 任务 i 写入自己的检测框 task_detections_[i].
+    // 任务划分只取决于输出形状, 所以结果与线程数和调度无关
+    template <typename Decode>
+    void decode_tasks(size_t task_count, int key_point_count, Decode&& decode)
+    {
+        if (task_detections_.size() < task_count)
+            task_detections_.resize(task_count);
+
+        auto run = [this, key_point_count, &decode](size_t task) {
+            task_detections_[task].reset(key_point_count);
+            decode(task, task_detections_[task]);
+        };
+        if (parallel_decode_)
+            work_stealing_pool::instance().parallel_for(task_count, run);
+        else
+            for (size_t task = 0; task < task_count; task++)
+                run(task);
+    }
+
+    // 按任务顺序合并, 适用于整层串行扫描本就按格子顺序输出的解码
+    template <typename Decode>
+    void run_decode_tasks(size_t task_count, detection_batch& detections, Decode&& decode)
+    {
+        decode_tasks(task_count, detections.key_point_count(), decode);
+        for (size_t task = 0; task < task_count; task++)
+            detections.append(task_detections_[task]);
+    }
+
+    // 合并同一层的任务 [task_begin, task_end), 每个任务内按类别升序: 逐类别依次取各任务的这一段,
+    // 得到与整层一次 threshold_compact 相同的类别优先顺序, NMS 同分时的取舍因此与串行解码一致
+    void append_class_major(size_t task_begin, size_t task_end, int classes, detection_batch& detections)
+    {
+        merge_cursors_.assign(task_end - task_begin, 0);
+        for (int label = 0; label < classes; label++)
+            for (size_t task = task_begin; task < task_end; task++)
+            {
+                const detection_batch& part = task_detections_[task];
+                size_t& first = merge_cursors_[task - task_begin];
+                size_t last = first;
+                while (last < part.size() && part.label[last] == label)
+                    last++;
+                detections.append(part, first, last - first);
+                first = last;
+            }
+    }
 
-        auto nms_input = centre_xywh2WH(real_output, pic_process_param_.pad_h, pic_process_param_.pad_w, 1.f / pic_process_param_.ratio);
+    // 预处理、推理, 返回模型输出
+    std::unordered_map<std::string, std::shared_ptr<memory::tensor<float>>> infer(const cv::Mat& image)
+    {
+        auto new_shape = cv::Size(model_input_width_, model_input_height_);
+        cv::Mat input_image = model_input(new_shape);
+        preprocess_detection(image, input_image);
 
-        box_result_move_to_disjoint_region(nms_input, 100000);
+        if (debug_dump::instance().accept("model_input"))
+            debug_dump::instance().submit("model_input", input_image.clone());
 
-        auto nms_result_index = object_nms(nms_input, iou_threshold);
+        return pipeline->forward(input_image);    // 最好做编译器检查 检查是不是pipeline是不是genpipeline继承类
+    }
+
+    // 解码, 候选框写入 detections_; 调用方持有 decode_mutex_
+    void decode(std::unordered_map<std::string, std::shared_ptr<memory::tensor<float>>>& model_results, float conf)
+    {
+        std::vector<std::shared_ptr<memory::tensor<float>>> model_results_vector = sort_model_result(model_results);
+        yoloconcat(model_results_vector, conf, detections_);
+    }
+
+    // 候选框 -> 原图坐标、NMS, 保留的目标裁剪到图像范围内后逐个交给 sink:
+    // sink(x1, y1, x2, y2, category, score, key_points, key_point_count), key_points 为 (x, y, score) 连续存放
+    template <typename Sink>
+    void visit_candidates(detection_batch& detections, int image_cols, int image_rows, float iou_threshold, const pic_process_param& param, Sink&& sink)
+    {
+        centre_xywh2WH(detections, param.pad_h, param.pad_w, 1.f / param.ratio);
+
+        const std::vector<int>& nms_result_index = object_nms(detections, iou_threshold);
 
-        box_result_move_to_disjoint_region(nms_input, -100000);
         for (size_t i = 0; i < nms_result_index.size(); i++)
         {
             int index = nms_result_index[i];
-            std::vector<key_point> key_points;
-            const size_t offset = 6;
-            const size_t step = 3;
-
-            for (size_t i = 0; i < (nms_input[index].size() - offset) / step; ++i) {
-                key_points.emplace_back(
-                    yolo_wrapper::safe_region(nms_input[index][offset + i * step], image.cols),
-                    yolo_wrapper::safe_region(nms_input[index][offset + i * step + 1], image.rows),
-                    nms_input[index][offset + i * step + 2]
-                );
-            }
+            float* key_point_data = detections.key_points_of(index);
+            const size_t step = detection_batch::key_point_stride;
 
-            out.emplace_back(yolo_wrapper::safe_region(nms_input[index][0], image.cols), yolo_wrapper::safe_region(nms_input[index][1], image.rows), yolo_wrapper::safe_region(nms_input[index][0] + nms_input[index][2], image.cols), yolo_wrapper::safe_region(nms_input[index][1] + nms_input[index][3], image.rows),
-                std::round(nms_input[index][5]), nms_input[index][4], key_points
-            );
-            // cv::rectangle(image, cv::Point(int(nms_input[index][0]), int(nms_input[index][1])), 
-                    // cv::Point(int(nms_input[index][0]+nms_input[index][2]), int(nms_input[index][1]+nms_input[index][3])), cv::Scalar(0, 255, 255), 2);
-            // for (size_t j = 0; j < key_points.size(); j++)
-            //     cv::circle(image, cv::Point((int)key_points[j].x, (int)key_points[j].y), 3, cv::Scalar(0, 0, 255), 2);
+            for (size_t k = 0; k < detections.key_point_count(); ++k) {
+                key_point_data[k * step] = yolo_wrapper::safe_region(key_point_data[k * step], image_cols);
+                key_point_data[k * step + 1] = yolo_wrapper::safe_region(key_point_data[k * step + 1], image_rows);
+            }
 
+            sink(yolo_wrapper::safe_region(detections.x[index], image_cols), yolo_wrapper::safe_region(detections.y[index], image_rows), yolo_wrapper::safe_region(detections.x[index] + detections.w[index], image_cols), yolo_wrapper::safe_region(detections.y[index] + detections.h[index], image_rows),
+                detections.label[index], detections.score[index], static_cast<const float*>(key_point_data), detections.key_point_count());
         }
+    }
 
-        // cv::imwrite("0429.jpg", image);
-
+    std::vector<ObjectInfo> objects_from_candidates(detection_batch& detections, const cv::Mat& image, float iou_threshold, const pic_process_param& param)
+    {
+        std::vector<ObjectInfo> out;
+        visit_candidates(detections, image.cols, image.rows, iou_threshold, param,
+            [&out](int x1, int y1, int x2, int y2, int category, float score, const float* key_point_data, int key_point_count) {
+                std::vector<key_point> key_points;
+                key_points.reserve(key_point_count);
+                for (int i = 0; i < key_point_count; ++i)
+                    key_points.emplace_back(key_point_data[i * 3], key_point_data[i * 3 + 1], key_point_data[i * 3 + 2]);
+                out.emplace_back(x1, y1, x2, y2, category, score, key_points);
+            });
         return out;
-
-    };
+    }
 
 };
 
-// YOLO 版本 8
-template <typename T, bool Exception = false, bool Posture = false>
+// YOLO 版本 8; Head 为编译期输出头描述 (yolo_wrapper::yolov8_head), 输出与之一致时按常量几何解码, 否则走运行时解码
+template <typename T, bool Exception = false, bool Posture = false, typename Head = void>
 class Yolov8 : public YoloBase< std::shared_ptr<T> > {
 public:
 
@@ -334,151 +717,390 @@ public:
         return output;
     }
 
-    std::vector<std::vector<float>> yoloconcat(std::vector<std::shared_ptr<memory::tensor<float>>>& outs, float conf) override
+    void yoloconcat(std::vector<std::shared_ptr<memory::tensor<float>>>& outs, float conf, detection_batch& detections) override
     {
+        if constexpr (!std::is_void_v<Head>)
+        {
+            static_assert((Head::key_points > 0) == Posture, "posture models need a head with key points, detection models one without.");
+            if (Head::matches(outs, Exception ? 2 : 3))
+            {
+                yolov8concat_fixed(outs, conf, detections, std::make_integer_sequence<int, Head::levels>());
+                return;
+            }
+        }
+
         if constexpr (Posture)
-            return yolov8concat_posture(outs, conf);
+            yolov8concat_posture(outs, conf, detections);
         else
-            return yolov8concat_general(outs, conf);
+            yolov8concat_general(outs, conf, detections);
     }
 
-    std::vector<std::vector<float>> yolov8concat_posture(std::vector<std::shared_ptr<memory::tensor<float>>>& outs, float conf)
+    void yolov8concat_posture(std::vector<std::shared_ptr<memory::tensor<float>>>& outs, float conf, detection_batch& detections)
     {
         conf = yolo_wrapper::de_sigmoid(conf);
         int category = outs[1]->channels() - 64;
-        std::vector<int> mul = { 32,16,8 };
-        std::vector<std::vector<float>> output_new;
+        static const int mul[] = { 32,16,8 };
+        int posture_channels = outs[0]->data_shape()[1];
+        if constexpr (Exception)
+            detections.reset(posture_channels / 2);
+        else
+            detections.reset(posture_channels / 3);
+
+        std::vector<int>& candicate_index = this->candidate_index_;
+        std::vector<int>& category_label = this->candidate_label_;
         for (size_t index = 0; index < outs.size(); index += 2)
         {
             auto& stride_data_xywh = outs[index + 1]; //get xywh data
             auto& stride_data_posture = outs[index];
 
-            auto data_shape = stride_data_xywh->data_shape();
-            auto posture_shape = stride_data_posture->data_shape();
+            const auto& data_shape = stride_data_xywh->data_shape();
+            const auto& posture_shape = stride_data_posture->data_shape();
             //CHECK_EQ(data_shape.size()，4);
             int slice_box_size = data_shape[data_shape.size() - 2] * data_shape[data_shape.size() - 1];
 
             const float* conf_ = stride_data_xywh->mutable_cpu_data() + slice_box_size * 64;
-            std::vector<int> candicate_index;
-            std::vector<int> category_label;
-            for (size_t slice_index = 0; slice_index < slice_box_size * category; slice_index++)
-                if (conf_[slice_index] > conf)
-                {
-                    candicate_index.push_back(slice_index % slice_box_size);
-                    category_label.push_back(slice_index / slice_box_size);
-                }
+            size_t candidate_num = this->select_candidates(conf_, slice_box_size, category, conf);
 
-            if (!candicate_index.size())  continue;
-            std::vector<float> reshape_box(slice_box_size * 64);
-            std::vector<float> posture_reshape_box(slice_box_size * 64);
-            yolo_wrapper::tranpose(stride_data_xywh->mutable_cpu_data(), reshape_box.data(), 64, slice_box_size);
-            yolo_wrapper::tranpose(stride_data_posture->mutable_cpu_data(), posture_reshape_box.data(), posture_shape[1], slice_box_size);
+            if (!candidate_num)  continue;
+            decode_dfl(stride_data_xywh->cpu_data(), slice_box_size, candicate_index.data(), candidate_num);
 
-            for (size_t index_current = 0; index_current < candicate_index.size(); index_current++)
+            // 关键点: 候选框稀疏时逐个按步长读取, 密集时先分块转置成 [cell][K]
+            const float* posture_nchw = stride_data_posture->cpu_data();
+            bool posture_dense = yolo_wrapper::candidates_dense(candidate_num, slice_box_size);
+            if (posture_dense)
+            {
+                posture_cells_.resize(static_cast<size_t>(posture_channels) * slice_box_size);
+                yolo_wrapper::transpose_blocked(posture_nchw, posture_cells_.data(), posture_channels, slice_box_size);
+            }
+            else
+            {
+                posture_cells_.resize(posture_channels);
+            }
+            detections.reserve(detections.size() + candidate_num);
+            for (size_t index_current = 0; index_current < candidate_num; index_current++)
             {
                 int slice_index = candicate_index[index_current];
-                std::vector<float> temp_data(64);
-                std::vector<float> centre_xywh(4, 0);
-                std::vector<float> out_centre_xywh(6 + posture_shape[1], 0);
-                if constexpr (Exception)
-                    out_centre_xywh.resize(6 + 3 * posture_shape[1] / 2);
+                const float* distance = dfl_distances_.data() + index_current;
+                float centre_xywh[4] = { distance[0], distance[candidate_num], distance[2 * candidate_num], distance[3 * candidate_num] };
+                size_t box = detections.push_back(
+                    ((centre_xywh[2] - centre_xywh[0]) / 2.f + slice_index % data_shape[data_shape.size() - 1] + 0.5f) * mul[index / 2],
+                    ((centre_xywh[3] - centre_xywh[1]) / 2.f + slice_index / data_shape[data_shape.size() - 1] + 0.5f) * mul[index / 2],
+                    (centre_xywh[2] + centre_xywh[0]) * mul[index / 2],
+                    (centre_xywh[3] + centre_xywh[1]) * mul[index / 2],
+                    yolo_wrapper::sigmoid_x(conf_[slice_index + slice_box_size * category_label[index_current]]),
+                    category_label[index_current]);
+                float* key_points = detections.key_points_of(box);
+
+                const float* posture_data2 = posture_cells_.data();
+                if (posture_dense)
+                    posture_data2 += static_cast<size_t>(posture_channels) * slice_index;
                 else
-                    out_centre_xywh.resize(6 + posture_shape[1]);
-
-                for (size_t softmaxmove = 0; softmaxmove < 4; softmaxmove++)
-                    yolo_wrapper::Softmax(reshape_box.data() + 64 * slice_index + softmaxmove * 16, temp_data.data() + softmaxmove * 16, 16);
-
-                for (int i = 0; i < 16; i++)
-                    for (int j = 0; j < 4; j++)
-                        centre_xywh[j * 1] = centre_xywh[j * 1] + temp_data[j * 16 + i] * i;
-                out_centre_xywh[0] = ((centre_xywh[2] - centre_xywh[0]) / 2.f + slice_index % data_shape[data_shape.size() - 1] + 0.5f) * mul[index / 2];
-                out_centre_xywh[1] = ((centre_xywh[3] - centre_xywh[1]) / 2.f + slice_index / data_shape[data_shape.size() - 1] + 0.5f) * mul[index / 2];
-                out_centre_xywh[2] = (centre_xywh[2] + centre_xywh[0]) * mul[index / 2];
-                out_centre_xywh[3] = (centre_xywh[3] + centre_xywh[1]) * mul[index / 2];
-                out_centre_xywh[4] = yolo_wrapper::sigmoid_x(conf_[slice_index + slice_box_size * category_label[index_current]]);
-                out_centre_xywh[5] = category_label[index_current];
-                float* posture_data2 = posture_reshape_box.data() + posture_shape[1] * slice_index;
+                    for (int channel = 0; channel < posture_channels; channel++)
+                        posture_cells_[channel] = posture_nchw[static_cast<size_t>(channel) * slice_box_size + slice_index];
 
                 if constexpr (Exception)
                     for (size_t key_point = 0; key_point < posture_shape[1] / 2; key_point++)
                     {
-                        out_centre_xywh[6 + key_point * 3 + 0] = (posture_data2[key_point * 2 + 0] * 2 + slice_index % data_shape[data_shape.size() - 1]) * mul[index / 2];
-                        out_centre_xywh[6 + key_point * 3 + 1] = (posture_data2[key_point * 2 + 1] * 2 + slice_index / data_shape[data_shape.size() - 1]) * mul[index / 2];
-                        out_centre_xywh[6 + key_point * 3 + 2] = 0.f;
+                        key_points[key_point * 3 + 0] = (posture_data2[key_point * 2 + 0] * 2 + slice_index % data_shape[data_shape.size() - 1]) * mul[index / 2];
+                        key_points[key_point * 3 + 1] = (posture_data2[key_point * 2 + 1] * 2 + slice_index / data_shape[data_shape.size() - 1]) * mul[index / 2];
+                        key_points[key_point * 3 + 2] = 0.f;
                     }
                 else
                     for (size_t key_point = 0; key_point < posture_shape[1] / 3; key_point++)
                     {
-                        out_centre_xywh[6 + key_point * 3 + 0] = (posture_data2[key_point * 3 + 0] * 2 + slice_index % data_shape[data_shape.size() - 1]) * mul[index / 2];
-                        out_centre_xywh[6 + key_point * 3 + 1] = (posture_data2[key_point * 3 + 1] * 2 + slice_index / data_shape[data_shape.size() - 1]) * mul[index / 2];
-                        out_centre_xywh[6 + key_point * 3 + 2] = yolo_wrapper::sigmoid_x(posture_data2[key_point * 3 + 2]);
+                        key_points[key_point * 3 + 0] = (posture_data2[key_point * 3 + 0] * 2 + slice_index % data_shape[data_shape.size() - 1]) * mul[index / 2];
+                        key_points[key_point * 3 + 1] = (posture_data2[key_point * 3 + 1] * 2 + slice_index / data_shape[data_shape.size() - 1]) * mul[index / 2];
+                        key_points[key_point * 3 + 2] = yolo_wrapper::sigmoid_x(posture_data2[key_point * 3 + 2]);
                     }
-
-                output_new.push_back(out_centre_xywh);
             }
         }
-        return output_new;
     }
 
 
-    std::vector<std::vector<float>> yolov8concat_general(std::vector<std::shared_ptr<memory::tensor<float>>>& outs, float conf)
+    void yolov8concat_general(std::vector<std::shared_ptr<memory::tensor<float>>>& outs, float conf, detection_batch& detections)
     {
         conf = yolo_wrapper::de_sigmoid(conf);
         int category = outs[0]->channels() - 64;
-        std::vector<int> mul = { 32,16,8,4 };
-        std::vector<std::vector<float>> output_new;
+        static const int mul[] = { 32,16,8,4 };
+        detections.reset();
+
+        general_tasks_.clear();
         for (size_t index = 0; index < outs.size(); index++)
+            add_general_tasks(general_tasks_, outs[index]->data_shape(), outs[index]->cpu_data(), mul[index], yolo_wrapper::float_elements{});
+        run_general_tasks(general_tasks_, category, conf, detections);
+    }
+
+    // 按 Head 解码: 每层单独实例化, 格子数、网格宽度、步长、通道偏移和关键点数都是编译期常量;
+    // 类别、DFL bin 与关键点的循环按 Head 的常量在编译期展开 (yolo_wrapper::static_for)
+    template <int... Levels>
+    void yolov8concat_fixed(std::vector<std::shared_ptr<memory::tensor<float>>>& outs, float conf, detection_batch& detections, std::integer_sequence<int, Levels...>)
+    {
+        conf = yolo_wrapper::de_sigmoid(conf);
+        detections.reset(Head::key_points);
+        (decode_fixed_level<Levels>(outs, conf, detections), ...);
+    }
+
+    template <int Level>
+    void decode_fixed_level(std::vector<std::shared_ptr<memory::tensor<float>>>& outs, float conf, detection_batch& detections)
+    {
+        constexpr int width = Head::grid_width(Level);
+        constexpr int cells = Head::cells(Level);
+        constexpr float stride = static_cast<float>(Head::stride(Level));
+        constexpr int key_point_values = Exception ? 2 : 3;
+        constexpr int posture_channels = Head::key_points * key_point_values;
+        // 无关键点的 Exception 模型类别分数在前, DFL 通道在后
+        constexpr bool scores_first = Exception && !Posture;
+
+        const float* data = outs[Posture ? Level * 2 + 1 : Level]->cpu_data();
+        const float* conf_ = scores_first ? data : data + static_cast<size_t>(cells) * Head::box_channels;
+        const float* box = scores_first ? data + static_cast<size_t>(cells) * Head::classes : data;
+
+        size_t candidate_num = this->select_candidates(conf_, cells, std::integral_constant<int, Head::classes>{}, conf);
+        if (!candidate_num)  return;
+        decode_dfl<Head::reg_max>(box, cells, this->candidate_index_.data(), candidate_num);
+
+        const float* posture_nchw = nullptr;
+        bool posture_dense = false;
+        if constexpr (Posture)
         {
-            auto& stride_data = outs[index];
-            auto data_shape = stride_data->data_shape();
-            int slice_box_size = data_shape[data_shape.size() - 2] * data_shape[data_shape.size() - 1];
+            posture_nchw = outs[Level * 2]->cpu_data();
+            posture_dense = yolo_wrapper::candidates_dense(candidate_num, cells);
+            posture_cells_.resize(posture_dense ? static_cast<size_t>(posture_channels) * cells : posture_channels);
+            if (posture_dense)
+                yolo_wrapper::transpose_blocked(posture_nchw, posture_cells_.data(), posture_channels, cells);
+        }
 
-            const float* conf_;
-            if constexpr (Exception)
-                conf_ = stride_data->mutable_cpu_data();
-            else
-                conf_ = stride_data->mutable_cpu_data() + slice_box_size * 64;
+        const int* candicate_index = this->candidate_index_.data();
+        const int* category_label = this->candidate_label_.data();
+        detections.reserve(detections.size() + candidate_num);
+        for (size_t index_current = 0; index_current < candidate_num; index_current++)
+        {
+            int slice_index = candicate_index[index_current];
+            int grid_x = slice_index % width;
+            int grid_y = slice_index / width;
+            const float* distance = dfl_distances_.data() + index_current;
+            float centre_xywh[4] = { distance[0], distance[candidate_num], distance[2 * candidate_num], distance[3 * candidate_num] };
+            size_t box_index = detections.push_back(
+                ((centre_xywh[2] - centre_xywh[0]) / 2.f + grid_x + 0.5f) * stride,
+                ((centre_xywh[3] - centre_xywh[1]) / 2.f + grid_y + 0.5f) * stride,
+                (centre_xywh[2] + centre_xywh[0]) * stride,
+                (centre_xywh[3] + centre_xywh[1]) * stride,
+                yolo_wrapper::sigmoid_x(conf_[slice_index + static_cast<size_t>(category_label[index_current]) * cells]),
+                category_label[index_current]);
+
+            if constexpr (Posture)
+            {
+                const float* posture_data = posture_cells_.data();
+                if (posture_dense)
+                    posture_data += static_cast<size_t>(posture_channels) * slice_index;
+                else
+                    for (int channel = 0; channel < posture_channels; channel++)
+                        posture_cells_[channel] = posture_nchw[static_cast<size_t>(channel) * cells + slice_index];
+
+                float* key_points = detections.key_points_of(box_index);
+                yolo_wrapper::static_for<0, Head::key_points>([&](auto key_point) {
+                    key_points[key_point * 3 + 0] = (posture_data[key_point * key_point_values + 0] * 2 + grid_x) * stride;
+                    key_points[key_point * 3 + 1] = (posture_data[key_point * key_point_values + 1] * 2 + grid_y) * stride;
+                    key_points[key_point * 3 + 2] = Exception ? 0.f : yolo_wrapper::sigmoid_x(posture_data[key_point * key_point_values + 2]);
+                    });
+            }
+        }
+    }
 
-            std::vector<int> candicate_index;
-            std::vector<int> category_label;
-            for (size_t slice_index = 0; slice_index < slice_box_size * category; slice_index++)
-                if (conf_[slice_index] > conf)
-                {
-                    candicate_index.push_back(slice_index % slice_box_size);
-                    category_label.push_back(slice_index / slice_box_size);
-                }
+    // int8 输出直接解码: 阈值在量化域比较, 只反量化通过阈值的候选框
+    std::vector<ObjectInfo> get_objects_quantized(cv::Mat image, float conf = 0.5, float iou_threshold = 0.65)
+    {
+        static_assert(!Posture, "get_objects_quantized only supports detection heads.");
+        this->preprocess_detection(image, cv::Size(this->model_input_width_, this->model_input_height_));
+
+        auto model_results = this->pipeline->forward_quantized(this->infer_image);
+        std::lock_guard<std::mutex> lock(this->decode_mutex_);
+
+        std::vector<rknnwrapper::quantized_tensor> outs;
+        for (auto& result : model_results)
+            if (model_results.size() <= 3 || result.second.data->data_shape()[3] != 1)
+                outs.push_back(result.second);
+        std::sort(outs.begin(), outs.end(), [](const rknnwrapper::quantized_tensor& a, const rknnwrapper::quantized_tensor& b) {
+            return a.data->count() < b.data->count();
+            });
+
+        yolov8concat_general_quantized(outs, conf, this->detections_);
+
+        return this->objects_from_candidates(this->detections_, image, iou_threshold, this->pic_process_param_);
+    }
+
+    // 与 yolov8concat_general 相同的解码, 元素按各层的 zp / scale 读取
+    void yolov8concat_general_quantized(std::vector<rknnwrapper::quantized_tensor>& outs, float conf, detection_batch& detections)
+    {
+        conf = yolo_wrapper::de_sigmoid(conf);
+        int category = outs[0].data->channels() - 64;
+        static const int mul[] = { 32,16,8,4 };
+        detections.reset();
+
+        quantized_tasks_.clear();
+        for (size_t index = 0; index < outs.size(); index++)
+            add_general_tasks(quantized_tasks_, outs[index].data->data_shape(), outs[index].data->cpu_data(), mul[index], yolo_wrapper::int8_elements{ outs[index].zp, outs[index].scale });
+        run_general_tasks(quantized_tasks_, category, conf, detections);
+    }
+
+protected:
+    // 并行解码的一个任务: 一层输出 (data, 宽 width, 共 cells 个格子, 步长 stride) 中连续若干行格子, 元素按 elements 读取
+    template <typename Elements>
+    struct decode_range
+    {
+        const typename Elements::value_type* data;
+        int width;
+        int cells;
+        int cell_begin;
+        int cell_end;
+        int stride;
+        Elements elements;
+    };
+
+    // 每个任务自己的复用缓冲区
+    struct decode_scratch
+    {
+        std::vector<int> candidate_index;
+        std::vector<int> candidate_label;
+        std::vector<float> dfl_bins;
+        std::vector<float> dfl_distances;
+        std::vector<float> dfl_cells;
+    };
 
-            if (!candicate_index.size())  continue;
-            std::vector<float> reshape_box(slice_box_size * 64);
-            if constexpr (Exception)
-                yolo_wrapper::tranpose(stride_data->mutable_cpu_data() + slice_box_size * category, reshape_box.data(), 64, slice_box_size);
+    std::vector<decode_range<yolo_wrapper::float_elements>> general_tasks_;
+    std::vector<decode_range<yolo_wrapper::int8_elements>> quantized_tasks_;
+    std::vector<decode_scratch> decode_scratch_;
+
+    // 一层输出按整行切成若干任务, 输出指针在调用线程上取好
+    template <typename Elements>
+    void add_general_tasks(std::vector<decode_range<Elements>>& tasks, const std::vector<int>& data_shape, const typename Elements::value_type* data, int stride, Elements elements)
+    {
+        int width = data_shape[data_shape.size() - 1];
+        int height = data_shape[data_shape.size() - 2];
+        int rows = std::max(1, this->decode_task_cells / width);
+        for (int row = 0; row < height; row += rows)
+            tasks.push_back({ data, width, width * height, row * width, std::min(height, row + rows) * width, stride, elements });
+    }
+
+    template <typename Elements>
+    void run_general_tasks(const std::vector<decode_range<Elements>>& tasks, int category, float conf, detection_batch& detections)
+    {
+        if (decode_scratch_.size() < tasks.size())
+            decode_scratch_.resize(tasks.size());
+
+        this->decode_tasks(tasks.size(), detections.key_point_count(), [this, &tasks, category, conf](size_t task, detection_batch& out) {
+            decode_general(tasks[task], category, conf, decode_scratch_[task], out);
+            });
+
+        // 每层的任务相邻; 只保留最高分类别时整层按格子顺序输出, 否则按类别优先合并
+        bool cell_order = this->best_class_only_ && category > 1;
+        for (size_t level_begin = 0; level_begin < tasks.size();)
+        {
+            size_t level_end = level_begin + 1;
+            while (level_end < tasks.size() && tasks[level_end].data == tasks[level_begin].data)
+                level_end++;
+            if (cell_order)
+                for (size_t task = level_begin; task < level_end; task++)
+                    detections.append(this->task_detections_[task]);
             else
-                yolo_wrapper::tranpose(stride_data->mutable_cpu_data(), reshape_box.data(), 64, slice_box_size);
+                this->append_class_major(level_begin, level_end, category, detections);
+            level_begin = level_end;
+        }
+    }
 
-            for (size_t index_current = 0; index_current < candicate_index.size(); index_current++)
-            {
-                int slice_index = candicate_index[index_current];
-                std::vector<float> temp_data(64);
-                std::vector<float> centre_xywh(4, 0);
-                std::vector<float> out_centre_xywh(6, 0);
-                for (size_t softmaxmove = 0; softmaxmove < 4; softmaxmove++)
-                    yolo_wrapper::Softmax(reshape_box.data() + 64 * slice_index + softmaxmove * 16, temp_data.data() + softmaxmove * 16, 16);
-
-                for (int i = 0; i < 16; i++)
-                    for (int j = 0; j < 4; j++)
-                        centre_xywh[j * 1] = centre_xywh[j * 1] + temp_data[j * 16 + i] * i;//             i*4*candidate_num+j ]*i; 
-                out_centre_xywh[0] = ((centre_xywh[2] - centre_xywh[0]) / 2.f + slice_index % data_shape[data_shape.size() - 1] + 0.5f) * mul[index];
-                out_centre_xywh[1] = ((centre_xywh[3] - centre_xywh[1]) / 2.f + slice_index / data_shape[data_shape.size() - 1] + 0.5f) * mul[index];
-                out_centre_xywh[2] = (centre_xywh[2] + centre_xywh[0]) * mul[index];
-                out_centre_xywh[3] = (centre_xywh[3] + centre_xywh[1]) * mul[index];
-                out_centre_xywh[4] = yolo_wrapper::sigmoid_x(conf_[slice_index + category_label[index_current] * slice_box_size]);
-                out_centre_xywh[5] = category_label[index_current];
-                output_new.push_back(out_centre_xywh);
-            }
+    // 一层输出中格子 [cell_begin, cell_end) 的筛选与解码
+    template <typename Elements>
+    void decode_general(const decode_range<Elements>& range, int category, float conf, decode_scratch& scratch, detection_batch& detections) const
+    {
+        int slice_box_size = range.cells;
+
+        const typename Elements::value_type* conf_;
+        const typename Elements::value_type* box;
+        if constexpr (Exception)
+        {
+            conf_ = range.data;
+            box = range.data + static_cast<size_t>(slice_box_size) * category;
+        }
+        else
+        {
+            conf_ = range.data + static_cast<size_t>(slice_box_size) * 64;
+            box = range.data;
+        }
+
+        size_t candidate_num = this->select_candidates(conf_, slice_box_size, range.cell_begin, range.cell_end, category, range.elements.threshold(conf), scratch.candidate_index, scratch.candidate_label);
+        if (!candidate_num)  return;
+        decode_dfl(box, slice_box_size, range.cell_begin, range.cell_end, scratch.candidate_index.data(), candidate_num, scratch.dfl_bins, scratch.dfl_distances, scratch.dfl_cells, range.elements);
+
+        const int* candicate_index = scratch.candidate_index.data();
+        const int* category_label = scratch.candidate_label.data();
+        detections.reserve(candidate_num);
+        for (size_t index_current = 0; index_current < candidate_num; index_current++)
+        {
+            int slice_index = candicate_index[index_current];
+            const float* distance = scratch.dfl_distances.data() + index_current;
+            float centre_xywh[4] = { distance[0], distance[candidate_num], distance[2 * candidate_num], distance[3 * candidate_num] };
+            detections.push_back(
+                ((centre_xywh[2] - centre_xywh[0]) / 2.f + slice_index % range.width + 0.5f) * range.stride,
+                ((centre_xywh[3] - centre_xywh[1]) / 2.f + slice_index / range.width + 0.5f) * range.stride,
+                (centre_xywh[2] + centre_xywh[0]) * range.stride,
+                (centre_xywh[3] + centre_xywh[1]) * range.stride,
+                yolo_wrapper::sigmoid_x(range.elements(conf_[slice_index + category_label[index_current] * slice_box_size])),
+                category_label[index_current]);
+        }
+    }
+
+    // 后处理的复用缓冲区: 候选框的 64 个通道按通道存放, 解出的四条边距离, 密集时全部格子的距离, 关键点
+    std::vector<float> dfl_bins_;
+    std::vector<float> dfl_distances_;
+    std::vector<float> dfl_cells_;
+    std::vector<float> posture_cells_;
+
+    // box 为 NCHW 输出中的 4 * Bins 个 DFL 通道 [4 * Bins][cell]; 结果为 dfl_distances_[side * n + k].
+    // 候选框稀疏时只按步长收集候选格子的通道; 密集时直接在 NCHW 上解码全部格子再取出, 都不做整体转置.
+    template <int Bins = yolo_wrapper::dfl_bins>
+    void decode_dfl(const float* box, int slice_box_size, const int* candicate_index, size_t candidate_num)
+    {
+        decode_dfl<Bins>(box, slice_box_size, 0, slice_box_size, candicate_index, candidate_num, dfl_bins_, dfl_distances_, dfl_cells_);
+    }
+
+    // 只涉及格子 [cell_begin, cell_end) 的版本, 缓冲区由调用方提供, 可在多个线程上同时调用
+    template <int Bins = yolo_wrapper::dfl_bins>
+    static void decode_dfl(const float* box, int slice_box_size, int cell_begin, int cell_end, const int* candicate_index, size_t candidate_num,
+        std::vector<float>& dfl_bins, std::vector<float>& dfl_distances, std::vector<float>& dfl_cells)
+    {
+        constexpr int dfl_channels = 4 * Bins;
+        int cells = cell_end - cell_begin;
+        dfl_distances.resize(4 * candidate_num);
+        if (yolo_wrapper::candidates_dense(candidate_num, cells))
+        {
+            dfl_cells.resize(4 * static_cast<size_t>(cells));
+            yolo_wrapper::dfl_distances<Bins>(box + cell_begin, slice_box_size, cells, dfl_cells.data(), cells);
+            for (int side = 0; side < 4; side++)
+                for (size_t k = 0; k < candidate_num; k++)
+                    dfl_distances[side * candidate_num + k] = dfl_cells[static_cast<size_t>(side) * cells + candicate_index[k] - cell_begin];
+            return;
         }
-        return output_new;
+
+        dfl_bins.resize(dfl_channels * candidate_num);
+        yolo_wrapper::gather_columns(box, dfl_channels, slice_box_size, candicate_index, candidate_num, dfl_bins.data());
+        yolo_wrapper::dfl_distances<Bins>(dfl_bins.data(), candidate_num, candidate_num, dfl_distances.data(), candidate_num);
     }
 
+    static void decode_dfl(const float* box, int slice_box_size, int cell_begin, int cell_end, const int* candicate_index, size_t candidate_num,
+        std::vector<float>& dfl_bins, std::vector<float>& dfl_distances, std::vector<float>& dfl_cells, const yolo_wrapper::float_elements&)
+    {
+        decode_dfl(box, slice_box_size, cell_begin, cell_end, candicate_index, candidate_num, dfl_bins, dfl_distances, dfl_cells);
+    }
+
+    // int8 输出: 只反量化候选框的通道, 再按稀疏方式解码
+    static void decode_dfl(const int8_t* box, int slice_box_size, int cell_begin, int cell_end, const int* candicate_index, size_t candidate_num,
+        std::vector<float>& dfl_bins, std::vector<float>& dfl_distances, std::vector<float>& dfl_cells, const yolo_wrapper::int8_elements& elements)
+    {
+        dfl_distances.resize(4 * candidate_num);
+        dfl_bins.resize(yolo_wrapper::dfl_channels * candidate_num);
+        yolo_wrapper::gather_columns(box, yolo_wrapper::dfl_channels, slice_box_size, candicate_index, candidate_num, dfl_bins.data(), elements);
+        yolo_wrapper::dfl_distances(dfl_bins.data(), candidate_num, candidate_num, dfl_distances.data(), candidate_num);
+    }
 };
 
 template <typename T, bool Exception = false, bool Posture = false>
@@ -489,39 +1111,33 @@ public:
         YoloBase< std::shared_ptr<T>>(model_input_width, model_input_height, pipe) {}
 
 
-    std::vector<std::vector<float>> yoloconcat(std::vector<std::shared_ptr<memory::tensor<float>>>& outs, float conf_thres) 
+    void yoloconcat(std::vector<std::shared_ptr<memory::tensor<float>>>& outs, float conf_thres, detection_batch& detections)
     {
         // conf_thres = yolo_wrapper::de_sigmoid(conf_thres);
-        std::vector<std::vector<float>> output_new;
+        detections.reset();
 
-        auto data_shape = outs[0]->data_shape();
+        const auto& data_shape = outs[0]->data_shape();
         int category = data_shape[1] - 4;
         int object_length = data_shape[2];
 
         const float* ptr_out = outs[0]->cpu_data();
         const float* conf_ = ptr_out + object_length * 4;
 
-        std::vector<int> candicate_index;
-        std::vector<int> category_label;
-        for (size_t slice_index = 0; slice_index < object_length * category; slice_index++)
-            if (conf_[slice_index] > conf_thres)
-            {
-                candicate_index.push_back(slice_index % object_length);
-                category_label.push_back(slice_index / object_length);
-            }
+        std::vector<int>& candicate_index = this->candidate_index_;
+        std::vector<int>& category_label = this->candidate_label_;
+        size_t candidate_num = this->select_candidates(conf_, object_length, category, conf_thres);
 
-        for (size_t i = 0; i < candicate_index.size(); i++)
+        detections.reserve(candidate_num);
+        for (size_t i = 0; i < candidate_num; i++)
         {
-            std::vector<float> out_centre_xywh{ * (ptr_out + candicate_index[i]), * (ptr_out + candicate_index[i] + object_length ),
-                                                * (ptr_out + candicate_index[i] + object_length*2 ), * (ptr_out + candicate_index[i] + object_length * 3),
-                                                conf_[candicate_index[i] + category_label[i] * object_length],
-                                                category_label[i] };
-            output_new.push_back(out_centre_xywh);
+            detections.push_back(*(ptr_out + candicate_index[i]), *(ptr_out + candicate_index[i] + object_length),
+                                 *(ptr_out + candicate_index[i] + object_length * 2), *(ptr_out + candicate_index[i] + object_length * 3),
+                                 conf_[candicate_index[i] + category_label[i] * object_length],
+                                 category_label[i]);
         }
-        return output_new;
-    
+
     }
-    
+
 };
 
 template <typename T, bool Exception = false, bool Posture = false>
@@ -531,100 +1147,250 @@ public:
     Yolov7(int model_input_width, int model_input_height, std::shared_ptr<T> pipe) :
         YoloBase< std::shared_ptr<T>>(model_input_width, model_input_height, pipe) {}
 
-    std::vector<std::vector<float>> yoloconcat(std::vector<std::shared_ptr<memory::tensor<float>>>& outs, float conf) override
+    void yoloconcat(std::vector<std::shared_ptr<memory::tensor<float>>>& outs, float conf, detection_batch& detections) override
     {
         if constexpr (Posture)
-            return yolov7concat_posture(outs, conf);
+            yolov7concat_posture(outs, conf, detections);
         else
-            return yolov7concat_general(outs, conf);
+            yolov7concat_general(outs, conf, detections);
     }
 
-    std::vector<std::vector<float>> yolov7concat_posture(std::vector<std::shared_ptr<memory::tensor<float>>>& outs, float conf_thres)
+    void yolov7concat_posture(std::vector<std::shared_ptr<memory::tensor<float>>>& outs, float conf_thres, detection_batch& detections)
     {
-        const float anchors[3][6] = { {72,97, 123,164, 209,297}, {15,19, 23,30, 39,52},{4,5, 6,8, 10,12} };
-        const float stride[3] = { 32.0, 16.0, 8.0 };
-        std::vector<std::vector<float>> result;
+        const auto& first_shape = outs[0]->data_shape();
+        detections.reset((first_shape[first_shape.size() - 3] / 3 - 6) / 3);
+        decode_scratch& scratch = decode_scratch_.empty() ? decode_scratch_.emplace_back() : decode_scratch_[0];
+        // sigmoid(obj) >= 总分, 先在 logit 上筛掉 sigmoid(obj) <= conf 的格子
+        float object_thres = yolo_wrapper::de_sigmoid(conf_thres);
         for (int n = 0; n < 3; n++)
         {
-            auto data_shape = outs[n]->data_shape();
+            const auto& data_shape = outs[n]->data_shape();
             int width = data_shape[data_shape.size() - 1];
             int height = data_shape[data_shape.size() - 2];
             int object_length = data_shape[data_shape.size() - 3] / 3; // xywh scorebase s1 s2 ... sn
-            std::vector<float> reshape_data(outs[n]->count());
-            yolo_wrapper::transpose021(outs[n]->cpu_data(), reshape_data.data(), object_length, width * height);
-            float* ptr_out = reshape_data.data();
+            int key_point_count = (object_length - 6) / 3;
+            int area = width * height;
+            const level_table& table = update_table(n, width, height);
+            if (scratch.cells.size() < static_cast<size_t>(area))
+            {
+                scratch.cells.resize(area);
+                scratch.labels.resize(area);
+            }
+
+            // 输出按 [anchor][通道][格子] 存放, 不做转置, 直接在目标分数通道上做向量化筛选
             for (int q = 0; q < 3; q++)
             {
-                const float anchor_w = anchors[n][q * 2];
-                const float anchor_h = anchors[n][q * 2 + 1];
-                for (int i = 0; i < height; i++)
-                    for (int j = 0; j < width; j++)
+                const float* anchor_data = outs[n]->cpu_data() + static_cast<size_t>(q) * object_length * area;
+                size_t survivors = yolo_wrapper::threshold_compact(anchor_data + 4 * static_cast<size_t>(area), area, 1, object_thres,
+                    scratch.cells.data(), scratch.labels.data());
+                if (!survivors)
+                    continue;
+
+                // 只对留下的格子算 sigmoid: [0, survivors) 为目标分数, [survivors, 2 * survivors) 为类别分数
+                scratch.values.resize(2 * survivors);
+                for (size_t k = 0; k < survivors; k++)
+                {
+                    scratch.values[k] = anchor_data[4 * static_cast<size_t>(area) + scratch.cells[k]];
+                    scratch.values[survivors + k] = anchor_data[5 * static_cast<size_t>(area) + scratch.cells[k]];
+                }
+                yolo_wrapper::sigmoid_array(scratch.values.data(), scratch.values.data(), 2 * survivors);
+
+                // 命中的格子收集 x, y, w, h 与关键点分数, 一起算 sigmoid
+                size_t hit_length = 4 + key_point_count;
+                scratch.hit_cells.clear();
+                scratch.hit_scores.clear();
+                scratch.hit_values.clear();
+                for (size_t k = 0; k < survivors; k++)
+                {
+                    float score = scratch.values[k] * scratch.values[survivors + k];
+                    if (score <= conf_thres)
+                        continue;
+
+                    int cell = scratch.cells[k];
+                    scratch.hit_cells.push_back(cell);
+                    scratch.hit_scores.push_back(score);
+                    for (int channel = 0; channel < 4; channel++)
+                        scratch.hit_values.push_back(anchor_data[static_cast<size_t>(channel) * area + cell]);
+                    for (int key_point = 0; key_point < key_point_count; key_point++)
+                        scratch.hit_values.push_back(anchor_data[static_cast<size_t>(6 + key_point * 3 + 2) * area + cell]);
+                }
+                yolo_wrapper::sigmoid_array(scratch.hit_values.data(), scratch.hit_values.data(), scratch.hit_values.size());
+
+                for (size_t hit = 0; hit < scratch.hit_cells.size(); hit++)
+                {
+                    int cell = scratch.hit_cells[hit];
+                    int i = cell / width;
+                    int j = cell % width;
+                    const float* values = scratch.hit_values.data() + hit * hit_length;
+                    size_t box = detections.push_back(values[0] * table.stride2 + table.grid_x[j], values[1] * table.stride2 + table.grid_y[i],
+                        values[2] * values[2] * table.anchor_w[q], values[3] * values[3] * table.anchor_h[q], scratch.hit_scores[hit], 0);
+                    float* key_points = detections.key_points_of(box);
+                    for (int k = 0; k < key_point_count; k++)
                     {
-                        float box_score = yolo_wrapper::sigmoid_x(ptr_out[4]);
-                        if (box_score * yolo_wrapper::sigmoid_x(ptr_out[5]) > conf_thres)
-                        {
-                            float cx = (yolo_wrapper::sigmoid_x(ptr_out[0]) * 2.f - 0.5f + j) * stride[n];  // cx
-                            float cy = (yolo_wrapper::sigmoid_x(ptr_out[1]) * 2.f - 0.5f + i) * stride[n];  // cy
-                            float w = powf(yolo_wrapper::sigmoid_x(ptr_out[2]) * 2.f, 2.f) * anchor_w;      // w
-                            float h = powf(yolo_wrapper::sigmoid_x(ptr_out[3]) * 2.f, 2.f) * anchor_h;      // h
-                            std::vector<float> element = { cx, cy, w, h, box_score * yolo_wrapper::sigmoid_x(ptr_out[5]), 0 };
-                            for (size_t k = 0; k < (object_length - 6) / 3; k++)
-                            {
-                                element.push_back((ptr_out[6 + k * 3 + 0] * 2.f - 0.5f + j) * stride[n]);
-                                element.push_back((ptr_out[6 + k * 3 + 1] * 2.f - 0.5f + i) * stride[n]);
-                                element.push_back(yolo_wrapper::sigmoid_x(ptr_out[6 + k * 3 + 2]));
-                            }
-                            result.push_back(element);
-                        }
-                        ptr_out += object_length;
+                        key_points[k * 3 + 0] = anchor_data[static_cast<size_t>(6 + k * 3 + 0) * area + cell] * table.stride2 + table.grid_x[j];
+                        key_points[k * 3 + 1] = anchor_data[static_cast<size_t>(6 + k * 3 + 1) * area + cell] * table.stride2 + table.grid_y[i];
+                        key_points[k * 3 + 2] = values[4 + k];
                     }
+                }
             }
         }
-        return result;
     }
 
-    std::vector<std::vector<float>> yolov7concat_general(std::vector<std::shared_ptr<memory::tensor<float>>>& outs, float conf_thres)
+    void yolov7concat_general(std::vector<std::shared_ptr<memory::tensor<float>>>& outs, float conf_thres, detection_batch& detections)
     {
-        const float anchors[3][6] = { {72,97, 123,164, 209,297}, {15,19, 23,30, 39,52},{4,5, 6,8, 10,12} };
-        const float stride[3] = { 32.0, 16.0, 8.0 };
-        std::vector<std::vector<float>> result;
+        detections.reset();
+
+        // 每层每个 anchor 按整行切成若干任务, 输出指针与网格表在调用线程上准备好
+        general_tasks_.clear();
         for (int n = 0; n < 3; n++)
         {
-            auto data_shape = outs[n]->data_shape();
+            const auto& data_shape = outs[n]->data_shape();
             int width = data_shape[data_shape.size() - 2];
             int height = data_shape[data_shape.size() - 3];
             int object_length = data_shape[data_shape.size() - 1];
-            std::vector<float> reshape_data(outs[n]->count());
-            // yolo_wrapper::transpose021(outs[n]->cpu_data(), reshape_data.data(), object_length, width*height);
-            const float* ptr_out = outs[n]->cpu_data();
+            update_table(n, width, height);
+            int rows = std::max(1, this->decode_task_cells / width);
+            const float* data = outs[n]->cpu_data();
             for (int q = 0; q < 3; q++)
+                for (int row = 0; row < height; row += rows)
+                    general_tasks_.push_back({ data, n, q, width, height, object_length, row, std::min(height, row + rows) });
+        }
+        if (decode_scratch_.size() < general_tasks_.size())
+            decode_scratch_.resize(general_tasks_.size());
+
+        this->run_decode_tasks(general_tasks_.size(), detections, [this, conf_thres](size_t task, detection_batch& out) {
+            decode_general(general_tasks_[task], conf_thres, decode_scratch_[task], out);
+            });
+    }
+
+protected:
+    static constexpr float anchors_[3][6] = { {72,97, 123,164, 209,297}, {15,19, 23,30, 39,52},{4,5, 6,8, 10,12} };
+    static constexpr float strides_[3] = { 32.0, 16.0, 8.0 };
+
+    // 每层的网格与 anchor 表, 输出尺寸不变时只建一次:
+    // cx = (2 * sigmoid(x) - 0.5 + j) * stride = sigmoid(x) * stride2 + grid_x[j], w = (2 * sigmoid(w))^2 * anchor = sigmoid(w)^2 * anchor_w
+    struct level_table
+    {
+        int width = 0;
+        int height = 0;
+        float stride2 = 0.f;
+        std::vector<float> grid_x;
+        std::vector<float> grid_y;
+        float anchor_w[3];
+        float anchor_h[3];
+    };
+
+    // 并行解码的一个任务: 第 n 层第 q 个 anchor 的 [row_begin, row_end) 行, 输出按 [anchor][行][列][object_length] 存放
+    struct decode_range
+    {
+        const float* data;
+        int n;
+        int q;
+        int width;
+        int height;
+        int object_length;
+        int row_begin;
+        int row_end;
+    };
+
+    // 每个任务自己的复用缓冲区: 过了目标分数阈值的格子, 命中的 (格子, 类别) 及其待算 sigmoid 的值
+    struct decode_scratch
+    {
+        std::vector<int> cells;
+        std::vector<int> labels;
+        std::vector<float> values;
+        std::vector<int> hit_cells;
+        std::vector<int> hit_labels;
+        std::vector<float> hit_scores;
+        std::vector<float> hit_values;
+    };
+
+    level_table level_tables_[3];
+    std::vector<decode_range> general_tasks_;
+    std::vector<decode_scratch> decode_scratch_;
+
+    const level_table& update_table(int n, int width, int height)
+    {
+        level_table& table = level_tables_[n];
+        if (table.width == width && table.height == height)
+            return table;
+
+        float stride = strides_[n];
+        table.width = width;
+        table.height = height;
+        table.stride2 = 2.f * stride;
+        table.grid_x.resize(width);
+        table.grid_y.resize(height);
+        for (int j = 0; j < width; j++)
+            table.grid_x[j] = (j - 0.5f) * stride;
+        for (int i = 0; i < height; i++)
+            table.grid_y[i] = (i - 0.5f) * stride;
+        for (int q = 0; q < 3; q++)
+        {
+            table.anchor_w[q] = 4.f * anchors_[n][q * 2];
+            table.anchor_h[q] = 4.f * anchors_[n][q * 2 + 1];
+        }
+        return table;
+    }
+
+    void decode_general(const decode_range& range, float conf_thres, decode_scratch& scratch, detection_batch& detections) const
+    {
+        const level_table& table = level_tables_[range.n];
+        const int width = range.width;
+        const int object_length = range.object_length;
+        const int cells = (range.row_end - range.row_begin) * width;
+        const float* base = range.data + static_cast<size_t>(range.q * range.height + range.row_begin) * width * object_length;
+
+        // sigmoid(obj) >= 总分, 先在 logit 上筛掉 sigmoid(obj) <= conf 的格子, 剩下的才算 sigmoid
+        float object_thres = yolo_wrapper::de_sigmoid(conf_thres);
+        scratch.cells.clear();
+        scratch.values.clear();
+        for (int cell = 0; cell < cells; cell++)
+        {
+            float object_score = base[static_cast<size_t>(cell) * object_length + 4];
+            if (object_score > object_thres)
             {
-                const float anchor_w = anchors[n][q * 2];
-                const float anchor_h = anchors[n][q * 2 + 1];
-                for (int i = 0; i < height; i++)
-                    for (int j = 0; j < width; j++)
-                    {
-                        float box_score = yolo_wrapper::sigmoid_x(ptr_out[4]);
-                        float temp_conf_thres = yolo_wrapper::de_sigmoid(conf_thres / box_score);
-                        for (size_t category = 5; category < object_length; category++)
-                        {
-                            if (ptr_out[category] > temp_conf_thres)
-                            {
-                                float cx = (yolo_wrapper::sigmoid_x(ptr_out[0]) * 2.f - 0.5f + j) * stride[n];  // cx
-                                float cy = (yolo_wrapper::sigmoid_x(ptr_out[1]) * 2.f - 0.5f + i) * stride[n];  // cy
-                                float w = powf(yolo_wrapper::sigmoid_x(ptr_out[2]) * 2.f, 2.f) * anchor_w;      // w
-                                float h = powf(yolo_wrapper::sigmoid_x(ptr_out[3]) * 2.f, 2.f) * anchor_h;      // h
-                                std::vector<float> element = { cx, cy, w, h, box_score * yolo_wrapper::sigmoid_x(ptr_out[category]), category - 5 };
-                                result.push_back(element);
-                            }
-                        }
-                        ptr_out += object_length;
-                    }
+                scratch.cells.push_back(cell);
+                scratch.values.push_back(object_score);
             }
         }
-        return result;
-    }
+        if (scratch.cells.empty())
+            return;
+        yolo_wrapper::sigmoid_array(scratch.values.data(), scratch.values.data(), scratch.values.size());
+
+        // 逐类别在 logit 上比较, 命中的 (格子, 类别) 收集 x, y, w, h 与类别分数, 一起算 sigmoid
+        scratch.hit_cells.clear();
+        scratch.hit_labels.clear();
+        scratch.hit_scores.clear();
+        scratch.hit_values.clear();
+        for (size_t k = 0; k < scratch.cells.size(); k++)
+        {
+            const float* ptr_out = base + static_cast<size_t>(scratch.cells[k]) * object_length;
+            float box_score = scratch.values[k];
+            float temp_conf_thres = yolo_wrapper::de_sigmoid(conf_thres / box_score);
+            for (int category = 5; category < object_length; category++)
+                if (ptr_out[category] > temp_conf_thres)
+                {
+                    scratch.hit_cells.push_back(scratch.cells[k]);
+                    scratch.hit_labels.push_back(category - 5);
+                    scratch.hit_scores.push_back(box_score);
+                    scratch.hit_values.insert(scratch.hit_values.end(), { ptr_out[0], ptr_out[1], ptr_out[2], ptr_out[3], ptr_out[category] });
+                }
+        }
+        yolo_wrapper::sigmoid_array(scratch.hit_values.data(), scratch.hit_values.data(), scratch.hit_values.size());
 
+        const float anchor_w = table.anchor_w[range.q];
+        const float anchor_h = table.anchor_h[range.q];
+        detections.reserve(scratch.hit_cells.size());
+        for (size_t hit = 0; hit < scratch.hit_cells.size(); hit++)
+        {
+            int i = range.row_begin + scratch.hit_cells[hit] / width;
+            int j = scratch.hit_cells[hit] % width;
+            const float* values = scratch.hit_values.data() + hit * 5;
+            detections.push_back(values[0] * table.stride2 + table.grid_x[j], values[1] * table.stride2 + table.grid_y[i],
+                values[2] * values[2] * anchor_w, values[3] * values[3] * anchor_h, scratch.hit_scores[hit] * values[4], scratch.hit_labels[hit]);
+        }
+    }
 };
 
 
@@ -0,0 +1,116 @@
+#pragma once
+#ifndef _DETECTION_BATCH_HPP_
+#define _DETECTION_BATCH_HPP_
+
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+
+// 一帧的检测框, 按结构数组 (SoA) 存放: x, y, w, h, score, label 各自连续, 关键点单独一块.
+// 由 YoloBase 持有并逐帧复用; reset() 只清空计数, 容量保留, 稳定后不再分配内存.
+// 解码阶段 (x, y) 为中心点, centre_xywh2WH 之后为原图上的左上角.
+class detection_batch
+{
+public:
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> w;
+    std::vector<float> h;
+    std::vector<float> score;
+    std::vector<int> label;
+    // 每个检测框 key_point_count 个关键点, 每个关键点 (x, y, score)
+    std::vector<float> key_points;
+
+    static constexpr int key_point_stride = 3;
+
+    void reset(int key_point_count = 0)
+    {
+        size_ = 0;
+        key_point_count_ = key_point_count;
+    }
+
+    std::size_t size() const
+    {
+        return size_;
+    }
+
+    bool empty() const
+    {
+        return size_ == 0;
+    }
+
+    int key_point_count() const
+    {
+        return key_point_count_;
+    }
+
+    void reserve(std::size_t capacity)
+    {
+        if (x.size() < capacity)
+        {
+            x.resize(capacity);
+            y.resize(capacity);
+            w.resize(capacity);
+            h.resize(capacity);
+            score.resize(capacity);
+            label.resize(capacity);
+        }
+        if (key_points.size() < capacity * key_point_count_ * key_point_stride)
+            key_points.resize(capacity * key_point_count_ * key_point_stride);
+    }
+
+    // 追加一个检测框并返回其下标, 关键点通过 key_points_of() 填写
+    std::size_t push_back(float x_, float y_, float w_, float h_, float score_, int label_)
+    {
+        if (size_ == x.size() || key_points.size() < (size_ + 1) * key_point_count_ * key_point_stride)
+            reserve(std::max<std::size_t>(64, 2 * size_ + 1));
+
+        x[size_] = x_;
+        y[size_] = y_;
+        w[size_] = w_;
+        h[size_] = h_;
+        score[size_] = score_;
+        label[size_] = label_;
+        return size_++;
+    }
+
+    // 追加另一批检测框 (关键点数须相同), 用于按顺序合并并行解码的结果
+    void append(const detection_batch& other)
+    {
+        append(other, 0, other.size_);
+    }
+
+    // 只追加 other 中 [first, first + count) 的检测框
+    void append(const detection_batch& other, std::size_t first, std::size_t count)
+    {
+        if (count == 0)
+            return;
+
+        reserve(size_ + count);
+        std::copy_n(other.x.begin() + first, count, x.begin() + size_);
+        std::copy_n(other.y.begin() + first, count, y.begin() + size_);
+        std::copy_n(other.w.begin() + first, count, w.begin() + size_);
+        std::copy_n(other.h.begin() + first, count, h.begin() + size_);
+        std::copy_n(other.score.begin() + first, count, score.begin() + size_);
+        std::copy_n(other.label.begin() + first, count, label.begin() + size_);
+        std::size_t key_point_values = static_cast<std::size_t>(key_point_count_) * key_point_stride;
+        std::copy_n(other.key_points.begin() + first * key_point_values, count * key_point_values, key_points.begin() + size_ * key_point_values);
+        size_ += count;
+    }
+
+    float* key_points_of(std::size_t index)
+    {
+        return key_points.data() + index * key_point_count_ * key_point_stride;
+    }
+
+    const float* key_points_of(std::size_t index) const
+    {
+        return key_points.data() + index * key_point_count_ * key_point_stride;
+    }
+
+private:
+    std::size_t size_ = 0;
+    int key_point_count_ = 0;
+};
+
+#endif
@@ -0,0 +1,311 @@
+#pragma once
+#ifndef _NMS_HPP_
+#define _NMS_HPP_
+
+#include <cmath>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+#include "detection_batch.hpp"
+#include "yolo_kernels.hpp"
+
+namespace yolo_wrapper {
+
+    enum class nms_method
+    {
+        hard,           // 经典 NMS: IoU > 阈值即删除
+        soft_linear,    // Soft-NMS: IoU > 阈值时分数乘 (1 - IoU)
+        soft_gaussian,  // Soft-NMS: 分数乘 exp(-IoU^2 / sigma), 不使用 IoU 阈值
+        diou,           // DIoU-NMS: IoU 减去中心距离惩罚 d^2 / c^2 后与阈值比较
+        matrix          // Matrix-NMS: 一次算出每个框被更高分框压低的系数 (高斯衰减), 无顺序依赖
+    };
+
+    struct nms_param
+    {
+        nms_method method = nms_method::hard;
+        // 高斯衰减参数, soft_gaussian 与 matrix 使用
+        float sigma = 0.5f;
+        // soft_* 与 matrix: 衰减后分数低于此值的框被删除
+        float score_threshold = 0.001f;
+        // 最多保留的目标数, 0 为不限
+        std::size_t top_k = 0;
+    };
+
+    // 按类别分桶的 NMS: 全部框只按分数排序一次, 再按类别稳定分桶, 各桶内独立处理.
+    // 保留框按分数降序输出; soft_* 与 matrix 会把衰减后的分数写回 boxes.score. 缓冲区逐帧复用.
+    // hard 与原先 "x + label * 100000 后整体 NMS" 的实现逐位一致, 见 class_offset.
+    class nms_engine
+    {
+    public:
+        // 返回保留框的下标, 结果引用内部缓冲区, 下一次调用前有效
+        const std::vector<int>& run(detection_batch& boxes, float iou_threshold, const nms_param& param = nms_param())
+        {
+            keep_.clear();
+            if (boxes.empty())
+                return keep_;
+
+            sort_by_score(boxes);
+            bucket_by_class(boxes, param.method == nms_method::hard);
+
+            switch (param.method)
+            {
+            case nms_method::soft_linear:
+            case nms_method::soft_gaussian:
+                for (std::size_t bucket = 0; bucket + 1 < bucket_begin_.size(); bucket++)
+                    soft_bucket(bucket_begin_[bucket], bucket_begin_[bucket + 1], iou_threshold, param);
+                return collect_rescored(boxes, param.top_k);
+            case nms_method::matrix:
+                for (std::size_t bucket = 0; bucket + 1 < bucket_begin_.size(); bucket++)
+                    matrix_bucket(bucket_begin_[bucket], bucket_begin_[bucket + 1], param);
+                return collect_rescored(boxes, param.top_k);
+            default:
+                for (std::size_t bucket = 0; bucket + 1 < bucket_begin_.size(); bucket++)
+                    hard_bucket(bucket_begin_[bucket], bucket_begin_[bucket + 1], iou_threshold, param);
+                return collect_in_order(boxes.size(), param.top_k);
+            }
+        }
+
+    private:
+        static constexpr std::uint8_t keep_flag = 2;
+
+        // 原实现用 x += label * 100000 把各类平移到互不相交的区域后整体做 NMS. 分桶后已不需要平移来区分类别,
+        // 但平移后的 x1、x2 有舍入, 个别 IoU 会落到阈值另一侧; hard 保留同样的平移, 结果与原实现逐位一致
+        static constexpr float class_offset = 100000.f;
+
+        void sort_by_score(const detection_batch& boxes)
+        {
+            order_.resize(boxes.size());
+            for (std::size_t i = 0; i < boxes.size(); i++)
+                order_[i] = i;
+
+            const std::vector<float>& scores = boxes.score;
+            std::sort(order_.begin(), order_.end(), [&scores](int a, int b) {
+                return scores[a] > scores[b];
+                });
+        }
+
+        // 计数排序按类别分桶, 桶内保持分数顺序; 同时把框整理成 (x1, y1, x2, y2, area, score) 连续数组.
+        // offset_classes: x 按 class_offset 平移, 面积仍用原始宽高
+        void bucket_by_class(const detection_batch& boxes, bool offset_classes)
+        {
+            std::size_t n = boxes.size();
+            int max_label = 0;
+            for (std::size_t i = 0; i < n; i++)
+                max_label = std::max(max_label, boxes.label[i]);
+
+            bucket_begin_.assign(max_label + 2, 0);
+            for (std::size_t i = 0; i < n; i++)
+                bucket_begin_[boxes.label[i] + 1]++;
+            for (std::size_t bucket = 1; bucket < bucket_begin_.size(); bucket++)
+                bucket_begin_[bucket] += bucket_begin_[bucket - 1];
+
+            bucket_fill_.assign(bucket_begin_.begin(), bucket_begin_.end() - 1);
+            bucket_slot_.resize(n);
+            slot_box_.resize(n);
+            x1_.resize(n);
+            y1_.resize(n);
+            x2_.resize(n);
+            y2_.resize(n);
+            area_.resize(n);
+            score_.resize(n);
+            for (std::size_t i = 0; i < n; i++)
+            {
+                int box = order_[i];
+                std::size_t slot = bucket_fill_[boxes.label[box]]++;
+                bucket_slot_[i] = slot;
+                slot_box_[slot] = box;
+                float x = offset_classes ? boxes.x[box] + static_cast<float>(boxes.label[box]) * class_offset : boxes.x[box];
+                x1_[slot] = x;
+                y1_[slot] = boxes.y[box];
+                x2_[slot] = x + boxes.w[box];
+                y2_[slot] = boxes.y[box] + boxes.h[box];
+                area_[slot] = boxes.w[box] * boxes.h[box];
+                score_[slot] = boxes.score[box];
+            }
+
+            suppressed_.assign(n, 0);
+            ious_.resize(n);
+        }
+
+        // slot 对 [begin, end) 的 IoU, 写入 ious_[0, end - begin)
+        void iou_row(std::size_t slot, std::size_t begin, std::size_t end)
+        {
+            iou_one_to_many(x1_[slot], y1_[slot], x2_[slot], y2_[slot], area_[slot],
+                x1_.data() + begin, y1_.data() + begin, x2_.data() + begin, y2_.data() + begin, area_.data() + begin, end - begin, ious_.data());
+        }
+
+        // ious_ 减去 DIoU 的中心距离惩罚: 中心距离平方 / 最小外接框对角线平方
+        void diou_penalty(std::size_t slot, std::size_t begin, std::size_t end)
+        {
+            float x1 = x1_[slot], y1 = y1_[slot], x2 = x2_[slot], y2 = y2_[slot];
+            for (std::size_t k = 0; k < end - begin; k++)
+            {
+                std::size_t j = begin + k;
+                float dx = (x1 + x2) - (x1_[j] + x2_[j]);
+                float dy = (y1 + y2) - (y1_[j] + y2_[j]);
+                float cw = std::max(x2, x2_[j]) - std::min(x1, x1_[j]);
+                float ch = std::max(y2, y2_[j]) - std::min(y1, y1_[j]);
+                float diagonal = cw * cw + ch * ch;
+                // 中心坐标未除 2, 距离平方需乘 1/4
+                ious_[k] -= diagonal > 0.f ? 0.25f * (dx * dx + dy * dy) / diagonal : 0.f;
+            }
+        }
+
+        // 桶内分数已降序: 依次保留未被抑制的框, 并抑制其后与之重叠的框
+        void hard_bucket(std::size_t begin, std::size_t end, float iou_threshold, const nms_param& param)
+        {
+            std::size_t kept = 0;
+            for (std::size_t i = begin; i < end; i++)
+            {
+                if (suppressed_[i])
+                    continue;
+                suppressed_[i] = keep_flag;
+                // 全局前 top_k 个一定在各类的前 top_k 个之中, 每类保留够 top_k 个即可提前结束
+                if (param.top_k && ++kept == param.top_k)
+                    break;
+
+                iou_row(i, i + 1, end);
+                if (param.method == nms_method::diou)
+                    diou_penalty(i, i + 1, end);
+                std::uint8_t* suppressed = suppressed_.data() + i + 1;
+                for (std::size_t k = 0; k < end - i - 1; k++)
+                    suppressed[k] |= ious_[k] > iou_threshold;
+            }
+        }
+
+        void swap_slots(std::size_t a, std::size_t b)
+        {
+            std::swap(slot_box_[a], slot_box_[b]);
+            std::swap(x1_[a], x1_[b]);
+            std::swap(y1_[a], y1_[b]);
+            std::swap(x2_[a], x2_[b]);
+            std::swap(y2_[a], y2_[b]);
+            std::swap(area_[a], area_[b]);
+            std::swap(score_[a], score_[b]);
+        }
+
+        // Soft-NMS: 分数会被改写, 每轮重新选出剩余框中分数最高者; 保留的框依次换到桶前部
+        void soft_bucket(std::size_t begin, std::size_t end, float iou_threshold, const nms_param& param)
+        {
+            std::size_t kept = 0;
+            std::size_t current = begin;
+            while (current < end)
+            {
+                std::size_t best = current;
+                for (std::size_t i = current + 1; i < end; i++)
+                    if (score_[i] > score_[best])
+                        best = i;
+                swap_slots(current, best);
+                suppressed_[current] = keep_flag;
+                current++;
+                if (param.top_k && ++kept == param.top_k)
+                    break;
+
+                iou_row(current - 1, current, end);
+                if (param.method == nms_method::soft_linear)
+                {
+                    for (std::size_t k = 0; k < end - current; k++)
+                        score_[current + k] *= ious_[k] > iou_threshold ? 1.f - ious_[k] : 1.f;
+                }
+                else
+                {
+                    float scale = -1.f / param.sigma;
+                    for (std::size_t k = 0; k < end - current; k++)
+                        ious_[k] = ious_[k] * ious_[k] * scale;
+                    exp_array(ious_.data(), ious_.data(), end - current);
+                    for (std::size_t k = 0; k < end - current; k++)
+                        score_[current + k] *= ious_[k];
+                }
+
+                // 低于分数阈值的框换到桶尾丢弃
+                for (std::size_t i = current; i < end;)
+                {
+                    if (score_[i] < param.score_threshold)
+                        swap_slots(i, --end);
+                    else
+                        i++;
+                }
+            }
+        }
+
+        // Matrix-NMS: 框 j 的衰减系数为 min_i f(iou_ij) / f(comp_i), i 为分数更高的框,
+        // comp_i 为框 i 与比它分数更高的框的最大 IoU. 逐行累计, 不需要保存整个 IoU 矩阵.
+        void matrix_bucket(std::size_t begin, std::size_t end, const nms_param& param)
+        {
+            std::size_t count = end - begin;
+            compensate_.assign(count, 0.f);
+            decay_.assign(count, 1.f);
+            float scale = -1.f / param.sigma;
+            for (std::size_t i = begin; i + 1 < end; i++)
+            {
+                std::size_t rest = end - i - 1;
+                float compensate = compensate_[i - begin];
+                float* compensate_rest = compensate_.data() + (i - begin) + 1;
+                float* decay_rest = decay_.data() + (i - begin) + 1;
+                iou_row(i, i + 1, end);
+                for (std::size_t k = 0; k < rest; k++)
+                    compensate_rest[k] = std::max(compensate_rest[k], ious_[k]);
+                for (std::size_t k = 0; k < rest; k++)
+                    ious_[k] = (ious_[k] * ious_[k] - compensate * compensate) * scale;
+                exp_array(ious_.data(), ious_.data(), rest);
+                for (std::size_t k = 0; k < rest; k++)
+                    decay_rest[k] = std::min(decay_rest[k], ious_[k]);
+            }
+            for (std::size_t i = begin; i < end; i++)
+            {
+                score_[i] *= decay_[i - begin];
+                suppressed_[i] = score_[i] >= param.score_threshold ? keep_flag : 1;
+            }
+        }
+
+        // 分数未改写: 按全局排序顺序收集保留框
+        const std::vector<int>& collect_in_order(std::size_t n, std::size_t top_k)
+        {
+            for (std::size_t i = 0; i < n && (!top_k || keep_.size() < top_k); i++)
+                if (suppressed_[bucket_slot_[i]] == keep_flag)
+                    keep_.push_back(order_[i]);
+            return keep_;
+        }
+
+        // 分数已改写: 写回 boxes.score 并按新分数重新排序
+        const std::vector<int>& collect_rescored(detection_batch& boxes, std::size_t top_k)
+        {
+            for (std::size_t slot = 0; slot < slot_box_.size(); slot++)
+                if (suppressed_[slot] == keep_flag)
+                {
+                    boxes.score[slot_box_[slot]] = score_[slot];
+                    keep_.push_back(slot_box_[slot]);
+                }
+
+            const std::vector<float>& scores = boxes.score;
+            std::sort(keep_.begin(), keep_.end(), [&scores](int a, int b) {
+                return scores[a] > scores[b];
+                });
+            if (top_k && keep_.size() > top_k)
+                keep_.resize(top_k);
+            return keep_;
+        }
+
+        std::vector<int> order_;
+        std::vector<std::size_t> bucket_begin_;
+        std::vector<std::size_t> bucket_fill_;
+        std::vector<std::size_t> bucket_slot_;
+        std::vector<int> slot_box_;
+        std::vector<float> x1_;
+        std::vector<float> y1_;
+        std::vector<float> x2_;
+        std::vector<float> y2_;
+        std::vector<float> area_;
+        std::vector<float> score_;
+        std::vector<float> ious_;
+        std::vector<float> compensate_;
+        std::vector<float> decay_;
+        // 0: 未处理, 1: 被抑制, keep_flag: 保留
+        std::vector<std::uint8_t> suppressed_;
+        std::vector<int> keep_;
+    };
+}
+
+#endif
@@ -0,0 +1,64 @@
+#pragma once
+#ifndef _YOLO_HEAD_HPP_
+#define _YOLO_HEAD_HPP_
+
+#include <memory>
+#include <vector>
+
+namespace yolo_wrapper {
+
+    // 编译期固定的 YOLOv8 输出头: 模型输入尺寸, DFL 每条边的 bin 数 (reg_max), 类别数, 关键点数, 各层步长.
+    // 步长按 sort_model_result 排序后的输出顺序给出 (格子最少的层在前), 例如 1280x736 单类检测模型:
+    // yolov8_head<1280, 736, 16, 1, 0, 32, 16, 8>
+    template <int InputWidth, int InputHeight, int RegMax, int Classes, int KeyPoints, int... Strides>
+    struct yolov8_head
+    {
+        static_assert(sizeof...(Strides) > 0, "yolov8_head needs at least one stride.");
+        static_assert(((InputWidth % Strides == 0 && InputHeight % Strides == 0) && ...), "the input size must be a multiple of every stride.");
+
+        static constexpr int input_width = InputWidth;
+        static constexpr int input_height = InputHeight;
+        static constexpr int reg_max = RegMax;
+        static constexpr int classes = Classes;
+        static constexpr int key_points = KeyPoints;
+        static constexpr int levels = sizeof...(Strides);
+        static constexpr int strides[levels] = { Strides... };
+
+        // 检测输出的通道: 4 * reg_max 个 DFL 通道加类别分数
+        static constexpr int box_channels = 4 * RegMax;
+        static constexpr int channels = box_channels + Classes;
+
+        static constexpr int stride(int level) { return strides[level]; }
+        static constexpr int grid_width(int level) { return InputWidth / strides[level]; }
+        static constexpr int grid_height(int level) { return InputHeight / strides[level]; }
+        static constexpr int cells(int level) { return grid_width(level) * grid_height(level); }
+
+        // 排序后的输出与描述一致时才能按编译期常量解码, 否则调用方应退回运行时解码.
+        // 有关键点时每层为 [关键点, 检测] 两个输出, key_point_values 为每个关键点的通道数
+        template <typename Tensor>
+        static bool matches(const std::vector<std::shared_ptr<Tensor>>& outs, int key_point_values)
+        {
+            constexpr int outputs_per_level = KeyPoints > 0 ? 2 : 1;
+            if (outs.size() != static_cast<size_t>(levels * outputs_per_level))
+                return false;
+
+            for (int level = 0; level < levels; level++)
+            {
+                if (!shape_matches(outs[level * outputs_per_level + outputs_per_level - 1]->data_shape(), channels, level))
+                    return false;
+                if (KeyPoints > 0 && !shape_matches(outs[level * 2]->data_shape(), KeyPoints * key_point_values, level))
+                    return false;
+            }
+            return true;
+        }
+
+    private:
+        static bool shape_matches(const std::vector<int>& shape, int expected_channels, int level)
+        {
+            size_t n = shape.size();
+            return n >= 3 && shape[n - 3] == expected_channels && shape[n - 2] == grid_height(level) && shape[n - 1] == grid_width(level);
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,473 @@
+#pragma once
+#ifndef _YOLO_KERNELS_HPP_
+#define _YOLO_KERNELS_HPP_
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <utility>
+#include <type_traits>
+#include "../Primitives/simd_instruction_set.hpp"
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace yolo_wrapper {
+
+    // DFL 分布的 bin 数, 每条边 16 个 bin, 4 条边共 64 个通道
+    constexpr int dfl_bins = 16;
+    constexpr int dfl_channels = 4 * dfl_bins;
+
+    // 编译期展开的循环: 依次以 std::integral_constant<int, I> 调用 f, I = Begin .. End - 1, 顺序与普通 for 循环相同
+    template <int Begin, typename F, int... I>
+    inline void static_for_sequence(F&& f, std::integer_sequence<int, I...>)
+    {
+        (f(std::integral_constant<int, Begin + I>{}), ...);
+    }
+
+    template <int Begin, int End, typename F>
+    inline void static_for(F&& f)
+    {
+        static_for_sequence<Begin>(f, std::make_integer_sequence<int, (End > Begin ? End - Begin : 0)>{});
+    }
+
+    // 对类别 [first, classes) 依次调用 f(label): classes 为 int 时是普通循环, 为 std::integral_constant 时在编译期展开
+    template <int First = 0, typename F>
+    inline void for_each_class(int classes, F&& f)
+    {
+        for (int label = First; label < classes; label++)
+            f(label);
+    }
+
+    template <int First = 0, int Classes, typename F>
+    inline void for_each_class(std::integral_constant<int, Classes>, F&& f)
+    {
+        static_for<First, Classes>(f);
+    }
+
+    namespace details {
+
+#if defined(__ARM_NEON)
+        using vfloat = float32x4_t;
+        constexpr std::size_t vfloat_size = 4;
+
+        inline vfloat v_load(const float* p) { return vld1q_f32(p); }
+        inline void v_store(float* p, vfloat v) { vst1q_f32(p, v); }
+        inline vfloat v_set1(float x) { return vdupq_n_f32(x); }
+        inline vfloat v_add(vfloat a, vfloat b) { return vaddq_f32(a, b); }
+        inline vfloat v_sub(vfloat a, vfloat b) { return vsubq_f32(a, b); }
+        inline vfloat v_mul(vfloat a, vfloat b) { return vmulq_f32(a, b); }
+        inline vfloat v_max(vfloat a, vfloat b) { return vmaxq_f32(a, b); }
+        inline vfloat v_min(vfloat a, vfloat b) { return vminq_f32(a, b); }
+        inline vfloat v_madd(vfloat a, vfloat b, vfloat c) { return vmlaq_f32(c, a, b); }
+        inline vfloat v_div(vfloat a, vfloat b)
+        {
+            // 两次牛顿迭代的倒数, 精度与除法相当
+            float32x4_t r = vrecpeq_f32(b);
+            r = vmulq_f32(vrecpsq_f32(b, r), r);
+            r = vmulq_f32(vrecpsq_f32(b, r), r);
+            return vmulq_f32(a, r);
+        }
+#if defined(__aarch64__)
+#define YOLO_KERNELS_EXACT_DIV 1
+        inline vfloat v_div_exact(vfloat a, vfloat b) { return vdivq_f32(a, b); }
+#endif
+        // 比较结果为逐通道全 1 / 全 0 掩码
+        inline vfloat v_gt(vfloat a, vfloat b) { return vreinterpretq_f32_u32(vcgtq_f32(a, b)); }
+        inline vfloat v_select(vfloat mask, vfloat a, vfloat b) { return vbslq_f32(vreinterpretq_u32_f32(mask), a, b); }
+        // 掩码第 i 通道 -> 第 i 位
+        inline unsigned v_movemask(vfloat mask)
+        {
+            static const uint32_t lane_bits[4] = { 1, 2, 4, 8 };
+            uint32x4_t bits = vandq_u32(vreinterpretq_u32_f32(mask), vld1q_u32(lane_bits));
+#if defined(__aarch64__)
+            return vaddvq_u32(bits);
+#else
+            uint32x2_t half = vadd_u32(vget_low_u32(bits), vget_high_u32(bits));
+            return vget_lane_u32(vpadd_u32(half, half), 0);
+#endif
+        }
+        inline vfloat v_floor(vfloat x)
+        {
+            float32x4_t t = vcvtq_f32_s32(vcvtq_s32_f32(x));
+            uint32x4_t greater = vcgtq_f32(t, x);
+            return vsubq_f32(t, vreinterpretq_f32_u32(vandq_u32(greater, vreinterpretq_u32_f32(vdupq_n_f32(1.f)))));
+        }
+        inline vfloat v_pow2n(vfloat n)
+        {
+            int32x4_t e = vshlq_n_s32(vaddq_s32(vcvtq_s32_f32(n), vdupq_n_s32(127)), 23);
+            return vreinterpretq_f32_s32(e);
+        }
+#elif SIMD_X86_INSTR_SET >= SIMD_X86_AVX2_VERSION
+        using vfloat = __m256;
+        constexpr std::size_t vfloat_size = 8;
+
+        inline vfloat v_load(const float* p) { return _mm256_loadu_ps(p); }
+        inline void v_store(float* p, vfloat v) { _mm256_storeu_ps(p, v); }
+        inline vfloat v_set1(float x) { return _mm256_set1_ps(x); }
+        inline vfloat v_add(vfloat a, vfloat b) { return _mm256_add_ps(a, b); }
+        inline vfloat v_sub(vfloat a, vfloat b) { return _mm256_sub_ps(a, b); }
+        inline vfloat v_mul(vfloat a, vfloat b) { return _mm256_mul_ps(a, b); }
+        inline vfloat v_max(vfloat a, vfloat b) { return _mm256_max_ps(a, b); }
+        inline vfloat v_min(vfloat a, vfloat b) { return _mm256_min_ps(a, b); }
+        inline vfloat v_madd(vfloat a, vfloat b, vfloat c) { return _mm256_add_ps(_mm256_mul_ps(a, b), c); }
+        inline vfloat v_div(vfloat a, vfloat b) { return _mm256_div_ps(a, b); }
+#define YOLO_KERNELS_EXACT_DIV 1
+        inline vfloat v_div_exact(vfloat a, vfloat b) { return _mm256_div_ps(a, b); }
+        inline vfloat v_gt(vfloat a, vfloat b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+        inline vfloat v_select(vfloat mask, vfloat a, vfloat b) { return _mm256_blendv_ps(b, a, mask); }
+        inline unsigned v_movemask(vfloat mask) { return static_cast<unsigned>(_mm256_movemask_ps(mask)); }
+        inline vfloat v_floor(vfloat x) { return _mm256_floor_ps(x); }
+        inline vfloat v_pow2n(vfloat n)
+        {
+            __m256i e = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvttps_epi32(n), _mm256_set1_epi32(127)), 23);
+            return _mm256_castsi256_ps(e);
+        }
+#elif SIMD_X86_INSTR_SET >= SIMD_X86_SSE2_VERSION
+        using vfloat = __m128;
+        constexpr std::size_t vfloat_size = 4;
+
+        inline vfloat v_load(const float* p) { return _mm_loadu_ps(p); }
+        inline void v_store(float* p, vfloat v) { _mm_storeu_ps(p, v); }
+        inline vfloat v_set1(float x) { return _mm_set1_ps(x); }
+        inline vfloat v_add(vfloat a, vfloat b) { return _mm_add_ps(a, b); }
+        inline vfloat v_sub(vfloat a, vfloat b) { return _mm_sub_ps(a, b); }
+        inline vfloat v_mul(vfloat a, vfloat b) { return _mm_mul_ps(a, b); }
+        inline vfloat v_max(vfloat a, vfloat b) { return _mm_max_ps(a, b); }
+        inline vfloat v_min(vfloat a, vfloat b) { return _mm_min_ps(a, b); }
+        inline vfloat v_madd(vfloat a, vfloat b, vfloat c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+        inline vfloat v_div(vfloat a, vfloat b) { return _mm_div_ps(a, b); }
+#define YOLO_KERNELS_EXACT_DIV 1
+        inline vfloat v_div_exact(vfloat a, vfloat b) { return _mm_div_ps(a, b); }
+        inline vfloat v_gt(vfloat a, vfloat b) { return _mm_cmpgt_ps(a, b); }
+        inline vfloat v_select(vfloat mask, vfloat a, vfloat b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+        inline unsigned v_movemask(vfloat mask) { return static_cast<unsigned>(_mm_movemask_ps(mask)); }
+        inline vfloat v_floor(vfloat x)
+        {
+            __m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+            return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, x), _mm_set1_ps(1.f)));
+        }
+        inline vfloat v_pow2n(vfloat n)
+        {
+            __m128i e = _mm_slli_epi32(_mm_add_epi32(_mm_cvttps_epi32(n), _mm_set1_epi32(127)), 23);
+            return _mm_castsi128_ps(e);
+        }
+#endif
+
+#if defined(__ARM_NEON) || SIMD_X86_INSTR_SET >= SIMD_X86_SSE2_VERSION
+#define YOLO_KERNELS_SIMD 1
+        // Cephes 风格的 expf: x = n * ln2 + r, e^r 用 5 阶多项式逼近, 相对误差约 2e-7.
+        // 输入需在 [-87, 88] 内; DFL 中的输入已减去最大值, 只需截断下界.
+        inline vfloat v_exp(vfloat x)
+        {
+            x = v_max(x, v_set1(-87.f));
+            vfloat n = v_floor(v_madd(x, v_set1(1.44269504088896341f), v_set1(0.5f)));
+            x = v_sub(x, v_mul(n, v_set1(0.693359375f)));
+            x = v_sub(x, v_mul(n, v_set1(-2.12194440e-4f)));
+
+            vfloat y = v_set1(1.9875691500e-4f);
+            y = v_madd(y, x, v_set1(1.3981999507e-3f));
+            y = v_madd(y, x, v_set1(8.3334519073e-3f));
+            y = v_madd(y, x, v_set1(4.1665795894e-2f));
+            y = v_madd(y, x, v_set1(1.6666665459e-1f));
+            y = v_madd(y, x, v_set1(5.0000001201e-1f));
+            y = v_madd(y, v_mul(x, x), v_add(x, v_set1(1.f)));
+            return v_mul(y, v_pow2n(n));
+        }
+#endif
+    }
+
+    // 单个候选框一条边的 DFL 期望: sum_i i * softmax(x)_i, x 的 Bins 个值间隔 stride
+    template <int Bins = dfl_bins>
+    inline float dfl_expectation(const float* x, std::size_t stride)
+    {
+        float max_value = x[0];
+        static_for<1, Bins>([&](auto i) { max_value = std::max(max_value, x[i * stride]); });
+
+        float sum = 0.f;
+        float weighted_sum = 0.f;
+        static_for<0, Bins>([&](auto i) {
+            float e = std::exp(x[i * stride] - max_value);
+            sum += e;
+            weighted_sum += e * i;
+            });
+        return weighted_sum / sum;
+    }
+
+    // 候选数达到格子数一半时按密集处理: 顺序扫描整张输出比逐个跨步读取更省内存带宽
+    inline bool candidates_dense(std::size_t candidate_num, std::size_t cells)
+    {
+        return candidate_num * 2 >= cells;
+    }
+
+    // 阈值筛选并压缩: scores 为 [classes][cell_stride] 的类别分数, 依次把格子 [cell_begin, cell_end) 中 score > threshold 的
+    // 格子与类别写入 cells / labels, 顺序与逐个扫描相同 (先类别后格子). cells / labels 需有 classes * (cell_end - cell_begin)
+    // 的空间, 返回写入个数. 每次比较一整个向量, 没有命中时直接跳过, 命中通常很稀疏, 扫描受内存带宽而非分支限制.
+    // classes 可以是 std::integral_constant, 类别循环随之在编译期展开
+    template <typename ClassCount>
+    inline std::size_t threshold_compact(const float* scores, std::size_t cell_stride, std::size_t cell_begin, std::size_t cell_end,
+        ClassCount classes, float threshold, int* cells, int* labels)
+    {
+        std::size_t count = 0;
+        for_each_class(classes, [&](int label) {
+            const float* class_scores = scores + static_cast<std::size_t>(label) * cell_stride;
+            std::size_t k = cell_begin;
+#if defined(YOLO_KERNELS_SIMD)
+            using namespace details;
+            vfloat v_threshold = v_set1(threshold);
+            for (; k + vfloat_size <= cell_end; k += vfloat_size)
+            {
+                unsigned hits = v_movemask(v_gt(v_load(class_scores + k), v_threshold));
+                for (int lane = 0; hits != 0; lane++, hits >>= 1)
+                    if (hits & 1u)
+                    {
+                        cells[count] = static_cast<int>(k) + lane;
+                        labels[count] = label;
+                        count++;
+                    }
+            }
+#endif
+            for (; k < cell_end; k++)
+                if (class_scores[k] > threshold)
+                {
+                    cells[count] = static_cast<int>(k);
+                    labels[count] = label;
+                    count++;
+                }
+            });
+        return count;
+    }
+
+    inline std::size_t threshold_compact(const float* scores, std::size_t cell_count, int classes, float threshold, int* cells, int* labels)
+    {
+        return threshold_compact(scores, cell_count, 0, cell_count, classes, threshold, cells, labels);
+    }
+
+    // 每个格子只保留分数最高的类别 (同分取编号小的), 再对最高分做阈值筛选; 按格子顺序写入, 需有 cell_end - cell_begin 的空间.
+    // 各类别的分数按格子连续读取, 最大值与类别号留在寄存器中. classes 同 threshold_compact
+    template <typename ClassCount>
+    inline std::size_t threshold_compact_best_class(const float* scores, std::size_t cell_stride, std::size_t cell_begin, std::size_t cell_end,
+        ClassCount classes, float threshold, int* cells, int* labels)
+    {
+        std::size_t count = 0;
+        std::size_t k = cell_begin;
+#if defined(YOLO_KERNELS_SIMD)
+        using namespace details;
+        vfloat v_threshold = v_set1(threshold);
+        for (; k + vfloat_size <= cell_end; k += vfloat_size)
+        {
+            vfloat best = v_load(scores + k);
+            vfloat best_label = v_set1(0.f);
+            for_each_class<1>(classes, [&](int label) {
+                vfloat value = v_load(scores + static_cast<std::size_t>(label) * cell_stride + k);
+                vfloat greater = v_gt(value, best);
+                best = v_select(greater, value, best);
+                best_label = v_select(greater, v_set1(static_cast<float>(label)), best_label);
+                });
+
+            unsigned hits = v_movemask(v_gt(best, v_threshold));
+            if (hits == 0)
+                continue;
+
+            float lane_labels[vfloat_size];
+            v_store(lane_labels, best_label);
+            for (int lane = 0; hits != 0; lane++, hits >>= 1)
+                if (hits & 1u)
+                {
+                    cells[count] = static_cast<int>(k) + lane;
+                    labels[count] = static_cast<int>(lane_labels[lane]);
+                    count++;
+                }
+        }
+#endif
+        for (; k < cell_end; k++)
+        {
+            float best = scores[k];
+            int best_label = 0;
+            for_each_class<1>(classes, [&](int label) {
+                float value = scores[static_cast<std::size_t>(label) * cell_stride + k];
+                if (value > best)
+                {
+                    best = value;
+                    best_label = label;
+                }
+                });
+            if (best > threshold)
+            {
+                cells[count] = static_cast<int>(k);
+                labels[count] = best_label;
+                count++;
+            }
+        }
+        return count;
+    }
+
+    inline std::size_t threshold_compact_best_class(const float* scores, std::size_t cell_count, int classes, float threshold, int* cells, int* labels)
+    {
+        return threshold_compact_best_class(scores, cell_count, 0, cell_count, classes, threshold, cells, labels);
+    }
+
+    // 从 [rows][cols] 的通道优先输出中取出 indices 指定的列, 写成 [rows][count].
+    // 逐行读取, 候选格子按升序时每行只访问一段连续区间.
+    inline void gather_columns(const float* src, int rows, std::size_t cols, const int* indices, std::size_t count, float* dst)
+    {
+        for (int row = 0; row < rows; row++)
+        {
+            const float* src_row = src + row * cols;
+            float* dst_row = dst + row * count;
+            for (std::size_t k = 0; k < count; k++)
+                dst_row[k] = src_row[indices[k]];
+        }
+    }
+
+    // 分块转置 [rows][cols] -> [cols][rows], 每块的读写都留在 L1 内
+    inline void transpose_blocked(const float* src, float* dst, int rows, int cols)
+    {
+        constexpr int block = 32;
+        for (int row0 = 0; row0 < rows; row0 += block)
+        {
+            int row_end = std::min(row0 + block, rows);
+            for (int col0 = 0; col0 < cols; col0 += block)
+            {
+                int col_end = std::min(col0 + block, cols);
+                for (int row = row0; row < row_end; row++)
+                    for (int col = col0; col < col_end; col++)
+                        dst[static_cast<std::size_t>(col) * rows + row] = src[static_cast<std::size_t>(row) * cols + col];
+            }
+        }
+    }
+
+#if defined(YOLO_KERNELS_SIMD)
+    namespace details {
+        // dfl_distances 的一个向量: 候选框 [k, k + vfloat_size) 的四条边
+        template <int Bins>
+        inline void dfl_distances_vector(const float* bins, std::size_t bin_stride, std::size_t k, float* distances, std::size_t distance_stride)
+        {
+            for (int side = 0; side < 4; side++)
+            {
+                const float* side_bins = bins + static_cast<std::size_t>(side) * Bins * bin_stride + k;
+
+                vfloat max_value = v_load(side_bins);
+                static_for<1, Bins>([&](auto i) { max_value = v_max(max_value, v_load(side_bins + i * bin_stride)); });
+
+                vfloat sum = v_set1(0.f);
+                vfloat weighted_sum = v_set1(0.f);
+                static_for<0, Bins>([&](auto i) {
+                    vfloat e = v_exp(v_sub(v_load(side_bins + i * bin_stride), max_value));
+                    sum = v_add(sum, e);
+                    weighted_sum = v_madd(e, v_set1(static_cast<float>(i)), weighted_sum);
+                    });
+                v_store(distances + side * distance_stride + k, v_div(weighted_sum, sum));
+            }
+        }
+    }
+#endif
+
+    // DFL 解码: 一次处理 count 个候选框的四条边 (左, 上, 右, 下) 的 softmax 期望.
+    // bins 按通道存放: 候选框 k 第 s 条边第 b 个 bin 在 bins[(s * Bins + b) * bin_stride + k];
+    // 结果写入 distances[s * distance_stride + k]. 向量在候选框维度展开, 不需要水平归约.
+    // 不足一个向量的余数补齐后同样按向量计算, 所以每个候选框的结果与 count 及它在其中的位置无关,
+    // 同一层按不同方式分组 (整层、按行分块、稀疏或密集) 解码得到的距离逐位一致
+    template <int Bins = dfl_bins>
+    inline void dfl_distances(const float* bins, std::size_t bin_stride, std::size_t count, float* distances, std::size_t distance_stride)
+    {
+#if defined(YOLO_KERNELS_SIMD)
+        using namespace details;
+        std::size_t k = 0;
+        for (; k + vfloat_size <= count; k += vfloat_size)
+            dfl_distances_vector<Bins>(bins, bin_stride, k, distances, distance_stride);
+        if (k == count)
+            return;
+
+        std::size_t rest = count - k;
+        float tail_bins[4 * Bins * vfloat_size];
+        float tail_distances[4 * vfloat_size];
+        for (int channel = 0; channel < 4 * Bins; channel++)
+            for (std::size_t lane = 0; lane < vfloat_size; lane++)
+                tail_bins[channel * vfloat_size + lane] = lane < rest ? bins[channel * bin_stride + k + lane] : 0.f;
+        dfl_distances_vector<Bins>(tail_bins, vfloat_size, 0, tail_distances, vfloat_size);
+        for (int side = 0; side < 4; side++)
+            for (std::size_t lane = 0; lane < rest; lane++)
+                distances[side * distance_stride + k + lane] = tail_distances[side * vfloat_size + lane];
+#else
+        for (std::size_t k = 0; k < count; k++)
+            for (int side = 0; side < 4; side++)
+                distances[side * distance_stride + k] = dfl_expectation<Bins>(bins + static_cast<std::size_t>(side) * Bins * bin_stride + k, bin_stride);
+#endif
+    }
+
+    // dst[k] = exp(src[k]), 可原地计算
+    inline void exp_array(const float* src, float* dst, std::size_t count)
+    {
+        std::size_t k = 0;
+#if defined(YOLO_KERNELS_SIMD)
+        using namespace details;
+        for (; k + vfloat_size <= count; k += vfloat_size)
+            v_store(dst + k, v_exp(v_load(src + k)));
+#endif
+        for (; k < count; k++)
+            dst[k] = std::exp(src[k]);
+    }
+
+    // dst[k] = 1 / (1 + exp(-src[k])), 可原地计算. 向量部分用 v_exp 近似, 与 sigmoid_x 的差在 1e-6 量级,
+    // 只用于已过阈值的少量候选, 不参与阈值比较
+    inline void sigmoid_array(const float* src, float* dst, std::size_t count)
+    {
+        std::size_t k = 0;
+#if defined(YOLO_KERNELS_SIMD)
+        using namespace details;
+        vfloat one = v_set1(1.f);
+        vfloat upper = v_set1(88.f);
+        for (; k + vfloat_size <= count; k += vfloat_size)
+        {
+            vfloat e = v_exp(v_min(v_sub(v_set1(0.f), v_load(src + k)), upper));
+            v_store(dst + k, v_div(one, v_add(one, e)));
+        }
+#endif
+        for (; k < count; k++)
+            dst[k] = 1.f / (1.f + std::exp(-src[k]));
+    }
+
+    // 一个框 (x1, y1, x2, y2, area) 对 count 个框的 IoU, 框按坐标分量连续存放.
+    // 运算顺序与 YoloBase::intersectionOverUnion 一致, 不相交时为 0; 向量除法只在 IEEE 精确时启用, 保证逐位一致.
+    // 交集或并集不为正 (面积为 0 的框之间) 时也为 0, 不做 0 / 0, 向量与标量部分结果相同
+    inline void iou_one_to_many(float x1, float y1, float x2, float y2, float area,
+        const float* xs1, const float* ys1, const float* xs2, const float* ys2, const float* areas, std::size_t count, float* ious)
+    {
+        std::size_t k = 0;
+#if defined(YOLO_KERNELS_SIMD) && defined(YOLO_KERNELS_EXACT_DIV)
+        using namespace details;
+        vfloat v_x1 = v_set1(x1), v_y1 = v_set1(y1), v_x2 = v_set1(x2), v_y2 = v_set1(y2), v_area = v_set1(area);
+        vfloat zero = v_set1(0.f);
+        for (; k + vfloat_size <= count; k += vfloat_size)
+        {
+            vfloat w = v_max(v_sub(v_min(v_x2, v_load(xs2 + k)), v_max(v_x1, v_load(xs1 + k))), zero);
+            vfloat h = v_max(v_sub(v_min(v_y2, v_load(ys2 + k)), v_max(v_y1, v_load(ys1 + k))), zero);
+            vfloat intersection = v_mul(w, h);
+            vfloat union_area = v_sub(v_add(v_area, v_load(areas + k)), intersection);
+            vfloat iou = v_select(v_gt(union_area, zero), v_div_exact(intersection, union_area), zero);
+            v_store(ious + k, v_select(v_gt(intersection, zero), iou, zero));
+        }
+#endif
+        for (; k < count; k++)
+        {
+            float ix1 = std::max(x1, xs1[k]);
+            float iy1 = std::max(y1, ys1[k]);
+            float ix2 = std::min(x2, xs2[k]);
+            float iy2 = std::min(y2, ys2[k]);
+            if (ix1 >= ix2 || iy1 >= iy2)
+            {
+                ious[k] = 0.f;
+                continue;
+            }
+            float intersection = (ix2 - ix1) * (iy2 - iy1);
+            float union_area = area + areas[k] - intersection;
+            ious[k] = intersection > 0.f && union_area > 0.f ? intersection / union_area : 0.f;
+        }
+    }
+}
+
+#endif
@@ -4,13 +4,159 @@
 
 #include <opencv2/core.hpp>
 #include <opencv2/imgproc.hpp>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// 结果类型均为标准布局, C 调用方可以直接按同样的字段声明使用
+struct AlgorithmKeyPoint {
+    float x;
+    float y;
+    float score;
+};
+
+struct AlgorithmObject {
+    int x1;
+    int y1;
+    int x2;
+    int y2;
+    int category;
+    float score;
+    // 关键点在 AlgorithmResult::key_points 中的起始位置与个数
+    int key_point_offset;
+    int key_point_count;
+};
+
+// 调用方持有并逐帧复用的结果区: clear() 保留容量, 稳定后 detect 不再分配内存
+struct AlgorithmResult {
+    std::vector<AlgorithmObject> objects;
+    std::vector<AlgorithmKeyPoint> key_points;
+
+    void clear() {
+        objects.clear();
+        key_points.clear();
+    }
+
+    void add(int x1, int y1, int x2, int y2, int category, float score, const float* key_point_data, int key_point_count) {
+        objects.push_back({ x1, y1, x2, y2, category, score, static_cast<int>(key_points.size()), key_point_count });
+        for (int i = 0; i < key_point_count; i++)
+            key_points.push_back({ key_point_data[i * 3], key_point_data[i * 3 + 1], key_point_data[i * 3 + 2] });
+    }
+
+    const AlgorithmKeyPoint* key_points_of(const AlgorithmObject& object) const {
+        return key_points.data() + object.key_point_offset;
+    }
+};
+
+// 调用方提供的结果数组 (C 入口 detect_objects 使用), 模块直接写入, 不经过 AlgorithmResult.
+// 目标按检出顺序 (得分从高到低) 写入, 直到目标数组或关键点数组任一写不下为止, 之后的目标只计入 total;
+// 写入的部分与 AlgorithmResult 的前缀相同, key_point_offset 为在 key_points 中的位置
+struct AlgorithmResultBuffer {
+    AlgorithmObject* objects;
+    int object_capacity;
+    AlgorithmKeyPoint* key_points;
+    int key_point_capacity;
+    int object_count = 0;       // 已写入的目标数
+    int key_point_count = 0;    // 已写入的关键点数
+    int total = 0;              // 检出的目标总数
+
+    AlgorithmResultBuffer(AlgorithmObject* objects_, int object_capacity_, AlgorithmKeyPoint* key_points_, int key_point_capacity_)
+        : objects(objects_), object_capacity(object_capacity_), key_points(key_points_), key_point_capacity(key_point_capacity_) {}
+
+    void clear() {
+        object_count = 0;
+        key_point_count = 0;
+        total = 0;
+    }
+
+    void add(int x1, int y1, int x2, int y2, int category, float score, const float* key_point_data, int key_point_count_) {
+        bool fits = object_count == total && object_count < object_capacity && key_point_count + key_point_count_ <= key_point_capacity;
+        total++;
+        if (!fits)
+            return;
+        objects[object_count++] = { x1, y1, x2, y2, category, score, key_point_count, key_point_count_ };
+        for (int i = 0; i < key_point_count_; i++)
+            key_points[key_point_count++] = { key_point_data[i * 3], key_point_data[i * 3 + 1], key_point_data[i * 3 + 2] };
+    }
+
+    // 有目标因容量不足 (目标或关键点) 未写入
+    bool truncated() const {
+        return object_count < total;
+    }
+};
+
+// 共享预处理的输入规格: 规格相同的模块可以共用同一次 letterbox (等比缩放 + 填充 + 通道交换)
+struct AlgorithmInputSpec {
+    int width;
+    int height;
+    bool bgr2rgb;
+    unsigned char pad_value;
+
+    bool operator==(const AlgorithmInputSpec& other) const {
+        return width == other.width && height == other.height && bgr2rgb == other.bgr2rgb && pad_value == other.pad_value;
+    }
+};
+
+// 已完成 letterbox 的模型输入, 只读, 可被多个模块同时使用
+struct AlgorithmPreparedInput {
+    cv::Mat image;          // 规格尺寸的 CV_8UC3
+    float ratio;
+    int pad_top;
+    int pad_left;
+    cv::Size source_size;   // 原图尺寸
+};
 
 class AlgorithmBase {
 public:
     virtual ~AlgorithmBase() = default;
     virtual void detect(cv::Mat input_image) = 0;
+    // 检测结果写入 result (先清空)
+    virtual void detect(const cv::Mat& input_image, AlgorithmResult& result) = 0;
+    // 检测结果直接写入调用方的数组 (先清空); 未重写的模块先检测到临时的 AlgorithmResult 再逐个写入
+    virtual void detect(const cv::Mat& input_image, AlgorithmResultBuffer& result) {
+        AlgorithmResult objects;
+        detect(input_image, objects);
+        result.clear();
+        for (const AlgorithmObject& object : objects.objects)
+            result.add(object.x1, object.y1, object.x2, object.y2, object.category, object.score,
+                reinterpret_cast<const float*>(objects.key_points_of(object)), object.key_point_count);
+    }
+    // 多帧检测, results[i] 对应 input_images[i]
+    virtual void detect(const std::vector<cv::Mat>& input_images, std::vector<AlgorithmResult>& results) {
+        results.resize(input_images.size());
+        for (size_t i = 0; i < input_images.size(); i++)
+            detect(input_images[i], results[i]);
+    }
+    // 支持共享预处理的模块返回 true 并填写 spec, 之后可用 detect_prepared 代替 detect
+    virtual bool input_spec(AlgorithmInputSpec& spec) const {
+        return false;
+    }
+    // 以按 input_spec 预处理好的输入检测, 结果写入 result (先清空)
+    virtual void detect_prepared(const AlgorithmPreparedInput& input, AlgorithmResult& result) {
+        result.clear();
+    }
     virtual void init(std::string model_path) = 0;
     virtual void release() = 0;
 };
 
+// C 入口 detect_objects 的实现: BGR 图像不拷贝, 模块把结果直接写入调用方提供的数组 (见 AlgorithmResultBuffer).
+// *object_count / *key_point_count 传入容量, 传出写入的个数; 返回检出的目标总数.
+// 返回值大于传出的 *object_count 表示容量不足 (目标数组或关键点数组), 此时只写入得分最高的前若干个目标 (连同其关键点)
+inline int algorithm_detect_objects(AlgorithmBase* algorithm, const unsigned char* bgr_data, int rows, int cols, size_t step,
+    AlgorithmObject* objects, int* object_count, AlgorithmKeyPoint* key_points, int* key_point_count) {
+    cv::Mat image(rows, cols, CV_8UC3, const_cast<unsigned char*>(bgr_data), step);
+    AlgorithmResultBuffer result(objects, *object_count, key_points, *key_point_count);
+    algorithm->detect(image, result);
+    *object_count = result.object_count;
+    *key_point_count = result.key_point_count;
+    return result.total;
+}
+
+// 模块导出的 C 入口: create() 创建实例, detect_objects() 检测并返回目标数 (见 algorithm_detect_objects)
+extern "C" {
+    typedef AlgorithmBase* create_t();
+    typedef int detect_objects_t(AlgorithmBase* algorithm, const unsigned char* bgr_data, int rows, int cols, size_t step,
+        AlgorithmObject* objects, int* object_count, AlgorithmKeyPoint* key_points, int* key_point_count);
+}
+
 #endif // ALGORITHM_BASE_HPP
@@ -0,0 +1,110 @@
+#pragma once
+#ifndef _DEBUG_DUMP_HPP_
+#define _DEBUG_DUMP_HPP_
+
+#include <mutex>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <cstdlib>
+#include <unordered_map>
+#include <opencv2/opencv.hpp>
+
+#include "Primitives/singleton.hpp"
+#include "Primitives/bounded_blocking_queue.hpp"
+
+namespace glasssix
+{
+	/// <summary>
+	/// Opt-in channel for debug images. Disabled unless ALGORITHM_DEBUG_DUMP names an output directory,
+	/// so production runs pay one branch per call. Each channel is rate limited to one image per
+	/// ALGORITHM_DEBUG_DUMP_INTERVAL_MS (default 1000); images are encoded and written on a background
+	/// thread, and the oldest pending image is dropped when the writer falls behind.
+	/// </summary>
+	class debug_dump : public singleton<debug_dump>
+	{
+		friend class singleton<debug_dump>;
+	public:
+		debug_dump(const debug_dump&) = delete;
+		debug_dump& operator=(const debug_dump&) = delete;
+
+		~debug_dump()
+		{
+			if (writer_.joinable())
+			{
+				stop_ = true;
+				writer_.join();
+			}
+		}
+
+		bool enabled() const
+		{
+			return !directory_.empty();
+		}
+
+		/// <summary>
+		/// Whether the channel may dump now. Call before preparing the image so that skipped frames cost nothing;
+		/// a true result reserves the slot, so follow it with submit().
+		/// </summary>
+		bool accept(const std::string& channel)
+		{
+			if (!enabled())
+				return false;
+
+			auto now = std::chrono::steady_clock::now();
+			std::lock_guard<std::mutex> lock(mutex_);
+			auto last = last_dump_.find(channel);
+			if (last != last_dump_.end() && now - last->second < interval_)
+				return false;
+
+			last_dump_[channel] = now;
+			return true;
+		}
+
+		/// <summary>
+		/// Queues the image for writing as directory/channel_index.jpg. The image must not be modified afterwards.
+		/// </summary>
+		void submit(const std::string& channel, cv::Mat image)
+		{
+			if (!enabled())
+				return;
+
+			std::string path = directory_ + "/" + channel + "_" + std::to_string(index_++) + ".jpg";
+			queue_.enqueue_nowait(std::make_pair(std::move(path), std::move(image)));
+		}
+
+	private:
+		debug_dump() : queue_(queue_capacity)
+		{
+			const char* directory = std::getenv("ALGORITHM_DEBUG_DUMP");
+			if (directory == nullptr || *directory == '\0')
+				return;
+
+			directory_ = directory;
+			const char* interval = std::getenv("ALGORITHM_DEBUG_DUMP_INTERVAL_MS");
+			if (interval != nullptr)
+				interval_ = std::chrono::milliseconds(std::atol(interval));
+
+			writer_ = std::thread([this]() {
+				std::pair<std::string, cv::Mat> item;
+				while (!stop_)
+					if (queue_.dequeue_for(item, std::chrono::milliseconds(100)))
+						cv::imwrite(item.first, item.second);
+				});
+		}
+
+		static constexpr unsigned queue_capacity = 4;
+
+		std::string directory_;
+		std::chrono::milliseconds interval_{ 1000 };
+		std::mutex mutex_;
+		std::unordered_map<std::string, std::chrono::steady_clock::time_point> last_dump_;
+		std::atomic<unsigned> index_{ 0 };
+		std::atomic<bool> stop_{ false };
+		memory::bounded_blocking_queue<std::pair<std::string, cv::Mat>> queue_;
+		std::thread writer_;
+	};
+}
+
+#endif
@@ -0,0 +1,228 @@
+#pragma once
+#ifndef _FRAME_FANOUT_HPP_
+#define _FRAME_FANOUT_HPP_
+
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <thread>
+#include <cstdint>
+#include <exception>
+#include <condition_variable>
+#include <opencv2/opencv.hpp>
+
+#include "algorithm_base.hpp"
+#include "Excalibur/operation_letterbox.hpp"
+
+namespace glasssix
+{
+	/// <summary>
+	/// Runs several AlgorithmBase instances on the same frame. Instances that report the same AlgorithmInputSpec share
+	/// one letterbox pass, whose output is handed to all of them read-only through detect_prepared(); instances without
+	/// a spec get the original frame through detect(). Every instance runs on its own thread (the first one on the
+	/// caller's), so models on separate NPU contexts execute in parallel.
+	/// </summary>
+	class frame_fanout
+	{
+	public:
+		frame_fanout() = default;
+		frame_fanout(const frame_fanout&) = delete;
+		frame_fanout& operator=(const frame_fanout&) = delete;
+
+		~frame_fanout()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				stop_ = true;
+			}
+			start_cv_.notify_all();
+			for (auto& entry : detectors_)
+				if (entry->thread.joinable())
+					entry->thread.join();
+		}
+
+		/// <summary>
+		/// Registers an initialized instance and returns its index in the results of run(). Not to be called during run().
+		/// </summary>
+		std::size_t add(std::shared_ptr<AlgorithmBase> algorithm)
+		{
+			auto entry = std::make_unique<detector>();
+			entry->algorithm = std::move(algorithm);
+			entry->index = detectors_.size();
+			entry->generation = generation_;
+
+			AlgorithmInputSpec spec;
+			if (entry->algorithm->input_spec(spec))
+			{
+				for (std::size_t i = 0; i < groups_.size() && entry->group < 0; i++)
+					if (groups_[i]->spec == spec)
+						entry->group = (int)i;
+
+				if (entry->group < 0)
+				{
+					groups_.emplace_back(std::make_unique<input_group>());
+					groups_.back()->spec = spec;
+					entry->group = (int)groups_.size() - 1;
+				}
+			}
+
+			// the first instance runs on the thread that calls run()
+			if (!detectors_.empty())
+			{
+				detector* self = entry.get();
+				entry->thread = std::thread([this, self]() { run_worker(*self); });
+			}
+
+			detectors_.emplace_back(std::move(entry));
+			return detectors_.size() - 1;
+		}
+
+		std::size_t size() const
+		{
+			return detectors_.size();
+		}
+
+		/// <summary>
+		/// Detects on frame with every registered instance; results[i] belongs to the instance returned by the i-th add().
+		/// </summary>
+		void run(const cv::Mat& frame, std::vector<AlgorithmResult>& results)
+		{
+			results.resize(detectors_.size());
+			if (detectors_.empty())
+				return;
+
+			prepare_inputs(frame);
+
+			frame_ = &frame;
+			results_ = &results;
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				pending_ = detectors_.size() - 1;
+				++generation_;
+			}
+			start_cv_.notify_all();
+
+			std::exception_ptr error;
+			try
+			{
+				detect(*detectors_[0]);
+			}
+			catch (...)
+			{
+				error = std::current_exception();
+			}
+
+			std::unique_lock<std::mutex> lock(mutex_);
+			done_cv_.wait(lock, [this]() { return pending_ == 0; });
+			if (!error)
+				error = worker_error_;
+			worker_error_ = nullptr;
+			if (error)
+				std::rethrow_exception(error);
+		}
+
+	private:
+		struct detector
+		{
+			std::shared_ptr<AlgorithmBase> algorithm;
+			// index into groups_, -1 when the instance preprocesses by itself
+			int group = -1;
+			std::size_t index = 0;
+			std::thread thread;
+			std::uint64_t generation = 0;
+		};
+
+		struct input_group
+		{
+			AlgorithmInputSpec spec;
+			excalibur::letterbox letterbox;
+			AlgorithmPreparedInput prepared;
+		};
+
+		void prepare_inputs(const cv::Mat& frame)
+		{
+			if (groups_.empty())
+				return;
+
+			const cv::Mat* input = &frame;
+			if (frame.type() != CV_8UC3)
+			{
+				cv::cvtColor(frame, convert_image_, frame.channels() == 4 ? cv::COLOR_BGRA2BGR : cv::COLOR_GRAY2BGR);
+				input = &convert_image_;
+			}
+
+			for (auto& group : groups_)
+			{
+				AlgorithmPreparedInput& prepared = group->prepared;
+				if (prepared.image.empty())
+					prepared.image = cv::Mat(group->spec.height, group->spec.width, CV_8UC3);
+
+				auto geometry = group->letterbox.run(input->data, input->step, input->cols, input->rows,
+					prepared.image.data, prepared.image.step, prepared.image.cols, prepared.image.rows, group->spec.bgr2rgb, group->spec.pad_value);
+				prepared.ratio = geometry.ratio;
+				prepared.pad_top = geometry.pad_top;
+				prepared.pad_left = geometry.pad_left;
+				prepared.source_size = frame.size();
+			}
+		}
+
+		void detect(detector& entry)
+		{
+			AlgorithmResult& result = (*results_)[entry.index];
+			if (entry.group >= 0)
+				entry.algorithm->detect_prepared(groups_[entry.group]->prepared, result);
+			else
+				entry.algorithm->detect(*frame_, result);
+		}
+
+		void run_worker(detector& self)
+		{
+			while (true)
+			{
+				{
+					std::unique_lock<std::mutex> lock(mutex_);
+					start_cv_.wait(lock, [this, &self]() { return stop_ || generation_ != self.generation; });
+					if (stop_)
+						return;
+					self.generation = generation_;
+				}
+
+				std::exception_ptr error;
+				try
+				{
+					detect(self);
+				}
+				catch (...)
+				{
+					error = std::current_exception();
+				}
+
+				bool last;
+				{
+					std::lock_guard<std::mutex> lock(mutex_);
+					if (error && !worker_error_)
+						worker_error_ = error;
+					last = --pending_ == 0;
+				}
+				if (last)
+					done_cv_.notify_one();
+			}
+		}
+
+		std::vector<std::unique_ptr<detector>> detectors_;
+		std::vector<std::unique_ptr<input_group>> groups_;
+		cv::Mat convert_image_;
+		const cv::Mat* frame_ = nullptr;
+		std::vector<AlgorithmResult>* results_ = nullptr;
+
+		std::mutex mutex_;
+		std::condition_variable start_cv_;
+		std::condition_variable done_cv_;
+		std::uint64_t generation_ = 0;
+		std::size_t pending_ = 0;
+		bool stop_ = false;
+		std::exception_ptr worker_error_;
+	};
+}
+
+#endif
@@ -0,0 +1,379 @@
+#pragma once
+#ifndef _STREAM_SCHEDULER_HPP_
+#define _STREAM_SCHEDULER_HPP_
+
+#include <mutex>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+#include <functional>
+#include <condition_variable>
+#include <opencv2/opencv.hpp>
+
+#include "algorithm_base.hpp"
+#include "Primitives/bounded_blocking_queue.hpp"
+
+namespace glasssix
+{
+	struct stream_scheduler_options
+	{
+		/// <summary>
+		/// Frames kept per stream; when full, submit() drops the oldest one
+		/// </summary>
+		unsigned stream_queue_capacity = 2;
+		/// <summary>
+		/// Largest number of frames passed to one AlgorithmBase batch detect()
+		/// </summary>
+		std::size_t max_batch = 4;
+		/// <summary>
+		/// How long the oldest frame of a partial batch may wait for more frames before the batch is run
+		/// </summary>
+		std::chrono::microseconds max_delay{ 5000 };
+		/// <summary>
+		/// Upper bound on add_stream() calls
+		/// </summary>
+		std::size_t max_streams = 64;
+		/// <summary>
+		/// Called on the worker thread with every exception thrown by a batch detect() or a result callback.
+		/// The worker carries on with the next batch either way; see stream_scheduler_statistics::errors.
+		/// </summary>
+		std::function<void(std::exception_ptr error)> error_callback;
+	};
+
+	struct stream_scheduler_statistics
+	{
+		std::uint64_t submitted;
+		std::uint64_t dropped;
+		std::uint64_t processed;
+		std::uint64_t batches;
+		/// <summary>
+		/// Frames whose batch detect() threw; they get no result callback
+		/// </summary>
+		std::uint64_t failed;
+		/// <summary>
+		/// Exceptions caught from batch detect() and result callbacks
+		/// </summary>
+		std::uint64_t errors;
+		/// <summary>
+		/// submit() to result callback, in microseconds
+		/// </summary>
+		double mean_latency_us;
+		std::uint64_t max_latency_us;
+
+		double mean_batch_size() const
+		{
+			return batches == 0 ? 0.0 : (double)processed / (double)batches;
+		}
+	};
+
+	/// <summary>
+	/// Batches frames from many camera streams in front of a set of AlgorithmBase instances.
+	/// Every stream has its own bounded queue that drops its oldest frame under overload. Each instance is driven by
+	/// one worker thread, which gathers up to max_batch frames round-robin across streams, waiting at most max_delay
+	/// after the oldest gathered frame, and runs them through the batch detect() overload. Give every instance its own
+	/// NPU context (e.g. one per core of an rknn_context_pool) so that the workers run in parallel.
+	/// A stream is held by at most one worker at a time, so its callbacks run in submit order and never concurrently.
+	/// </summary>
+	class stream_scheduler
+	{
+	public:
+		using result_callback = std::function<void(const cv::Mat& frame, const AlgorithmResult& result)>;
+
+		stream_scheduler() = delete;
+		stream_scheduler(const stream_scheduler&) = delete;
+		stream_scheduler& operator=(const stream_scheduler&) = delete;
+
+		/// <param name="algorithms">Initialized instances, each used by exactly one worker thread</param>
+		stream_scheduler(std::vector<std::shared_ptr<AlgorithmBase>> algorithms, const stream_scheduler_options& options = {})
+			: options_(options)
+		{
+			if (algorithms.empty())
+				throw std::invalid_argument("stream_scheduler needs at least one algorithm instance!");
+			if (options_.max_batch == 0)
+				options_.max_batch = 1;
+
+			streams_.reserve(options_.max_streams);
+			workers_.reserve(algorithms.size());
+			for (auto& algorithm : algorithms)
+			{
+				workers_.emplace_back();
+				workers_.back().algorithm = std::move(algorithm);
+			}
+			for (auto& worker : workers_)
+				worker.thread = std::thread([this, &worker]() { run_worker(worker); });
+		}
+
+		~stream_scheduler()
+		{
+			stop();
+		}
+
+		/// <summary>
+		/// Registers a stream and returns its id for submit(). The callback is invoked on a worker thread.
+		/// </summary>
+		int add_stream(result_callback callback)
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			if (streams_.size() == options_.max_streams)
+				throw std::length_error("stream_scheduler: too many streams!");
+
+			streams_.emplace_back(std::make_unique<stream>(options_.stream_queue_capacity, std::move(callback)));
+			stream_count_.store(streams_.size(), std::memory_order_release);
+			return (int)streams_.size() - 1;
+		}
+
+		/// <summary>
+		/// Queues a frame of the stream without blocking. The frame must not be modified afterwards.
+		/// </summary>
+		void submit(int stream_id, cv::Mat frame)
+		{
+			if (stream_id < 0 || (std::size_t)stream_id >= stream_count_.load(std::memory_order_acquire))
+				throw std::out_of_range("stream_scheduler: unknown stream id!");
+
+			stream& target = *streams_[stream_id];
+			target.frames.enqueue_nowait(pending_frame{ std::move(frame), clock::now() });
+			submitted_.fetch_add(1, std::memory_order_relaxed);
+			signal();
+		}
+
+		stream_scheduler_statistics statistics()
+		{
+			stream_scheduler_statistics result{};
+			result.submitted = submitted_.load(std::memory_order_relaxed);
+			result.processed = processed_.load(std::memory_order_relaxed);
+			result.batches = batches_.load(std::memory_order_relaxed);
+			result.failed = failed_.load(std::memory_order_relaxed);
+			result.errors = errors_.load(std::memory_order_relaxed);
+			result.max_latency_us = max_latency_us_.load(std::memory_order_relaxed);
+			result.mean_latency_us = result.processed == 0 ? 0.0 : (double)total_latency_us_.load(std::memory_order_relaxed) / (double)result.processed;
+
+			std::size_t count = stream_count_.load(std::memory_order_acquire);
+			for (std::size_t i = 0; i < count; i++)
+				result.dropped += streams_[i]->frames.overrun_counter();
+			return result;
+		}
+
+		/// <summary>
+		/// Finishes the batches in flight and joins the workers; frames still queued are discarded.
+		/// </summary>
+		void stop()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				if (stop_)
+					return;
+				stop_ = true;
+			}
+			cv_.notify_all();
+			for (auto& worker : workers_)
+				if (worker.thread.joinable())
+					worker.thread.join();
+		}
+
+	private:
+		using clock = std::chrono::steady_clock;
+
+		struct pending_frame
+		{
+			cv::Mat image;
+			clock::time_point enqueued;
+		};
+
+		struct stream
+		{
+			stream(unsigned capacity, result_callback callback) : frames(capacity), callback(std::move(callback)) {}
+
+			memory::bounded_blocking_queue<pending_frame> frames;
+			result_callback callback;
+			// set while a worker holds frames of this stream
+			std::atomic<bool> claimed{ false };
+		};
+
+		struct worker
+		{
+			std::shared_ptr<AlgorithmBase> algorithm;
+			std::thread thread;
+			std::size_t next_stream = 0;
+			std::vector<cv::Mat> images;
+			std::vector<AlgorithmResult> results;
+			std::vector<stream*> owners;
+			std::vector<clock::time_point> enqueued;
+			std::vector<stream*> claimed;
+		};
+
+		// wakes workers; sequence_ lets a worker tell whether anything arrived since it last looked
+		void signal()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				++sequence_;
+			}
+			cv_.notify_all();
+		}
+
+		// one pass over the streams, taking at most one frame from each stream this worker can hold
+		void gather(worker& self)
+		{
+			std::size_t count = stream_count_.load(std::memory_order_acquire);
+			for (std::size_t n = 0; n < count && self.images.size() < options_.max_batch; n++)
+			{
+				stream* candidate = streams_[(self.next_stream + n) % count].get();
+				bool held = std::find(self.claimed.begin(), self.claimed.end(), candidate) != self.claimed.end();
+				if (!held)
+				{
+					if (candidate->frames.empty() || candidate->claimed.exchange(true, std::memory_order_acquire))
+						continue;
+					self.claimed.push_back(candidate);
+				}
+
+				pending_frame frame;
+				if (!candidate->frames.dequeue_for(frame, std::chrono::milliseconds(0)))
+					continue;
+
+				self.images.push_back(std::move(frame.image));
+				self.enqueued.push_back(frame.enqueued);
+				self.owners.push_back(candidate);
+			}
+			if (count > 0)
+				self.next_stream = (self.next_stream + 1) % count;
+		}
+
+		void run_worker(worker& self)
+		{
+			while (true)
+			{
+				std::uint64_t seen;
+				{
+					std::lock_guard<std::mutex> lock(mutex_);
+					if (stop_)
+						return;
+					seen = sequence_;
+				}
+
+				gather(self);
+				if (self.images.empty())
+				{
+					release_claims(self);
+					std::unique_lock<std::mutex> lock(mutex_);
+					cv_.wait(lock, [&]() { return stop_ || sequence_ != seen; });
+					continue;
+				}
+
+				// fill the batch until it is full or the oldest frame reaches its deadline
+				auto deadline = self.enqueued.front() + options_.max_delay;
+				while (self.images.size() < options_.max_batch && clock::now() < deadline)
+				{
+					{
+						std::unique_lock<std::mutex> lock(mutex_);
+						if (!cv_.wait_until(lock, deadline, [&]() { return stop_ || sequence_ != seen; }) || stop_)
+							break;
+						seen = sequence_;
+					}
+					gather(self);
+				}
+
+				run_batch(self);
+			}
+		}
+
+		// An exception from detect() fails the whole batch and one from a callback only that frame's callback;
+		// either is reported and the worker goes on, with the streams of the batch released as usual
+		void run_batch(worker& self)
+		{
+			bool detected = true;
+			try
+			{
+				self.algorithm->detect(self.images, self.results);
+			}
+			catch (...)
+			{
+				detected = false;
+				failed_.fetch_add(self.images.size(), std::memory_order_relaxed);
+				report_error(std::current_exception());
+			}
+
+			if (detected)
+			{
+				auto now = clock::now();
+				for (std::size_t i = 0; i < self.images.size(); i++)
+				{
+					if (self.owners[i]->callback)
+					{
+						try
+						{
+							self.owners[i]->callback(self.images[i], self.results[i]);
+						}
+						catch (...)
+						{
+							report_error(std::current_exception());
+						}
+					}
+
+					auto latency = (std::uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(now - self.enqueued[i]).count();
+					total_latency_us_.fetch_add(latency, std::memory_order_relaxed);
+					auto max_latency = max_latency_us_.load(std::memory_order_relaxed);
+					while (latency > max_latency && !max_latency_us_.compare_exchange_weak(max_latency, latency, std::memory_order_relaxed));
+				}
+				processed_.fetch_add(self.images.size(), std::memory_order_relaxed);
+				batches_.fetch_add(1, std::memory_order_relaxed);
+			}
+
+			self.images.clear();
+			self.owners.clear();
+			self.enqueued.clear();
+			release_claims(self);
+		}
+
+		void report_error(std::exception_ptr error)
+		{
+			errors_.fetch_add(1, std::memory_order_relaxed);
+			if (!options_.error_callback)
+				return;
+
+			try
+			{
+				options_.error_callback(error);
+			}
+			catch (...)
+			{
+			}
+		}
+
+		void release_claims(worker& self)
+		{
+			if (self.claimed.empty())
+				return;
+
+			for (auto* held : self.claimed)
+				held->claimed.store(false, std::memory_order_release);
+			self.claimed.clear();
+			// frames that arrived while the streams were held can now go to other workers
+			signal();
+		}
+
+		stream_scheduler_options options_;
+		std::mutex mutex_;
+		std::condition_variable cv_;
+		std::uint64_t sequence_ = 0;
+		bool stop_ = false;
+		std::vector<std::unique_ptr<stream>> streams_;
+		std::atomic<std::size_t> stream_count_{ 0 };
+		std::vector<worker> workers_;
+
+		std::atomic<std::uint64_t> submitted_{ 0 };
+		std::atomic<std::uint64_t> processed_{ 0 };
+		std::atomic<std::uint64_t> batches_{ 0 };
+		std::atomic<std::uint64_t> failed_{ 0 };
+		std::atomic<std::uint64_t> errors_{ 0 };
+		std::atomic<std::uint64_t> total_latency_us_{ 0 };
+		std::atomic<std::uint64_t> max_latency_us_{ 0 };
+	};
+}
+
+#endif
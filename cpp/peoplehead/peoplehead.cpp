@@ -2,42 +2,81 @@
 #include <iostream>
 #include <string>
 #include "../common/RKNN2Wrapper/rknn2_wrapper.hpp"
+#include "../common/RKNN2Wrapper/rknn_model_registry.hpp"
 #include "../common/YoloFamily/Yolo_wrapper.hpp"
+#include "../common/debug_dump.hpp"
 
 class peoplehead::impl
 {
 public:
     impl(std::string model_path) {
         std::vector<std::string> phai;
-        peoplehead_detect = std::make_shared<rknnwrapper::rknn_wrapper>(phai, model_path + "/head.rknn", 0);
+        peoplehead_detect = rknnwrapper::rknn_model_registry::instance().acquire(phai, model_path + "/head.rknn");
         yolov8_instance = std::make_shared<Yolov8<rknnwrapper::rknn_wrapper>>(1280, 736, peoplehead_detect);
     }
 
     void detect(cv::Mat input_image) {
-        float con_thres = 0.5;
-        float nms_thres = 0.6;
-        auto peoplehead_objects = yolov8_instance->get_objects(input_image, con_thres, nms_thres);
+        detect(input_image, result_);
+
+        // 调试图只在设置 ALGORITHM_DEBUG_DUMP 时限频异步输出
+        if (result_.objects.empty() || !debug_dump::instance().accept("peoplehead"))
+            return;
 
         cv::Mat draw_pic = input_image.clone();
-        std::cout << "peoplehead_object:";
-        for (const auto& peoplehead_object : peoplehead_objects) {
+        for (const auto& peoplehead_object : result_.objects) {
             cv::rectangle(draw_pic, cv::Point(peoplehead_object.x1, peoplehead_object.y1), cv::Point(peoplehead_object.x2, peoplehead_object.y2), cv::Scalar(0, 0, 255), 2);
         }
+        debug_dump::instance().submit("peoplehead", draw_pic);
+    }
 
-        if (!peoplehead_objects.empty()) {
-            cv::imwrite(std::to_string(peoplehead_objects[0].x1) + std::to_string(peoplehead_objects[0].y1) + std::to_string(peoplehead_objects[0].x2) + ".jpg", draw_pic);
-        }
+    // Result 为 AlgorithmResult 或调用方数组 AlgorithmResultBuffer, 目标都由 get_objects 的 sink 直接写入
+    template <typename Result>
+    void detect(const cv::Mat& input_image, Result& result) {
+        result.clear();
+        yolov8_instance->get_objects(input_image, con_thres, nms_thres,
+            [&result](int x1, int y1, int x2, int y2, int category, float score, const float* key_points, int key_point_count) {
+                result.add(x1, y1, x2, y2, category, score, key_points, key_point_count);
+            });
+    }
+
+    // 多帧一次推理, 模型 batch 大于 1 时每 batch 帧只运行一次
+    void detect(const std::vector<cv::Mat>& input_images, std::vector<AlgorithmResult>& results) {
+        results.resize(input_images.size());
+        for (auto& result : results)
+            result.clear();
+        yolov8_instance->get_objects_batch(input_images, con_thres, nms_thres,
+            [&results](size_t frame, int x1, int y1, int x2, int y2, int category, float score, const float* key_points, int key_point_count) {
+                results[frame].add(x1, y1, x2, y2, category, score, key_points, key_point_count);
+            });
+    }
+
+    void input_spec(AlgorithmInputSpec& spec) const {
+        cv::Size input_size = yolov8_instance->input_size();
+        spec = { input_size.width, input_size.height, true, 114 };
+    }
+
+    // 与其他模块共用的预处理结果, 只读
+    void detect_prepared(const AlgorithmPreparedInput& input, AlgorithmResult& result) {
+        pic_process_param param{ input.pad_top, input.pad_left, input.ratio };
+        result.clear();
+        yolov8_instance->get_objects_prepared(input.image, param, input.source_size, con_thres, nms_thres,
+            [&result](int x1, int y1, int x2, int y2, int category, float score, const float* key_points, int key_point_count) {
+                result.add(x1, y1, x2, y2, category, score, key_points, key_point_count);
+            });
     }
 
 private:
+    static constexpr float con_thres = 0.5f;
+    static constexpr float nms_thres = 0.6f;
+
     std::shared_ptr<rknnwrapper::rknn_wrapper> peoplehead_detect;
     std::shared_ptr<Yolov8<rknnwrapper::rknn_wrapper>> yolov8_instance;
+    AlgorithmResult result_;
 };
 
 // peoplehead::peoplehead(std::string model_path) : impl_(std::make_unique<impl>(model_path)) {}
 
 void peoplehead::detect(cv::Mat input_image) {
-    std::cout << "peoplehead detection" << std::endl;
     if (impl_) {
         impl_->detect(input_image);
     } else {
@@ -45,6 +84,51 @@ void peoplehead::detect(cv::Mat input_image) {
     }
 }
 
+void peoplehead::detect(const cv::Mat& input_image, AlgorithmResult& result) {
+    if (impl_) {
+        impl_->detect(input_image, result);
+    } else {
+        result.clear();
+        std::cerr << "Error: impl_ not initialized!" << std::endl;
+    }
+}
+
+void peoplehead::detect(const cv::Mat& input_image, AlgorithmResultBuffer& result) {
+    if (impl_) {
+        impl_->detect(input_image, result);
+    } else {
+        result.clear();
+        std::cerr << "Error: impl_ not initialized!" << std::endl;
+    }
+}
+
+void peoplehead::detect(const std::vector<cv::Mat>& input_images, std::vector<AlgorithmResult>& results) {
+    if (impl_) {
+        impl_->detect(input_images, results);
+    } else {
+        results.resize(input_images.size());
+        for (auto& result : results)
+            result.clear();
+        std::cerr << "Error: impl_ not initialized!" << std::endl;
+    }
+}
+
+bool peoplehead::input_spec(AlgorithmInputSpec& spec) const {
+    if (!impl_)
+        return false;
+    impl_->input_spec(spec);
+    return true;
+}
+
+void peoplehead::detect_prepared(const AlgorithmPreparedInput& input, AlgorithmResult& result) {
+    if (impl_) {
+        impl_->detect_prepared(input, result);
+    } else {
+        result.clear();
+        std::cerr << "Error: impl_ not initialized!" << std::endl;
+    }
+}
+
 void peoplehead::init(std::string model_path) {
     impl_ = std::make_unique<impl>(model_path);
 }
@@ -58,3 +142,8 @@ extern "C" AlgorithmBase* create() {
     std::cout << "create peoplehead\n";
     return new peoplehead();
 }
+
+extern "C" int detect_objects(AlgorithmBase* algorithm, const unsigned char* bgr_data, int rows, int cols, size_t step,
+    AlgorithmObject* objects, int* object_count, AlgorithmKeyPoint* key_points, int* key_point_count) {
+    return algorithm_detect_objects(algorithm, bgr_data, rows, cols, step, objects, object_count, key_points, key_point_count);
+}
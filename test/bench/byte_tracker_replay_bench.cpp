@@ -0,0 +1,152 @@
+// tracker::byte_tracker per-frame update time, Hungarian against greedy assignment, on two replays:
+// the recorded detections of test/data/byte_tracker_replay.txt (10 pedestrians, 100 frames), with the tracking
+// summary against the recorded ids, and a synthetic crowd of 500 objects moving over a 3800x2100 area for 600 frames
+// (10% of them low-scored, 3% missed, 10 false positives per frame), which keeps about 500 tracks alive.
+// Usage: byte_tracker_replay_bench [--repeats n] [--replay file]
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+#include "../unit/tracker_replay.hpp"
+
+#if !defined(BYTE_TRACKER_REPLAY_FILE)
+#define BYTE_TRACKER_REPLAY_FILE "byte_tracker_replay.txt"
+#endif
+
+namespace
+{
+    using frames_t = std::vector<std::vector<tracker_replay::detection>>;
+
+    frames_t make_crowd(std::uint32_t seed)
+    {
+        constexpr int objects = 500;
+        constexpr int frames = 600;
+        constexpr int false_positives = 10;
+        constexpr float width = 3800.f;
+        constexpr float height = 2100.f;
+
+        struct object
+        {
+            float x, y, vx, vy, w, h;
+        };
+
+        std::mt19937 random(seed);
+        std::uniform_real_distribution<float> unit(0.f, 1.f);
+        std::normal_distribution<float> noise(0.f, 1.f);
+        std::vector<object> scene(objects);
+        for (object& o : scene)
+            o = { unit(random) * width, unit(random) * height, (unit(random) - 0.5f) * 6.f, (unit(random) - 0.5f) * 6.f, 20.f + unit(random) * 40.f, 40.f + unit(random) * 80.f };
+
+        frames_t result(frames);
+        for (auto& frame : result)
+        {
+            for (int i = 0; i < objects; i++)
+            {
+                object& o = scene[i];
+                o.x += o.vx;
+                o.y += o.vy;
+                if (o.x < 0.f || o.x > width)
+                    o.vx = -o.vx;
+                if (o.y < 0.f || o.y > height)
+                    o.vy = -o.vy;
+
+                float r = unit(random);
+                if (r < 0.03f)
+                    continue;
+                float score = r < 0.13f ? 0.2f + unit(random) * 0.25f : 0.6f + unit(random) * 0.4f;
+                frame.push_back({ o.x + noise(random), o.y + noise(random), o.x + o.w + noise(random), o.y + o.h + noise(random), score, 0, i });
+            }
+            for (int k = 0; k < false_positives; k++)
+            {
+                float x = unit(random) * width;
+                float y = unit(random) * height;
+                frame.push_back({ x, y, x + 30.f, y + 60.f, 0.3f + unit(random) * 0.5f, 0, -1 });
+            }
+            std::shuffle(frame.begin(), frame.end(), random);
+        }
+        return result;
+    }
+
+    struct timing
+    {
+        double mean_ms = 0.0;
+        double worst_ms = 0.0;
+        std::size_t live_tracks = 0;
+        tracker_replay::summary summary;
+    };
+
+    // The first warmup frames of every repeat are left out of the times, while the track buffers grow
+    timing replay(const frames_t& frames, tracker::assignment_method assignment, int repeats, std::size_t warmup)
+    {
+        tracker::byte_tracker_options options;
+        options.assignment = assignment;
+        tracker::byte_tracker tracker(options);
+
+        timing result;
+        std::size_t timed = 0;
+        double total_ms = 0.0;
+        for (int repeat = 0; repeat < repeats; repeat++)
+        {
+            tracker.reset();
+            tracker_replay::scorer scorer;
+            for (std::size_t f = 0; f < frames.size(); f++)
+            {
+                auto start = std::chrono::steady_clock::now();
+                const std::vector<tracker::tracked_object>& tracks = tracker.update(frames[f]);
+                double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                if (f >= warmup)
+                {
+                    total_ms += ms;
+                    result.worst_ms = std::max(result.worst_ms, ms);
+                    timed++;
+                }
+                scorer.add(frames[f], tracks);
+            }
+            result.summary = scorer.result();
+        }
+        result.mean_ms = timed ? total_ms / timed : 0.0;
+        result.live_tracks = tracker.track_count();
+        return result;
+    }
+
+    void report(const char* name, const frames_t& frames, int repeats, std::size_t warmup)
+    {
+        std::size_t detections = 0;
+        for (const auto& frame : frames)
+            detections += frame.size();
+        std::printf("%s: %zu frames, %.1f detections per frame\n", name, frames.size(), frames.empty() ? 0.0 : static_cast<double>(detections) / frames.size());
+        std::printf("  %-10s %10s %10s %8s %10s %8s %10s\n", "assignment", "mean ms", "worst ms", "live", "outputs", "id sw", "id tracks");
+        for (auto assignment : { tracker::assignment_method::hungarian, tracker::assignment_method::greedy })
+        {
+            timing result = replay(frames, assignment, repeats, warmup);
+            std::printf("  %-10s %10.3f %10.3f %8zu %10zu %8zu %10zu\n", assignment == tracker::assignment_method::hungarian ? "hungarian" : "greedy",
+                result.mean_ms, result.worst_ms, result.live_tracks, result.summary.outputs, result.summary.identity_switches, result.summary.object_tracks);
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int repeats = 3;
+    std::string replay_file = BYTE_TRACKER_REPLAY_FILE;
+    for (int i = 1; i + 1 < argc; i += 2)
+        if (std::strcmp(argv[i], "--repeats") == 0)
+            repeats = std::max(1, std::atoi(argv[i + 1]));
+        else if (std::strcmp(argv[i], "--replay") == 0)
+            replay_file = argv[i + 1];
+
+    frames_t recorded = tracker_replay::load(replay_file);
+    if (recorded.empty())
+    {
+        std::fprintf(stderr, "cannot read %s\n", replay_file.c_str());
+        return 1;
+    }
+    report("recorded", recorded, 100 * repeats, 0);
+    report("crowd", make_crowd(1), repeats, 10);
+    return 0;
+}
@@ -0,0 +1,79 @@
+// Hard NMS on 1k, 5k and 20k boxes: nms_engine (as YoloBase::object_nms runs it) against the NMS it replaced
+// (test/unit/baseline_nms.hpp), with a check that both keep the same boxes in the same order.
+// Boxes come in clusters of about 20 around objects of three classes on a 1920x1080 frame, like the candidates
+// of a YOLO head before NMS.
+#include <chrono>
+#include <random>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "YoloFamily/nms.hpp"
+#include "../unit/baseline_nms.hpp"
+
+namespace
+{
+    constexpr float iou_threshold = 0.6f;
+    constexpr int classes = 3;
+    constexpr int boxes_per_object = 20;
+
+    void make_boxes(std::size_t count, std::uint32_t seed, detection_batch& boxes)
+    {
+        std::mt19937 random(seed);
+        std::uniform_real_distribution<float> unit(0.f, 1.f);
+        boxes.reset();
+        while (boxes.size() < count)
+        {
+            float w = 40.f + 260.f * unit(random);
+            float h = w * (0.5f + 1.5f * unit(random));
+            float cx = 1920.f * unit(random);
+            float cy = 1080.f * unit(random);
+            int label = static_cast<int>(unit(random) * classes);
+            for (int i = 0; i < boxes_per_object && boxes.size() < count; i++)
+            {
+                float bw = w * (0.8f + 0.4f * unit(random));
+                float bh = h * (0.8f + 0.4f * unit(random));
+                float bx = cx + 0.15f * w * (unit(random) - 0.5f) - bw / 2;
+                float by = cy + 0.15f * h * (unit(random) - 0.5f) - bh / 2;
+                boxes.push_back(bx, by, bw, bh, 0.25f + 0.75f * unit(random), label);
+            }
+        }
+    }
+
+    template <typename Run>
+    double mean_ms(int repeats, Run&& run)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < repeats; i++)
+            run();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / repeats;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int repeats = 5;
+    for (int i = 1; i + 1 < argc; i += 2)
+        if (std::strcmp(argv[i], "--repeats") == 0)
+            repeats = std::atoi(argv[i + 1]);
+
+    bool identical = true;
+    std::printf("%-8s %8s %14s %14s %10s %10s\n", "boxes", "kept", "baseline ms", "engine ms", "speedup", "parity");
+    for (std::size_t count : { 1000u, 5000u, 20000u })
+    {
+        detection_batch boxes;
+        make_boxes(count, static_cast<std::uint32_t>(count), boxes);
+
+        yolo_wrapper::nms_engine engine;
+        std::vector<int> expected = baseline_nms::run(boxes, iou_threshold);
+        std::vector<int> actual = engine.run(boxes, iou_threshold);
+        bool same = expected == actual;
+        identical = identical && same;
+
+        double baseline_ms = mean_ms(repeats, [&]() { baseline_nms::run(boxes, iou_threshold); });
+        double engine_ms = mean_ms(repeats, [&]() { engine.run(boxes, iou_threshold); });
+        std::printf("%-8zu %8zu %14.3f %14.3f %9.1fx %10s\n", count, actual.size(), baseline_ms, engine_ms, baseline_ms / engine_ms, same ? "exact" : "DIFFERS");
+    }
+    return identical ? 0 : 1;
+}
@@ -0,0 +1,95 @@
+// Per-frame latency of the RV1106 rknn_wrapper::forward path against the mock runtime.
+//   cached: one input format; the io binding is built on the first frame and reused.
+//   rebind: the input format alternates every frame, so the binding is rebuilt on each call,
+//           which is what every frame paid before the binding was cached.
+// The mock's rknn_create_mem sleeps for --mem-us (default 150) to stand in for the DMA allocation.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <string>
+
+#include "RKNN2Wrapper/rknn2_wrapper.hpp"
+#include "rknn_api_mock.hpp"
+
+using namespace glasssix::rknnwrapper;
+
+namespace
+{
+    struct run_stats
+    {
+        double mean_us;
+        double create_mem_per_frame;
+        double query_per_frame;
+    };
+
+    run_stats run(rknn_wrapper& wrapper, const std::vector<std::uint8_t>& frame, int size, int frames, bool rebind)
+    {
+        std::vector<int> shape = { 1, size, size, 3 };
+        wrapper.forward(frame.data(), shape, RKNN_TENSOR_NHWC);
+
+        auto before = mock_rknn::snapshot();
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < frames; i++)
+        {
+            rknn_tensor_format fmt = rebind && i % 2 == 0 ? RKNN_TENSOR_NCHW : RKNN_TENSOR_NHWC;
+            auto outputs = wrapper.forward(frame.data(), shape, fmt);
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        auto after = mock_rknn::snapshot();
+
+        run_stats stats;
+        stats.mean_us = std::chrono::duration<double, std::micro>(elapsed).count() / frames;
+        stats.create_mem_per_frame = static_cast<double>(after.create_mem - before.create_mem) / frames;
+        stats.query_per_frame = static_cast<double>(after.query - before.query) / frames;
+        return stats;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int frames = 500;
+    int size = 640;
+    int mem_us = 150;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (std::strcmp(argv[i], "--frames") == 0)
+            frames = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--size") == 0)
+            size = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--mem-us") == 0)
+            mem_us = std::atoi(argv[i + 1]);
+    }
+
+    // YOLOv8 detection head: three int8 levels of 64 box + 1 class channels, stored NC1HWC2 by the NPU
+    std::vector<mock_rknn::tensor_desc> outputs;
+    for (std::uint32_t stride : { 8u, 16u, 32u })
+    {
+        mock_rknn::tensor_desc output;
+        output.name = "output" + std::to_string(stride);
+        output.dims = { 1, 65, static_cast<std::uint32_t>(size) / stride, static_cast<std::uint32_t>(size) / stride };
+        output.scale = 0.05f;
+        outputs.push_back(output);
+    }
+    mock_rknn::model_desc model = mock_rknn::image_model(size, size, outputs);
+    model.native_output_fmt = RKNN_TENSOR_NC1HWC2;
+    mock_rknn::set_model(model);
+    mock_rknn::set_create_mem_latency(std::chrono::microseconds(mem_us));
+
+    std::string model_path = "rv1106_io_binding_bench.rknn";
+    mock_rknn::write_model_file(model_path);
+    rknn_wrapper wrapper({}, model_path);
+
+    std::vector<std::uint8_t> frame(static_cast<std::size_t>(size) * size * 3, 114);
+    run_stats cached = run(wrapper, frame, size, frames, false);
+    run_stats rebind = run(wrapper, frame, size, frames, true);
+
+    std::printf("%d frames %dx%d, rknn_create_mem %d us\n", frames, size, size, mem_us);
+    std::printf("%-8s %12s %18s %18s\n", "binding", "us/frame", "create_mem/frame", "query/frame");
+    std::printf("%-8s %12.1f %18.2f %18.2f\n", "cached", cached.mean_us, cached.create_mem_per_frame, cached.query_per_frame);
+    std::printf("%-8s %12.1f %18.2f %18.2f\n", "rebind", rebind.mean_us, rebind.create_mem_per_frame, rebind.query_per_frame);
+
+    std::remove(model_path.c_str());
+    return cached.create_mem_per_frame == 0 ? 0 : 1;
+}
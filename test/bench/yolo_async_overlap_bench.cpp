@@ -0,0 +1,93 @@
+// Per-frame latency of Yolov8::get_objects over a sequence of frames against the mock runtime.
+//   serial:    get_objects(frame) per frame; letterbox, NPU run and decode follow each other.
+//   pipelined: get_objects(frames); frame i + 1 is letterboxed while frame i runs on the NPU.
+// The mock's rknn_run sleeps for --run-us (default 8000) to stand in for the NPU. Frames are square and black so
+// that the mock's outputs score below the threshold: the decode costs next to nothing and the difference between
+// the two modes is the letterbox time hidden behind the run.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <string>
+
+#include "YoloFamily/Yolo_wrapper.hpp"
+#include "rknn_api_mock.hpp"
+
+using namespace glasssix;
+
+namespace
+{
+    constexpr int model_size = 640;
+    constexpr float conf = 0.6f;
+    constexpr float iou_threshold = 0.6f;
+
+    double mean_ms(std::chrono::steady_clock::duration elapsed, int frames)
+    {
+        return std::chrono::duration<double, std::milli>(elapsed).count() / frames;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int frames = 100;
+    int frame_size = 1920;
+    int run_us = 8000;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (std::strcmp(argv[i], "--frames") == 0)
+            frames = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--frame-size") == 0)
+            frame_size = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--run-us") == 0)
+            run_us = std::atoi(argv[i + 1]);
+    }
+
+    // YOLOv8 detection head: three levels of 64 box + 1 class channels
+    std::vector<mock_rknn::tensor_desc> outputs;
+    for (std::uint32_t stride : { 8u, 16u, 32u })
+    {
+        mock_rknn::tensor_desc output;
+        output.name = "output" + std::to_string(stride);
+        output.dims = { 1, 65, model_size / stride, model_size / stride };
+        outputs.push_back(output);
+    }
+    mock_rknn::set_model(mock_rknn::image_model(model_size, model_size, outputs));
+    mock_rknn::set_run_latency(std::chrono::microseconds(run_us));
+
+    std::string model_path = "yolo_async_overlap_bench.rknn";
+    mock_rknn::write_model_file(model_path);
+    auto wrapper = std::make_shared<rknnwrapper::rknn_wrapper>(std::vector<std::string>{}, model_path);
+    Yolov8<rknnwrapper::rknn_wrapper> yolo(model_size, model_size, wrapper);
+
+    std::vector<cv::Mat> images(frames);
+    for (auto& image : images)
+        image = cv::Mat(frame_size, frame_size, CV_8UC3, cv::Scalar(0, 0, 0));
+
+    auto start = std::chrono::steady_clock::now();
+    for (auto& image : images)
+        yolo.preprocess_detection(image, cv::Size(model_size, model_size));
+    double letterbox_ms = mean_ms(std::chrono::steady_clock::now() - start, frames);
+
+    std::size_t serial_objects = 0;
+    start = std::chrono::steady_clock::now();
+    for (auto& image : images)
+        serial_objects += yolo.get_objects(image, conf, iou_threshold).size();
+    double serial_ms = mean_ms(std::chrono::steady_clock::now() - start, frames);
+
+    std::size_t pipelined_objects = 0;
+    start = std::chrono::steady_clock::now();
+    for (auto& objects : yolo.get_objects(images, conf, iou_threshold))
+        pipelined_objects += objects.size();
+    double pipelined_ms = mean_ms(std::chrono::steady_clock::now() - start, frames);
+
+    auto counters = mock_rknn::snapshot();
+    std::printf("%d frames %dx%d -> %dx%d, rknn_run %d us, letterbox %.2f ms/frame\n", frames, frame_size, frame_size, model_size, model_size, run_us, letterbox_ms);
+    std::printf("%-10s %12s %10s\n", "mode", "ms/frame", "objects");
+    std::printf("%-10s %12.2f %10zu\n", "serial", serial_ms, serial_objects);
+    std::printf("%-10s %12.2f %10zu\n", "pipelined", pipelined_ms, pipelined_objects);
+    std::printf("overlap %.2f ms/frame, overlapped runs %ld\n", serial_ms - pipelined_ms, counters.overlapped_runs);
+
+    std::remove(model_path.c_str());
+    return pipelined_ms < serial_ms && serial_objects == pipelined_objects && counters.overlapped_runs == 0 ? 0 : 1;
+}
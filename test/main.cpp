@@ -22,7 +22,9 @@ int main() {
     create_t* create_module1 = (create_t*) dlsym(handle1, "create");
     // create_t* create_module2 = (create_t*) dlsym(handle2, "create");
 
-    if (!create_module1 ) {
+    detect_objects_t* detect_objects1 = (detect_objects_t*) dlsym(handle1, "detect_objects");
+
+    if (!create_module1 || !detect_objects1) {
         std::cerr << "Cannot load symbol: " << dlerror() << '\n';
         return 1;
     }
@@ -39,6 +41,23 @@ int main() {
     module1->detect(img);
     // module2->detect();
 
+    // C entry point: results go to caller-owned arrays, capacity in, count out
+    AlgorithmObject objects[256];
+    AlgorithmKeyPoint key_points[256 * 17];
+    int object_count = 256;
+    int key_point_count = 256 * 17;
+    int detected = detect_objects1(module1, img.data, img.rows, img.cols, img.step, objects, &object_count, key_points, &key_point_count);
+    std::cout << "detect_objects: " << detected << " detected, " << object_count << " returned\n";
+    for (int i = 0; i < object_count; i++) {
+        std::cout << objects[i].category << " " << objects[i].score << " [" << objects[i].x1 << ", " << objects[i].y1 << ", "
+            << objects[i].x2 << ", " << objects[i].y2 << "]";
+        for (int k = 0; k < objects[i].key_point_count; k++) {
+            const AlgorithmKeyPoint& point = key_points[objects[i].key_point_offset + k];
+            std::cout << " (" << point.x << ", " << point.y << ")";
+        }
+        std::cout << '\n';
+    }
+
     // Cleanup
     delete module1;
     // delete module2;
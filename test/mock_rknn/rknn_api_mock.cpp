@@ -0,0 +1,721 @@
+// Host-only implementation of the rknn runtime API, see rknn_api_mock.hpp.
+#include "rknn_api_mock.hpp"
+
+#include <mutex>
+#include <cmath>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+#include <unordered_map>
+
+namespace
+{
+    struct mock_context
+    {
+        std::vector<rknn_tensor_attr> input_attrs;
+        std::vector<rknn_tensor_attr> output_attrs;
+        std::vector<rknn_tensor_attr> native_output_attrs;
+
+        // Inputs fed by rknn_inputs_set, and memory bound by rknn_set_io_mem
+        std::vector<std::vector<std::uint8_t>> inputs;
+        std::vector<rknn_tensor_type> input_types;
+        std::vector<rknn_tensor_mem*> input_mems;
+        std::vector<rknn_tensor_mem*> output_mems;
+
+        // Value of every sample of the last run
+        std::vector<float> sample_values;
+
+        std::atomic<int> running{ 0 };
+        rknn_core_mask core_mask = RKNN_NPU_CORE_AUTO;
+    };
+
+    struct mock_state
+    {
+        std::mutex mutex;
+        mock_rknn::model_desc model;
+        std::unordered_map<rknn_context, std::shared_ptr<mock_context>> contexts;
+        rknn_context next_context = 1;
+        std::chrono::microseconds run_latency{ 0 };
+        std::chrono::microseconds create_mem_latency{ 0 };
+        int failing_runs = 0;
+        mock_rknn::output_pattern pattern;
+
+        std::atomic<long> init{ 0 };
+        std::atomic<long> shared_weight_init{ 0 };
+        std::atomic<long> dup{ 0 };
+        std::atomic<long> destroy{ 0 };
+        std::atomic<long> query{ 0 };
+        std::atomic<long> inputs_set{ 0 };
+        std::atomic<long> run{ 0 };
+        std::atomic<long> outputs_get{ 0 };
+        std::atomic<long> outputs_release{ 0 };
+        std::atomic<long> create_mem{ 0 };
+        std::atomic<long> destroy_mem{ 0 };
+        std::atomic<long> set_io_mem{ 0 };
+        std::atomic<long> set_core_mask{ 0 };
+        std::atomic<long> overlapped_runs{ 0 };
+        std::atomic<long> running{ 0 };
+        std::atomic<long> max_concurrent_runs{ 0 };
+        std::atomic<long> live_mems{ 0 };
+    };
+
+    mock_state& state()
+    {
+        static mock_state instance;
+        return instance;
+    }
+
+    std::shared_ptr<mock_context> find_context(rknn_context context)
+    {
+        auto& s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        auto found = s.contexts.find(context);
+        return found == s.contexts.end() ? nullptr : found->second;
+    }
+
+    std::uint32_t element_size(rknn_tensor_type type)
+    {
+        switch (type)
+        {
+        case RKNN_TENSOR_FLOAT32:
+        case RKNN_TENSOR_INT32:
+        case RKNN_TENSOR_UINT32:
+            return 4;
+        case RKNN_TENSOR_FLOAT16:
+        case RKNN_TENSOR_INT16:
+        case RKNN_TENSOR_UINT16:
+            return 2;
+        case RKNN_TENSOR_INT64:
+            return 8;
+        default:
+            return 1;
+        }
+    }
+
+    rknn_tensor_attr make_attr(std::uint32_t index, const mock_rknn::tensor_desc& desc)
+    {
+        rknn_tensor_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.index = index;
+        attr.n_dims = static_cast<std::uint32_t>(desc.dims.size());
+        attr.n_elems = 1;
+        for (std::size_t d = 0; d < desc.dims.size() && d < RKNN_MAX_DIMS; d++)
+        {
+            attr.dims[d] = desc.dims[d];
+            attr.n_elems *= desc.dims[d];
+        }
+        std::strncpy(attr.name, desc.name.c_str(), RKNN_MAX_NAME_LEN - 1);
+        attr.fmt = desc.fmt;
+        attr.type = desc.type;
+        attr.qnt_type = RKNN_TENSOR_QNT_AFFINE_ASYMMETRIC;
+        attr.zp = desc.zp;
+        attr.scale = desc.scale;
+        attr.size = attr.n_elems * element_size(desc.type);
+        attr.size_with_stride = attr.size;
+        if (desc.fmt == RKNN_TENSOR_NHWC && attr.n_dims == 4)
+            attr.w_stride = attr.dims[2];
+        return attr;
+    }
+
+    // NCHW output as the NPU stores it natively: [N, C1, H, W, C2] with C2 = 16 int8 / 8 fp16 channels
+    rknn_tensor_attr make_native_attr(const rknn_tensor_attr& output, rknn_tensor_format fmt)
+    {
+        rknn_tensor_attr attr = output;
+        if (fmt != RKNN_TENSOR_NC1HWC2 || output.n_dims != 4)
+            return attr;
+
+        std::uint32_t c2 = output.type == RKNN_TENSOR_FLOAT16 ? 8 : 16;
+        std::uint32_t c1 = (output.dims[1] + c2 - 1) / c2;
+        attr.fmt = RKNN_TENSOR_NC1HWC2;
+        attr.n_dims = 5;
+        attr.dims[0] = output.dims[0];
+        attr.dims[1] = c1;
+        attr.dims[2] = output.dims[2];
+        attr.dims[3] = output.dims[3];
+        attr.dims[4] = c2;
+        attr.size_with_stride = output.dims[0] * c1 * output.dims[2] * output.dims[3] * c2 * element_size(output.type);
+        return attr;
+    }
+
+    std::shared_ptr<mock_context> create_context(const mock_rknn::model_desc& model)
+    {
+        auto context = std::make_shared<mock_context>();
+        for (std::size_t i = 0; i < model.inputs.size(); i++)
+            context->input_attrs.push_back(make_attr(static_cast<std::uint32_t>(i), model.inputs[i]));
+        for (std::size_t i = 0; i < model.outputs.size(); i++)
+        {
+            context->output_attrs.push_back(make_attr(static_cast<std::uint32_t>(i), model.outputs[i]));
+            context->native_output_attrs.push_back(make_native_attr(context->output_attrs.back(), model.native_output_fmt));
+        }
+        context->inputs.resize(model.inputs.size());
+        context->input_types.assign(model.inputs.size(), RKNN_TENSOR_UINT8);
+        context->input_mems.assign(model.inputs.size(), nullptr);
+        context->output_mems.assign(model.outputs.size(), nullptr);
+        return context;
+    }
+
+    rknn_context register_context(std::shared_ptr<mock_context> context)
+    {
+        auto& s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        rknn_context id = s.next_context++;
+        s.contexts.emplace(id, std::move(context));
+        return id;
+    }
+
+    std::int8_t quantize(float value, std::int32_t zp, float scale)
+    {
+        float q = std::nearbyint(value / scale) + zp;
+        return static_cast<std::int8_t>(std::min(127.f, std::max(-128.f, q)));
+    }
+
+    // Exact for the small integers the mock produces
+    std::uint16_t to_half(float value)
+    {
+        std::uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        std::uint32_t sign = (bits >> 16) & 0x8000u;
+        std::int32_t exponent = static_cast<std::int32_t>((bits >> 23) & 0xff) - 127 + 15;
+        if ((bits & 0x7fffffffu) == 0)
+            return static_cast<std::uint16_t>(sign);
+        if (exponent >= 31)
+            return static_cast<std::uint16_t>(sign | 0x7c00u);
+        if (exponent <= 0)
+            return static_cast<std::uint16_t>(sign);
+        return static_cast<std::uint16_t>(sign | (exponent << 10) | ((bits >> 13) & 0x3ffu));
+    }
+
+    // Fills elems elements of type at dst; the output holds samples equal parts, sample b takes values[b],
+    // or pattern(output, element, values[b]) when a pattern is set
+    void fill_output(void* dst, rknn_tensor_type type, std::size_t elems, std::uint32_t samples, const std::vector<float>& values, std::int32_t zp, float scale,
+        std::size_t output, const mock_rknn::output_pattern& pattern)
+    {
+        std::size_t sample_elems = samples == 0 ? elems : elems / samples;
+        for (std::size_t e = 0; e < elems; e++)
+        {
+            std::size_t sample = sample_elems == 0 ? 0 : std::min(e / sample_elems, values.size() - 1);
+            float value = pattern ? pattern(output, e - sample * sample_elems, values[sample]) : values[sample];
+            switch (type)
+            {
+            case RKNN_TENSOR_FLOAT32:
+                static_cast<float*>(dst)[e] = value;
+                break;
+            case RKNN_TENSOR_FLOAT16:
+                static_cast<std::uint16_t*>(dst)[e] = to_half(value);
+                break;
+            case RKNN_TENSOR_UINT8:
+                static_cast<std::uint8_t*>(dst)[e] = static_cast<std::uint8_t>(value);
+                break;
+            default:
+                static_cast<std::int8_t*>(dst)[e] = quantize(value, zp, scale);
+                break;
+            }
+        }
+    }
+
+    void update_maximum(std::atomic<long>& maximum, long value)
+    {
+        long current = maximum.load();
+        while (value > current && !maximum.compare_exchange_weak(current, value))
+        {
+        }
+    }
+}
+
+namespace mock_rknn
+{
+    model_desc image_model(std::uint32_t width, std::uint32_t height, std::vector<tensor_desc> outputs, std::uint32_t batch)
+    {
+        model_desc model;
+        tensor_desc input;
+        input.name = "images";
+        input.dims = { batch, height, width, 3 };
+        input.fmt = RKNN_TENSOR_NHWC;
+        input.type = RKNN_TENSOR_UINT8;
+        input.zp = 0;
+        model.inputs.push_back(input);
+        model.outputs = std::move(outputs);
+        return model;
+    }
+
+    void set_model(const model_desc& model)
+    {
+        auto& s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.model = model;
+    }
+
+    void set_run_latency(std::chrono::microseconds latency)
+    {
+        auto& s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.run_latency = latency;
+    }
+
+    void set_create_mem_latency(std::chrono::microseconds latency)
+    {
+        auto& s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.create_mem_latency = latency;
+    }
+
+    void fail_next_runs(int count)
+    {
+        auto& s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.failing_runs = count;
+    }
+
+    void set_output_pattern(output_pattern pattern)
+    {
+        auto& s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.pattern = std::move(pattern);
+    }
+
+    counters snapshot()
+    {
+        auto& s = state();
+        counters result;
+        result.init = s.init;
+        result.shared_weight_init = s.shared_weight_init;
+        result.dup = s.dup;
+        result.destroy = s.destroy;
+        result.query = s.query;
+        result.inputs_set = s.inputs_set;
+        result.run = s.run;
+        result.outputs_get = s.outputs_get;
+        result.outputs_release = s.outputs_release;
+        result.create_mem = s.create_mem;
+        result.destroy_mem = s.destroy_mem;
+        result.set_io_mem = s.set_io_mem;
+        result.set_core_mask = s.set_core_mask;
+        result.overlapped_runs = s.overlapped_runs;
+        result.max_concurrent_runs = s.max_concurrent_runs;
+        result.live_mems = s.live_mems;
+        std::lock_guard<std::mutex> lock(s.mutex);
+        result.live_contexts = static_cast<long>(s.contexts.size());
+        return result;
+    }
+
+    void reset()
+    {
+        auto& s = state();
+        {
+            std::lock_guard<std::mutex> lock(s.mutex);
+            s.run_latency = std::chrono::microseconds(0);
+            s.create_mem_latency = std::chrono::microseconds(0);
+            s.failing_runs = 0;
+            s.pattern = nullptr;
+        }
+        for (auto* counter : { &s.init, &s.shared_weight_init, &s.dup, &s.destroy, &s.query, &s.inputs_set, &s.run, &s.outputs_get, &s.outputs_release,
+            &s.create_mem, &s.destroy_mem, &s.set_io_mem, &s.set_core_mask, &s.overlapped_runs, &s.max_concurrent_runs })
+            *counter = 0;
+    }
+
+    void write_model_file(const std::string& path)
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << "RKNN mock model";
+    }
+}
+
+extern "C" {
+
+int rknn_init(rknn_context* context, void* model, uint32_t size, uint32_t flag, rknn_init_extend* extend)
+{
+    if (context == nullptr || model == nullptr)
+        return RKNN_ERR_PARAM_INVALID;
+    if (size == 0 && !std::ifstream(static_cast<const char*>(model)))
+        return RKNN_ERR_MODEL_INVALID;
+    if ((flag & RKNN_FLAG_SHARE_WEIGHT_MEM) != 0 && (extend == nullptr || find_context(extend->ctx) == nullptr))
+        return RKNN_ERR_CTX_INVALID;
+
+    auto& s = state();
+    mock_rknn::model_desc desc;
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        desc = s.model;
+    }
+    if (desc.inputs.empty() || desc.outputs.empty())
+        return RKNN_ERR_MODEL_INVALID;
+
+    *context = register_context(create_context(desc));
+    s.init++;
+    if ((flag & RKNN_FLAG_SHARE_WEIGHT_MEM) != 0)
+        s.shared_weight_init++;
+    return RKNN_SUCC;
+}
+
+int rknn_dup_context(rknn_context* context_in, rknn_context* context_out)
+{
+    if (context_in == nullptr || context_out == nullptr)
+        return RKNN_ERR_PARAM_INVALID;
+
+    auto parent = find_context(*context_in);
+    if (parent == nullptr)
+        return RKNN_ERR_CTX_INVALID;
+
+    auto context = std::make_shared<mock_context>();
+    context->input_attrs = parent->input_attrs;
+    context->output_attrs = parent->output_attrs;
+    context->native_output_attrs = parent->native_output_attrs;
+    context->inputs.resize(parent->input_attrs.size());
+    context->input_types.assign(parent->input_attrs.size(), RKNN_TENSOR_UINT8);
+    context->input_mems.assign(parent->input_attrs.size(), nullptr);
+    context->output_mems.assign(parent->output_attrs.size(), nullptr);
+    *context_out = register_context(std::move(context));
+    state().dup++;
+    return RKNN_SUCC;
+}
+
+int rknn_destroy(rknn_context context)
+{
+    auto& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (s.contexts.erase(context) == 0)
+        return RKNN_ERR_CTX_INVALID;
+    s.destroy++;
+    return RKNN_SUCC;
+}
+
+int rknn_query(rknn_context context, rknn_query_cmd cmd, void* info, uint32_t size)
+{
+    auto found = find_context(context);
+    if (found == nullptr)
+        return RKNN_ERR_CTX_INVALID;
+    if (info == nullptr)
+        return RKNN_ERR_PARAM_INVALID;
+    state().query++;
+
+    auto query_attr = [info, size](const std::vector<rknn_tensor_attr>& attrs) {
+        if (size < sizeof(rknn_tensor_attr))
+            return RKNN_ERR_PARAM_INVALID;
+        auto* attr = static_cast<rknn_tensor_attr*>(info);
+        if (attr->index >= attrs.size())
+            return RKNN_ERR_PARAM_INVALID;
+        *attr = attrs[attr->index];
+        return RKNN_SUCC;
+    };
+
+    switch (cmd)
+    {
+    case RKNN_QUERY_IN_OUT_NUM:
+    {
+        if (size < sizeof(rknn_input_output_num))
+            return RKNN_ERR_PARAM_INVALID;
+        auto* io_num = static_cast<rknn_input_output_num*>(info);
+        io_num->n_input = static_cast<uint32_t>(found->input_attrs.size());
+        io_num->n_output = static_cast<uint32_t>(found->output_attrs.size());
+        return RKNN_SUCC;
+    }
+    case RKNN_QUERY_INPUT_ATTR:
+    case RKNN_QUERY_NATIVE_INPUT_ATTR:
+        return query_attr(found->input_attrs);
+    case RKNN_QUERY_OUTPUT_ATTR:
+        return query_attr(found->output_attrs);
+    case RKNN_QUERY_NATIVE_OUTPUT_ATTR:
+        return query_attr(found->native_output_attrs);
+    case RKNN_QUERY_SDK_VERSION:
+    {
+        if (size < sizeof(rknn_sdk_version))
+            return RKNN_ERR_PARAM_INVALID;
+        auto* version = static_cast<rknn_sdk_version*>(info);
+        std::strcpy(version->api_version, "mock");
+        std::strcpy(version->drv_version, "mock");
+        return RKNN_SUCC;
+    }
+    default:
+        return RKNN_ERR_PARAM_INVALID;
+    }
+}
+
+int rknn_inputs_set(rknn_context context, uint32_t n_inputs, rknn_input inputs[])
+{
+    auto found = find_context(context);
+    if (found == nullptr)
+        return RKNN_ERR_CTX_INVALID;
+    if (inputs == nullptr || n_inputs != found->input_attrs.size())
+        return RKNN_ERR_PARAM_INVALID;
+
+    for (uint32_t i = 0; i < n_inputs; i++)
+    {
+        const rknn_input& input = inputs[i];
+        if (input.index >= found->input_attrs.size() || input.buf == nullptr)
+            return RKNN_ERR_PARAM_INVALID;
+
+        // A uint8 or float buffer holding the whole input
+        const rknn_tensor_attr& attr = found->input_attrs[input.index];
+        if (input.size != attr.n_elems * element_size(input.type))
+            return RKNN_ERR_INPUT_INVALID;
+
+        auto* data = static_cast<const std::uint8_t*>(input.buf);
+        found->inputs[input.index].assign(data, data + input.size);
+        found->input_types[input.index] = input.type;
+    }
+    state().inputs_set++;
+    return RKNN_SUCC;
+}
+
+int rknn_set_batch_core_num(rknn_context context, int core_num)
+{
+    return find_context(context) == nullptr ? RKNN_ERR_CTX_INVALID : RKNN_SUCC;
+}
+
+int rknn_set_core_mask(rknn_context context, rknn_core_mask core_mask)
+{
+    auto found = find_context(context);
+    if (found == nullptr)
+        return RKNN_ERR_CTX_INVALID;
+    found->core_mask = core_mask;
+    state().set_core_mask++;
+    return RKNN_SUCC;
+}
+
+int rknn_run(rknn_context context, rknn_run_extend* extend)
+{
+    auto found = find_context(context);
+    if (found == nullptr)
+        return RKNN_ERR_CTX_INVALID;
+
+    auto& s = state();
+    std::chrono::microseconds latency;
+    bool fail;
+    mock_rknn::output_pattern pattern;
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        latency = s.run_latency;
+        pattern = s.pattern;
+        fail = s.failing_runs > 0;
+        if (fail)
+            s.failing_runs--;
+    }
+    s.run++;
+    if (fail)
+        return RKNN_ERR_FAIL;
+
+    if (found->running.fetch_add(1) > 0)
+        s.overlapped_runs++;
+    update_maximum(s.max_concurrent_runs, ++s.running);
+
+    // Sample b of the input starts at b * size / batch, in the bound memory when there is one
+    const rknn_tensor_attr& attr = found->input_attrs[0];
+    std::uint32_t batch = attr.n_dims > 0 && attr.dims[0] > 0 ? attr.dims[0] : 1;
+    std::vector<float> values(batch, 0.f);
+    if (found->input_mems[0] != nullptr)
+    {
+        auto* data = static_cast<const std::uint8_t*>(found->input_mems[0]->virt_addr);
+        std::size_t sample_bytes = attr.size_with_stride / batch;
+        for (std::uint32_t b = 0; b < batch; b++)
+            values[b] = data[b * sample_bytes];
+    }
+    else if (!found->inputs[0].empty())
+    {
+        const auto& input = found->inputs[0];
+        std::size_t sample_bytes = input.size() / batch;
+        for (std::uint32_t b = 0; b < batch; b++)
+        {
+            if (found->input_types[0] == RKNN_TENSOR_FLOAT32)
+                std::memcpy(&values[b], input.data() + b * sample_bytes, sizeof(float));
+            else
+                values[b] = input[b * sample_bytes];
+        }
+    }
+    else
+    {
+        found->running--;
+        s.running--;
+        return RKNN_ERR_INPUT_INVALID;
+    }
+
+    if (latency.count() > 0)
+        std::this_thread::sleep_for(latency);
+
+    // Bound outputs (RV1106) are written at the end of the run, like the NPU does
+    for (std::size_t i = 0; i < found->output_mems.size(); i++)
+    {
+        rknn_tensor_mem* mem = found->output_mems[i];
+        if (mem == nullptr)
+            continue;
+        const rknn_tensor_attr& native = found->native_output_attrs[i];
+        std::size_t elems = native.size_with_stride / element_size(native.type);
+        fill_output(mem->virt_addr, native.type, elems, native.dims[0], values, native.zp, native.scale, i, pattern);
+    }
+    found->sample_values = std::move(values);
+
+    s.running--;
+    found->running--;
+    if (extend != nullptr)
+        extend->frame_id = static_cast<uint64_t>(s.run.load());
+    return RKNN_SUCC;
+}
+
+int rknn_wait(rknn_context context, rknn_run_extend* extend)
+{
+    return find_context(context) == nullptr ? RKNN_ERR_CTX_INVALID : RKNN_SUCC;
+}
+
+int rknn_outputs_get(rknn_context context, uint32_t n_outputs, rknn_output outputs[], rknn_output_extend* extend)
+{
+    auto found = find_context(context);
+    if (found == nullptr)
+        return RKNN_ERR_CTX_INVALID;
+    if (outputs == nullptr || n_outputs > found->output_attrs.size())
+        return RKNN_ERR_PARAM_INVALID;
+    if (found->sample_values.empty())
+        return RKNN_ERR_FAIL;
+
+    mock_rknn::output_pattern pattern;
+    {
+        std::lock_guard<std::mutex> lock(state().mutex);
+        pattern = state().pattern;
+    }
+
+    for (uint32_t i = 0; i < n_outputs; i++)
+    {
+        rknn_output& output = outputs[i];
+        if (output.index >= found->output_attrs.size())
+            return RKNN_ERR_PARAM_INVALID;
+
+        const rknn_tensor_attr& attr = found->output_attrs[output.index];
+        rknn_tensor_type type = output.want_float ? RKNN_TENSOR_FLOAT32 : attr.type;
+        uint32_t bytes = attr.n_elems * element_size(type);
+        if (output.is_prealloc)
+        {
+            if (output.buf == nullptr || output.size < bytes)
+                return RKNN_ERR_PARAM_INVALID;
+        }
+        else
+        {
+            output.buf = std::malloc(bytes);
+            output.size = bytes;
+        }
+        fill_output(output.buf, type, attr.n_elems, attr.dims[0], found->sample_values, attr.zp, attr.scale, output.index, pattern);
+    }
+    if (extend != nullptr)
+        extend->frame_id = static_cast<uint64_t>(state().run.load());
+    state().outputs_get++;
+    return RKNN_SUCC;
+}
+
+int rknn_outputs_release(rknn_context context, uint32_t n_ouputs, rknn_output outputs[])
+{
+    if (find_context(context) == nullptr)
+        return RKNN_ERR_CTX_INVALID;
+
+    for (uint32_t i = 0; i < n_ouputs; i++)
+    {
+        if (!outputs[i].is_prealloc)
+        {
+            std::free(outputs[i].buf);
+            outputs[i].buf = nullptr;
+        }
+    }
+    state().outputs_release++;
+    return RKNN_SUCC;
+}
+
+rknn_tensor_mem* rknn_create_mem(rknn_context ctx, uint32_t size)
+{
+    if (find_context(ctx) == nullptr || size == 0)
+        return nullptr;
+
+    auto& s = state();
+    std::chrono::microseconds latency;
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        latency = s.create_mem_latency;
+    }
+    if (latency.count() > 0)
+        std::this_thread::sleep_for(latency);
+
+    auto* mem = static_cast<rknn_tensor_mem*>(std::calloc(1, sizeof(rknn_tensor_mem)));
+    mem->virt_addr = std::calloc(size, 1);
+    mem->size = size;
+    mem->fd = -1;
+    mem->flags = RKNN_TENSOR_MEMORY_FLAGS_ALLOC_INSIDE;
+    s.create_mem++;
+    s.live_mems++;
+    return mem;
+}
+
+rknn_tensor_mem* rknn_create_mem_from_phys(rknn_context ctx, uint64_t phys_addr, void* virt_addr, uint32_t size)
+{
+    return nullptr;
+}
+
+rknn_tensor_mem* rknn_create_mem_from_fd(rknn_context ctx, int32_t fd, void* virt_addr, uint32_t size, int32_t offset)
+{
+    return nullptr;
+}
+
+rknn_tensor_mem* rknn_create_mem_from_mb_blk(rknn_context ctx, void* mb_blk, int32_t offset)
+{
+    return nullptr;
+}
+
+int rknn_destroy_mem(rknn_context ctx, rknn_tensor_mem* mem)
+{
+    auto found = find_context(ctx);
+    if (found == nullptr)
+        return RKNN_ERR_CTX_INVALID;
+    if (mem == nullptr)
+        return RKNN_ERR_PARAM_INVALID;
+
+    // Memory still bound to the context is unbound first
+    std::replace(found->input_mems.begin(), found->input_mems.end(), mem, static_cast<rknn_tensor_mem*>(nullptr));
+    std::replace(found->output_mems.begin(), found->output_mems.end(), mem, static_cast<rknn_tensor_mem*>(nullptr));
+    std::free(mem->virt_addr);
+    std::free(mem);
+    state().destroy_mem++;
+    state().live_mems--;
+    return RKNN_SUCC;
+}
+
+int rknn_set_weight_mem(rknn_context ctx, rknn_tensor_mem* mem)
+{
+    return find_context(ctx) == nullptr ? RKNN_ERR_CTX_INVALID : RKNN_SUCC;
+}
+
+int rknn_set_internal_mem(rknn_context ctx, rknn_tensor_mem* mem)
+{
+    return find_context(ctx) == nullptr ? RKNN_ERR_CTX_INVALID : RKNN_SUCC;
+}
+
+int rknn_set_io_mem(rknn_context ctx, rknn_tensor_mem* mem, rknn_tensor_attr* attr)
+{
+    auto found = find_context(ctx);
+    if (found == nullptr)
+        return RKNN_ERR_CTX_INVALID;
+    if (mem == nullptr || attr == nullptr)
+        return RKNN_ERR_PARAM_INVALID;
+
+    // The tensor is told apart by name, as the runtime does
+    for (std::size_t i = 0; i < found->input_attrs.size(); i++)
+    {
+        if (std::strncmp(found->input_attrs[i].name, attr->name, RKNN_MAX_NAME_LEN) != 0)
+            continue;
+        if (mem->size < found->input_attrs[i].size_with_stride)
+            return RKNN_ERR_PARAM_INVALID;
+        found->input_mems[i] = mem;
+        state().set_io_mem++;
+        return RKNN_SUCC;
+    }
+    for (std::size_t i = 0; i < found->output_attrs.size(); i++)
+    {
+        if (std::strncmp(found->output_attrs[i].name, attr->name, RKNN_MAX_NAME_LEN) != 0)
+            continue;
+        if (mem->size < found->native_output_attrs[i].size_with_stride)
+            return RKNN_ERR_PARAM_INVALID;
+        found->output_mems[i] = mem;
+        state().set_io_mem++;
+        return RKNN_SUCC;
+    }
+    return RKNN_ERR_PARAM_INVALID;
+}
+
+}
@@ -0,0 +1,97 @@
+#pragma once
+#ifndef _RKNN_API_MOCK_HPP_
+#define _RKNN_API_MOCK_HPP_
+
+#include <chrono>
+#include <string>
+#include <functional>
+#include <vector>
+#include <cstdint>
+
+#include "rknn_api.h"
+
+// Host-only stand-in for librknnrt / librknnmrt. Implements the rknn_* entry points used by
+// RKNN2Wrapper so that the wrapper, the YOLO decoders and the body / peoplehead modules can be
+// built and tested without an NPU. The functions below configure the fake model and read back
+// what the wrapper did with it.
+//
+// Every rknn_run copies the bound input, sleeps for the configured latency and produces outputs
+// that identify the input: all elements of output sample b equal the first byte of input sample b
+// (quantized with the output's zp / scale for int8 outputs). A caller that receives another
+// caller's result therefore sees the wrong value.
+namespace mock_rknn
+{
+    struct tensor_desc
+    {
+        std::string name;
+        std::vector<std::uint32_t> dims;
+        rknn_tensor_format fmt = RKNN_TENSOR_NCHW;
+        rknn_tensor_type type = RKNN_TENSOR_INT8;
+        std::int32_t zp = -128;
+        float scale = 1.f;
+    };
+
+    // Inputs are NHWC uint8; outputs are NCHW with the given type. Native outputs (RV1106 io binding)
+    // have the output dims and type with native_output_fmt.
+    struct model_desc
+    {
+        std::vector<tensor_desc> inputs;
+        std::vector<tensor_desc> outputs;
+        rknn_tensor_format native_output_fmt = RKNN_TENSOR_NCHW;
+    };
+
+    // One NHWC uint8 input of batch x height x width x 3 and the given int8 outputs
+    model_desc image_model(std::uint32_t width, std::uint32_t height, std::vector<tensor_desc> outputs, std::uint32_t batch = 1);
+
+    // Model used by contexts created afterwards (rknn_init); duplicated contexts copy their parent's
+    void set_model(const model_desc& model);
+
+    // Time spent inside every rknn_run
+    void set_run_latency(std::chrono::microseconds latency);
+
+    // Time spent inside every rknn_create_mem, standing in for the DMA allocation and mapping
+    void set_create_mem_latency(std::chrono::microseconds latency);
+
+    // Makes the next count calls of rknn_run fail with RKNN_ERR_FAIL
+    void fail_next_runs(int count);
+
+    // Element element of output output, in a sample whose input starts with tag, becomes pattern(output, element, tag)
+    // instead of tag; element counts in the layout the output is returned in. An empty pattern restores the default.
+    using output_pattern = std::function<float(std::size_t output, std::size_t element, float tag)>;
+    void set_output_pattern(output_pattern pattern);
+
+    struct counters
+    {
+        long init = 0;
+        // rknn_init calls with RKNN_FLAG_SHARE_WEIGHT_MEM, also counted in init
+        long shared_weight_init = 0;
+        long dup = 0;
+        long destroy = 0;
+        long query = 0;
+        long inputs_set = 0;
+        long run = 0;
+        long outputs_get = 0;
+        long outputs_release = 0;
+        long create_mem = 0;
+        long destroy_mem = 0;
+        long set_io_mem = 0;
+        long set_core_mask = 0;
+        // rknn_run entered on a context that another thread was still running
+        long overlapped_runs = 0;
+        // Largest number of rknn_run calls in progress at once, over all contexts
+        long max_concurrent_runs = 0;
+        // Contexts and memory blocks not yet destroyed
+        long live_contexts = 0;
+        long live_mems = 0;
+    };
+
+    counters snapshot();
+
+    // Clears the counters, the latency, pending failures and the output pattern; the model is kept
+    void reset();
+
+    // Writes a placeholder model file; rknn_init only checks that it is not empty
+    void write_model_file(const std::string& path);
+}
+
+#endif
@@ -0,0 +1,85 @@
+#pragma once
+#ifndef _BASELINE_NMS_HPP_
+#define _BASELINE_NMS_HPP_
+
+#include <vector>
+#include <algorithm>
+
+#include "YoloFamily/detection_batch.hpp"
+
+// The NMS YoloBase ran before nms_engine, kept verbatim as the reference for the parity test and the benchmark:
+// boxes are (x, y, w, h, score, label) rows, classes are moved apart by adding label * 100000 to x, and one
+// greedy pass over all boxes rebuilds the remaining index list after every kept box.
+namespace baseline_nms
+{
+    using Box = std::vector<float>;
+
+    inline float intersectionOverUnion(const Box& box1, const Box& box2) {
+        float x1 = std::max(box1[0], box2[0]);
+        float y1 = std::max(box1[1], box2[1]);
+        float x2 = std::min(box1[0] + box1[2], box2[0] + box2[2]);
+        float y2 = std::min(box1[1] + box1[3], box2[1] + box2[3]);
+
+        if (x1 >= x2 || y1 >= y2) {
+            return 0.0f;
+        }
+
+        float intersection_area = (x2 - x1) * (y2 - y1);
+        float area1 = box1[2] * box1[3];
+        float area2 = box2[2] * box2[3];
+        float union_area = area1 + area2 - intersection_area;
+
+        return intersection_area / union_area;
+    }
+
+    inline std::vector<int> object_nms(const std::vector<Box>& boxes, float iou_threshold)
+    {
+        std::vector<int> indices(boxes.size());
+        for (size_t i = 0; i < boxes.size(); i++)
+            indices[i] = i;
+
+        std::vector<float> scores;
+        for (size_t i = 0; i < boxes.size(); ++i)
+            scores.push_back(boxes[i][4]);
+
+        std::sort(indices.begin(), indices.end(), [&scores](int a, int b) {
+            return scores[a] > scores[b];
+            });
+
+        std::vector<int> keep;
+        while (indices.size() > 0)
+        {
+            int idx = indices[0];
+            keep.push_back(idx);
+
+            std::vector<int> new_indices;
+            for (size_t i = 1; i < indices.size(); ++i)
+            {
+                int cur_idx = indices[i];
+                if (intersectionOverUnion(boxes[idx], boxes[cur_idx]) <= iou_threshold)
+                    new_indices.push_back(cur_idx);
+            }
+            indices = new_indices;
+        }
+        return keep;
+    }
+
+    inline void box_result_move_to_disjoint_region(std::vector<std::vector<float>>& sou_data, int bias = 100000)
+    {
+        for (size_t i = 0; i < sou_data.size(); i++)
+            sou_data[i][0] = sou_data[i][0] + sou_data[i][5] * bias;
+    }
+
+    // The whole former sequence on a copy of boxes (top-left xywh): offset, NMS; returns the kept indices
+    inline std::vector<int> run(const detection_batch& boxes, float iou_threshold)
+    {
+        std::vector<Box> rows(boxes.size());
+        for (size_t i = 0; i < boxes.size(); i++)
+            rows[i] = { boxes.x[i], boxes.y[i], boxes.w[i], boxes.h[i], boxes.score[i], static_cast<float>(boxes.label[i]) };
+
+        box_result_move_to_disjoint_region(rows, 100000);
+        return object_nms(rows, iou_threshold);
+    }
+}
+
+#endif
@@ -0,0 +1,141 @@
+// The batch detect overload of body and peoplehead, loaded through create() from their mock-linked shared libraries:
+// a batch of frames gives the same objects as detecting each frame alone, and runs the model once per model batch,
+// i.e. once per frame on a batch-1 model and ceil(frames / 4) times on a batch-4 model.
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <dlfcn.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <opencv2/opencv.hpp>
+
+#include "algorithm_base.hpp"
+#include "rknn_api_mock.hpp"
+#include "test_support.hpp"
+
+#if !defined(BODY_MOCK_MODULE)
+#define BODY_MOCK_MODULE "libbody_mock.so"
+#endif
+#if !defined(PEOPLEHEAD_MOCK_MODULE)
+#define PEOPLEHEAD_MOCK_MODULE "libpeoplehead_mock.so"
+#endif
+
+namespace
+{
+    constexpr int model_width = 1280;
+    constexpr int model_height = 736;
+    constexpr int frames = 6;
+    const int strides[] = { 8, 16, 32 };
+
+    // Frame tag's outputs: DFL logits that vary with the frame, and a different handful of confident cells per frame
+    float frame_pattern(std::size_t output, std::size_t element, float tag)
+    {
+        std::uint32_t frame = static_cast<std::uint32_t>(tag);
+        std::size_t cells = static_cast<std::size_t>(model_width / strides[output]) * (model_height / strides[output]);
+        if (element / cells < 64)
+            return static_cast<float>((element * 7 + frame * 13) % 11) * 0.3f - 1.5f;
+        std::size_t cell = element % cells;
+        return (cell + frame * 37) % 211 == 0 ? 1.f + 0.25f * static_cast<float>(cell % 7) : -10.f;
+    }
+
+    void set_model(std::uint32_t batch)
+    {
+        std::vector<mock_rknn::tensor_desc> outputs;
+        for (int stride : strides)
+        {
+            mock_rknn::tensor_desc output;
+            output.name = "output" + std::to_string(stride);
+            output.dims = { batch, 65, static_cast<std::uint32_t>(model_height / stride), static_cast<std::uint32_t>(model_width / stride) };
+            outputs.push_back(output);
+        }
+        mock_rknn::set_model(mock_rknn::image_model(model_width, model_height, outputs, batch));
+    }
+
+    bool same_result(const AlgorithmResult& a, const AlgorithmResult& b)
+    {
+        if (a.objects.size() != b.objects.size() || a.key_points.size() != b.key_points.size())
+            return false;
+        for (std::size_t i = 0; i < a.objects.size(); i++)
+        {
+            const AlgorithmObject& x = a.objects[i];
+            const AlgorithmObject& y = b.objects[i];
+            if (x.x1 != y.x1 || x.y1 != y.y1 || x.x2 != y.x2 || x.y2 != y.y2 || x.category != y.category || x.score != y.score)
+                return false;
+        }
+        return true;
+    }
+
+    void test_module(const char* path, const std::string& model_path, long expected_batch_runs)
+    {
+        // Kept mapped after dlclose: the module's decode thread pool outlives the instance
+        void* handle = dlopen(path, RTLD_NOW | RTLD_NODELETE);
+        EXPECT(handle != nullptr);
+        if (handle == nullptr)
+        {
+            std::fprintf(stderr, "dlopen %s: %s\n", path, dlerror());
+            return;
+        }
+
+        auto create = reinterpret_cast<create_t*>(dlsym(handle, "create"));
+        EXPECT(create != nullptr);
+        if (create != nullptr)
+        {
+            AlgorithmBase* algorithm = create();
+            algorithm->init(model_path);
+
+            std::vector<cv::Mat> images;
+            for (int frame = 0; frame < frames; frame++)
+                images.emplace_back(model_height, model_width, CV_8UC3, cv::Scalar(frame + 1, frame + 1, frame + 1));
+
+            std::vector<AlgorithmResult> expected(frames);
+            std::size_t objects = 0;
+            for (int frame = 0; frame < frames; frame++)
+            {
+                algorithm->detect(images[frame], expected[frame]);
+                objects += expected[frame].objects.size();
+            }
+            EXPECT(objects > 0);
+            EXPECT(!same_result(expected[0], expected[1]));
+
+            // Results left from a larger earlier batch must not leak into a smaller one
+            std::vector<AlgorithmResult> results(frames + 2);
+            long before = mock_rknn::snapshot().run;
+            algorithm->detect(images, results);
+            EXPECT_EQ(expected_batch_runs, mock_rknn::snapshot().run - before);
+            EXPECT_EQ(static_cast<std::size_t>(frames), results.size());
+            for (int frame = 0; frame < frames && frame < static_cast<int>(results.size()); frame++)
+                EXPECT(same_result(expected[frame], results[frame]));
+
+            delete algorithm;
+        }
+        dlclose(handle);
+    }
+}
+
+int main()
+{
+    mock_rknn::set_output_pattern(frame_pattern);
+
+    std::string model_path = "batch_detect_models";
+    mkdir(model_path.c_str(), 0755);
+    mock_rknn::write_model_file(model_path + "/pedestrian.rknn");
+    mock_rknn::write_model_file(model_path + "/head.rknn");
+
+    // Batch-1 model: one run per frame
+    set_model(1);
+    test_module(BODY_MOCK_MODULE, model_path, frames);
+    test_module(PEOPLEHEAD_MOCK_MODULE, model_path, frames);
+
+    // Batch-4 model: 6 frames in two runs, the second one padded
+    set_model(4);
+    test_module(BODY_MOCK_MODULE, model_path, (frames + 3) / 4);
+    test_module(PEOPLEHEAD_MOCK_MODULE, model_path, (frames + 3) / 4);
+
+    std::remove((model_path + "/pedestrian.rknn").c_str());
+    std::remove((model_path + "/head.rknn").c_str());
+    rmdir(model_path.c_str());
+    std::printf("batch_detect_test: %d failures\n", test_failures());
+    return test_failures();
+}
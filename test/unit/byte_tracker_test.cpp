@@ -0,0 +1,111 @@
+// tracker::byte_tracker on the recorded detections in test/data/byte_tracker_replay.txt, with both assignment
+// methods: every reported box is finite and comes from a detection with positive width and height, clutter is not
+// reported, and the recorded pedestrians keep their track ids through the crossings and occlusions.
+// Detections with zero or negative width or height, or NaN coordinates, are ignored instead of starting tracks
+// whose Kalman state (aspect ratio w / h) turns into NaN.
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+#include <cstdio>
+
+#include "tracker_replay.hpp"
+#include "test_support.hpp"
+
+#if !defined(BYTE_TRACKER_REPLAY_FILE)
+#define BYTE_TRACKER_REPLAY_FILE "byte_tracker_replay.txt"
+#endif
+
+namespace
+{
+    bool finite(const tracker::tracked_object& track)
+    {
+        return std::isfinite(track.x1) && std::isfinite(track.y1) && std::isfinite(track.x2) && std::isfinite(track.y2) && std::isfinite(track.score);
+    }
+
+    void test_replay(const std::vector<std::vector<tracker_replay::detection>>& frames, tracker::assignment_method assignment)
+    {
+        tracker::byte_tracker_options options;
+        options.assignment = assignment;
+        tracker::byte_tracker tracker(options);
+        tracker_replay::scorer scorer;
+
+        int bad_tracks = 0;
+        for (const auto& frame : frames)
+        {
+            const std::vector<tracker::tracked_object>& tracks = tracker.update(frame);
+            for (const tracker::tracked_object& track : tracks)
+            {
+                bool valid = finite(track) && track.x2 > track.x1 && track.y2 > track.y1 && track.detection >= 0 && track.detection < static_cast<int>(frame.size());
+                if (valid)
+                {
+                    const tracker_replay::detection& detection = frame[track.detection];
+                    valid = detection.x2 > detection.x1 && detection.y2 > detection.y1;
+                }
+                bad_tracks += !valid;
+            }
+            scorer.add(frame, tracks);
+        }
+
+        // 10 pedestrians over 100 frames, clutter never lives long enough to be confirmed. At the crossings a
+        // low-scored occluded pedestrian can sit on its neighbour's track for a few frames (4 switches, 11 tracks
+        // when recorded); the bounds leave a little room for floating point differences between builds
+        const tracker_replay::summary& summary = scorer.result();
+        EXPECT_EQ(0, bad_tracks);
+        EXPECT(summary.outputs > 800);
+        EXPECT_EQ(static_cast<std::size_t>(0), summary.clutter);
+        EXPECT(summary.identity_switches <= 6);
+        EXPECT(summary.object_tracks <= 13);
+    }
+
+    struct box
+    {
+        float x1;
+        float y1;
+        float x2;
+        float y2;
+        float score;
+        int category;
+    };
+
+    void test_degenerate_boxes()
+    {
+        const float nan = std::numeric_limits<float>::quiet_NaN();
+        tracker::byte_tracker tracker;
+        for (int frame = 0; frame < 5; frame++)
+        {
+            float x = 100.f + 4.f * frame;
+            std::vector<box> boxes = {
+                { 600.f, 720.f, 640.f, 720.f, 0.9f, 0 },        // clipped to zero height
+                { 300.f, 200.f, 280.f, 260.f, 0.9f, 0 },        // negative width
+                { 900.f, 300.f, 900.f, 300.f, 0.9f, 0 },        // a point
+                { nan, 100.f, 950.f, 200.f, 0.9f, 0 },
+                { x, 100.f, x + 50.f, 250.f, 0.9f, 0 },
+            };
+            const std::vector<tracker::tracked_object>& tracks = tracker.update(boxes);
+            EXPECT_EQ(static_cast<std::size_t>(1), tracks.size());
+            for (const tracker::tracked_object& track : tracks)
+            {
+                EXPECT(finite(track));
+                EXPECT_EQ(4, track.detection);
+                EXPECT_EQ(1, track.track_id);
+            }
+        }
+        EXPECT_EQ(static_cast<std::size_t>(1), tracker.track_count());
+    }
+}
+
+int main()
+{
+    std::vector<std::vector<tracker_replay::detection>> frames = tracker_replay::load(BYTE_TRACKER_REPLAY_FILE);
+    EXPECT_EQ(static_cast<std::size_t>(100), frames.size());
+    if (!frames.empty())
+    {
+        test_replay(frames, tracker::assignment_method::hungarian);
+        test_replay(frames, tracker::assignment_method::greedy);
+    }
+    test_degenerate_boxes();
+
+    std::printf("byte_tracker_test: %d failures\n", test_failures());
+    return test_failures();
+}
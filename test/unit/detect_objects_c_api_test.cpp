@@ -0,0 +1,170 @@
+// The C entry point detect_objects of the body module, looked up with dlsym like a C host would: results land in
+// the caller's arrays (capacity in, count written out), match detect(image, result) when they fit, and when they
+// don't, the call still reports the full count and writes a consistent prefix with key point offsets into the
+// caller's key point array. Running out of key point room truncates the same way: the objects whose key points do
+// not fit are left out, and the returned total exceeds the written count.
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <dlfcn.h>
+
+#include <opencv2/opencv.hpp>
+
+#include "algorithm_base.hpp"
+#include "rknn_api_mock.hpp"
+#include "test_support.hpp"
+
+#if !defined(BODY_MOCK_MODULE)
+#define BODY_MOCK_MODULE "libbody_mock.so"
+#endif
+
+namespace
+{
+    constexpr int model_width = 1280;
+    constexpr int model_height = 736;
+    const int strides[] = { 8, 16, 32 };
+
+    // Flat DFL logits (every box 15 strides wide) and a handful of scattered cells with a confident class score
+    float sparse_pattern(std::size_t output, std::size_t element, float)
+    {
+        std::size_t cells = static_cast<std::size_t>(model_width / strides[output]) * (model_height / strides[output]);
+        if (element / cells < 64)
+            return 0.f;
+        std::size_t cell = element % cells;
+        return cell % 211 == 0 ? 1.f + 0.25f * static_cast<float>(cell % 7) : -10.f;
+    }
+
+    bool same_object(const AlgorithmObject& a, const AlgorithmObject& b)
+    {
+        return a.x1 == b.x1 && a.y1 == b.y1 && a.x2 == b.x2 && a.y2 == b.y2 && a.category == b.category && a.score == b.score && a.key_point_count == b.key_point_count;
+    }
+
+    // Three objects with two key points each, through AlgorithmBase's default buffer detect
+    class key_point_algorithm : public AlgorithmBase
+    {
+    public:
+        using AlgorithmBase::detect;
+
+        void detect(cv::Mat) override {}
+
+        void detect(const cv::Mat&, AlgorithmResult& result) override
+        {
+            result.clear();
+            for (int i = 0; i < 3; i++)
+            {
+                float key_points[6] = { 1.f * i, 2.f * i, 0.5f, 3.f * i, 4.f * i, 0.75f };
+                result.add(i, i, 10 + i, 10 + i, 0, 0.9f - 0.1f * i, key_points, 2);
+            }
+        }
+
+        void init(std::string) override {}
+        void release() override {}
+    };
+
+    void test_key_point_capacity()
+    {
+        key_point_algorithm algorithm;
+        unsigned char pixel[3] = { 0, 0, 0 };
+        AlgorithmObject objects[8];
+        AlgorithmKeyPoint key_points[8];
+
+        // Room for every object but only one object's key points
+        int object_count = 8;
+        int key_point_count = 3;
+        int total = algorithm_detect_objects(&algorithm, pixel, 1, 1, 3, objects, &object_count, key_points, &key_point_count);
+        EXPECT_EQ(3, total);
+        EXPECT_EQ(1, object_count);
+        EXPECT_EQ(2, key_point_count);
+        EXPECT(total > object_count);
+        EXPECT_EQ(0, objects[0].key_point_offset);
+        EXPECT(key_points[1].x == 0.f && key_points[1].score == 0.75f);
+
+        // Exactly enough room
+        object_count = 3;
+        key_point_count = 6;
+        total = algorithm_detect_objects(&algorithm, pixel, 1, 1, 3, objects, &object_count, key_points, &key_point_count);
+        EXPECT_EQ(3, total);
+        EXPECT_EQ(3, object_count);
+        EXPECT_EQ(6, key_point_count);
+        EXPECT_EQ(4, objects[2].key_point_offset);
+        EXPECT(key_points[5].x == 6.f && key_points[5].y == 8.f);
+    }
+}
+
+int main()
+{
+    std::vector<mock_rknn::tensor_desc> outputs;
+    for (int stride : strides)
+    {
+        mock_rknn::tensor_desc output;
+        output.name = "output" + std::to_string(stride);
+        output.dims = { 1, 65, static_cast<std::uint32_t>(model_height / stride), static_cast<std::uint32_t>(model_width / stride) };
+        outputs.push_back(output);
+    }
+    mock_rknn::set_model(mock_rknn::image_model(model_width, model_height, outputs));
+    mock_rknn::set_output_pattern(sparse_pattern);
+    mock_rknn::write_model_file("pedestrian.rknn");
+
+    void* handle = dlopen(BODY_MOCK_MODULE, RTLD_NOW);
+    EXPECT(handle != nullptr);
+    if (handle != nullptr)
+    {
+        auto create = reinterpret_cast<create_t*>(dlsym(handle, "create"));
+        auto detect_objects = reinterpret_cast<detect_objects_t*>(dlsym(handle, "detect_objects"));
+        EXPECT(create != nullptr);
+        EXPECT(detect_objects != nullptr);
+        if (create != nullptr && detect_objects != nullptr)
+        {
+            AlgorithmBase* algorithm = create();
+            algorithm->init(".");
+
+            // A C caller's BGR buffer with padded rows: step larger than cols * 3
+            std::size_t step = (model_width + 16) * 3;
+            std::vector<unsigned char> buffer(model_height * step, 0);
+            cv::Mat image(model_height, model_width, CV_8UC3, buffer.data(), step);
+
+            AlgorithmResult expected;
+            algorithm->detect(image, expected);
+            int total = static_cast<int>(expected.objects.size());
+            EXPECT(total > 2);
+
+            // Enough room: everything, same as detect
+            std::vector<AlgorithmObject> objects(total + 4);
+            std::vector<AlgorithmKeyPoint> key_points(expected.key_points.size() + 4);
+            int object_count = static_cast<int>(objects.size());
+            int key_point_count = static_cast<int>(key_points.size());
+            EXPECT_EQ(total, detect_objects(algorithm, buffer.data(), model_height, model_width, step, objects.data(), &object_count, key_points.data(), &key_point_count));
+            EXPECT_EQ(total, object_count);
+            EXPECT_EQ(static_cast<int>(expected.key_points.size()), key_point_count);
+            for (int i = 0; i < object_count && i < total; i++)
+            {
+                EXPECT(same_object(expected.objects[i], objects[i]));
+                EXPECT(objects[i].key_point_offset + objects[i].key_point_count <= key_point_count);
+            }
+
+            // Too little room: full count returned, the first objects written
+            object_count = 2;
+            key_point_count = static_cast<int>(key_points.size());
+            EXPECT_EQ(total, detect_objects(algorithm, buffer.data(), model_height, model_width, step, objects.data(), &object_count, key_points.data(), &key_point_count));
+            EXPECT_EQ(2, object_count);
+            EXPECT(same_object(expected.objects[0], objects[0]));
+            EXPECT(same_object(expected.objects[1], objects[1]));
+            EXPECT_EQ(objects[0].key_point_count + objects[1].key_point_count, key_point_count);
+
+            // No room at all
+            object_count = 0;
+            key_point_count = 0;
+            EXPECT_EQ(total, detect_objects(algorithm, buffer.data(), model_height, model_width, step, nullptr, &object_count, nullptr, &key_point_count));
+            EXPECT_EQ(0, object_count);
+            EXPECT_EQ(0, key_point_count);
+
+            delete algorithm;
+        }
+        dlclose(handle);
+    }
+
+    std::remove("pedestrian.rknn");
+    test_key_point_capacity();
+    std::printf("detect_objects_c_api_test: %d failures\n", test_failures());
+    return test_failures();
+}
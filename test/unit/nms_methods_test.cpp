@@ -0,0 +1,87 @@
+// nms_engine's soft_linear, soft_gaussian, diou and matrix modes with zero-area boxes (clipped to a line or a point)
+// among a cluster of normal ones: every score written back stays finite, the kept boxes come out by descending score,
+// and since a zero-area box overlaps nothing its score is not decayed and DIoU never suppresses it. A NaN IoU between
+// two zero-area boxes used to make their Gaussian and matrix decays NaN, and the NaN scores dropped them.
+#include <cmath>
+#include <vector>
+#include <cstdio>
+#include <algorithm>
+
+#include "YoloFamily/nms.hpp"
+#include "test_support.hpp"
+
+namespace
+{
+    constexpr float iou_threshold = 0.5f;
+
+    // Boxes as (x, y, w, h) in one class: every fourth box normal, the others lines, and points at one spot
+    detection_batch make_boxes()
+    {
+        detection_batch boxes;
+        for (int i = 0; i < 27; i++)
+        {
+            float x = 100.f + 2.f * (i % 5);
+            float y = 200.f + 3.f * (i % 3);
+            float score = 0.95f - 0.01f * i;
+            switch (i % 4)
+            {
+            case 0: boxes.push_back(x, y, 60.f, 120.f, score, 0); break;
+            case 1: boxes.push_back(x, y, 0.f, 120.f, score, 0); break;
+            case 2: boxes.push_back(x, y, 60.f, 0.f, score, 0); break;
+            default: boxes.push_back(120.f, 260.f, 0.f, 0.f, score, 0); break;
+            }
+        }
+        return boxes;
+    }
+
+    bool zero_area(const detection_batch& boxes, int i)
+    {
+        return boxes.w[i] * boxes.h[i] == 0.f;
+    }
+
+    void test_method(yolo_wrapper::nms_method method)
+    {
+        detection_batch boxes = make_boxes();
+        detection_batch original = make_boxes();
+        yolo_wrapper::nms_param param;
+        param.method = method;
+
+        yolo_wrapper::nms_engine engine;
+        std::vector<int> kept = engine.run(boxes, iou_threshold, param);
+
+        int not_finite = 0;
+        for (std::size_t i = 0; i < boxes.size(); i++)
+            not_finite += !std::isfinite(boxes.score[i]);
+        EXPECT_EQ(0, not_finite);
+
+        EXPECT(!kept.empty());
+        for (std::size_t k = 1; k < kept.size(); k++)
+            EXPECT(boxes.score[kept[k - 1]] >= boxes.score[kept[k]]);
+
+        // Every zero-area box is kept with its score; the normal boxes overlap and lose score or get suppressed
+        int zero_area_kept = 0;
+        int zero_area_total = 0;
+        for (std::size_t i = 0; i < boxes.size(); i++)
+            zero_area_total += zero_area(boxes, static_cast<int>(i));
+        for (int index : kept)
+        {
+            if (!zero_area(boxes, index))
+                continue;
+            zero_area_kept++;
+            EXPECT(std::fabs(boxes.score[index] - original.score[index]) <= 1e-6f);
+        }
+        EXPECT_EQ(zero_area_total, zero_area_kept);
+        EXPECT(kept.size() < boxes.size() || method != yolo_wrapper::nms_method::diou);
+    }
+}
+
+int main()
+{
+    test_method(yolo_wrapper::nms_method::soft_linear);
+    test_method(yolo_wrapper::nms_method::soft_gaussian);
+    test_method(yolo_wrapper::nms_method::diou);
+    test_method(yolo_wrapper::nms_method::matrix);
+
+    std::printf("nms_methods_test: %d failures\n", test_failures());
+    return test_failures();
+}
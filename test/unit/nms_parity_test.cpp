@@ -0,0 +1,200 @@
+// YoloBase::object_nms (nms_engine, hard) against the NMS it replaced (baseline_nms.hpp) on 200 frames decoded by
+// Yolov8 from the mock runtime. Each frame's outputs hold a few objects of three classes, every one covered by a
+// cluster of overlapping candidate boxes; the kept indices must match the baseline's exactly, in order.
+// Zero-area boxes (clipped to a line or a point) get an IoU of 0 with everything, whether they land in a vector
+// lane of iou_one_to_many or in its scalar tail, and hard NMS still matches the baseline with them among the boxes.
+#include <cmath>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdint>
+
+#include "YoloFamily/Yolo_wrapper.hpp"
+#include "rknn_api_mock.hpp"
+#include "baseline_nms.hpp"
+#include "test_support.hpp"
+
+using namespace glasssix;
+
+namespace
+{
+    constexpr int model_size = 640;
+    constexpr int classes = 3;
+    constexpr int objects_per_frame = 12;
+    constexpr int frames = 200;
+    constexpr float conf = 0.25f;
+    constexpr float iou_threshold = 0.6f;
+    const int strides[] = { 8, 16, 32 };
+
+    // Uniform in [0, 1) from three integers
+    float hash_unit(std::uint32_t a, std::uint32_t b, std::uint32_t c)
+    {
+        std::uint64_t x = (static_cast<std::uint64_t>(a) << 42) ^ (static_cast<std::uint64_t>(b) << 21) ^ c;
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ULL;
+        x ^= x >> 33;
+        return static_cast<float>(x >> 40) / static_cast<float>(1 << 24);
+    }
+
+    // Frame tag's outputs: random DFL logits everywhere; each object raises its class score on the cells
+    // within a couple of strides of its centre, fading with the distance
+    float frame_pattern(std::size_t output, std::size_t element, float tag)
+    {
+        std::uint32_t frame = static_cast<std::uint32_t>(tag);
+        int stride = strides[output];
+        int grid = model_size / stride;
+        int cells = grid * grid;
+        int channel = static_cast<int>(element) / cells;
+        int cell = static_cast<int>(element) % cells;
+        if (channel < 64)
+            return 3.f * hash_unit(frame, static_cast<std::uint32_t>(output), static_cast<std::uint32_t>(element)) - 1.5f;
+
+        int label = channel - 64;
+        float cx = (cell % grid + 0.5f) * stride;
+        float cy = (cell / grid + 0.5f) * stride;
+        float logit = -12.f;
+        for (int object = 0; object < objects_per_frame; object++)
+        {
+            if (static_cast<int>(hash_unit(frame, 1000 + object, 0) * classes) != label)
+                continue;
+            float ox = hash_unit(frame, 1000 + object, 1) * model_size;
+            float oy = hash_unit(frame, 1000 + object, 2) * model_size;
+            float distance = std::hypot(cx - ox, cy - oy) / (2.f * stride);
+            float noise = hash_unit(frame, static_cast<std::uint32_t>(output), static_cast<std::uint32_t>(element));
+            logit = std::max(logit, 2.f - 3.f * distance + noise);
+        }
+        return logit;
+    }
+
+    // Boxes as (x, y, w, h): a cluster of normal boxes, and lines and points on top of them and of each other
+    detection_batch degenerate_boxes()
+    {
+        detection_batch boxes;
+        for (int i = 0; i < 23; i++)
+        {
+            float x = 100.f + 2.f * (i % 5);
+            float y = 200.f + 3.f * (i % 3);
+            float score = 0.95f - 0.01f * i;
+            switch (i % 4)
+            {
+            case 0: boxes.push_back(x, y, 60.f, 120.f, score, 0); break;
+            case 1: boxes.push_back(x, y, 0.f, 120.f, score, 0); break;
+            case 2: boxes.push_back(x, y, 60.f, 0.f, score, 0); break;
+            default: boxes.push_back(120.f, 260.f, 0.f, 0.f, score, 0); break;
+            }
+        }
+        return boxes;
+    }
+
+    void test_degenerate_iou()
+    {
+        detection_batch boxes = degenerate_boxes();
+        std::size_t n = boxes.size();
+        std::vector<float> x1(n), y1(n), x2(n), y2(n), area(n);
+        for (std::size_t i = 0; i < n; i++)
+        {
+            x1[i] = boxes.x[i];
+            y1[i] = boxes.y[i];
+            x2[i] = boxes.x[i] + boxes.w[i];
+            y2[i] = boxes.y[i] + boxes.h[i];
+            area[i] = boxes.w[i] * boxes.h[i];
+        }
+
+        int differing = 0;
+        int not_finite = 0;
+        std::vector<float> row(n);
+        for (std::size_t i = 0; i < n; i++)
+        {
+            // Whole row: the vector lanes and the tail; then each box alone, always through the tail
+            yolo_wrapper::iou_one_to_many(x1[i], y1[i], x2[i], y2[i], area[i], x1.data(), y1.data(), x2.data(), y2.data(), area.data(), n, row.data());
+            for (std::size_t k = 0; k < n; k++)
+            {
+                float single;
+                yolo_wrapper::iou_one_to_many(x1[i], y1[i], x2[i], y2[i], area[i], &x1[k], &y1[k], &x2[k], &y2[k], &area[k], 1, &single);
+                differing += row[k] != single;
+                not_finite += !std::isfinite(row[k]);
+                if (area[i] == 0.f || area[k] == 0.f)
+                    differing += row[k] != 0.f;
+            }
+        }
+        EXPECT_EQ(0, differing);
+        EXPECT_EQ(0, not_finite);
+
+        yolo_wrapper::nms_engine engine;
+        EXPECT(baseline_nms::run(boxes, iou_threshold) == engine.run(boxes, iou_threshold));
+    }
+
+    // Exposes the candidates Yolov8 hands to NMS and the NMS itself
+    class probe : public Yolov8<rknnwrapper::rknn_wrapper>
+    {
+    public:
+        using Yolov8<rknnwrapper::rknn_wrapper>::Yolov8;
+
+        detection_batch& candidates(const cv::Mat& image)
+        {
+            auto model_results = this->infer(image);
+            this->decode(model_results, conf);
+            this->centre_xywh2WH(this->detections_, this->pic_process_param_.pad_h, this->pic_process_param_.pad_w, 1.f / this->pic_process_param_.ratio);
+            return this->detections_;
+        }
+
+        std::vector<int> nms(detection_batch& boxes)
+        {
+            return this->object_nms(boxes, iou_threshold);
+        }
+    };
+}
+
+int main()
+{
+    std::vector<mock_rknn::tensor_desc> outputs;
+    for (int stride : strides)
+    {
+        mock_rknn::tensor_desc output;
+        output.name = "output" + std::to_string(stride);
+        std::uint32_t grid = static_cast<std::uint32_t>(model_size / stride);
+        output.dims = { 1, 64 + classes, grid, grid };
+        outputs.push_back(output);
+    }
+    mock_rknn::set_model(mock_rknn::image_model(model_size, model_size, outputs));
+    mock_rknn::set_output_pattern(frame_pattern);
+
+    std::string model_path = "nms_parity_test.rknn";
+    mock_rknn::write_model_file(model_path);
+    {
+        auto wrapper = std::make_shared<rknnwrapper::rknn_wrapper>(std::vector<std::string>{}, model_path);
+        probe yolo(model_size, model_size, wrapper);
+
+        int differing_frames = 0;
+        std::size_t candidates = 0;
+        std::size_t kept = 0;
+        std::size_t kept_above_class_0 = 0;
+        for (int frame = 0; frame < frames; frame++)
+        {
+            cv::Mat image(model_size, model_size, CV_8UC3, cv::Scalar(frame, frame, frame));
+            detection_batch& boxes = yolo.candidates(image);
+
+            std::vector<int> expected = baseline_nms::run(boxes, iou_threshold);
+            std::vector<int> actual = yolo.nms(boxes);
+            differing_frames += expected != actual;
+
+            candidates += boxes.size();
+            kept += actual.size();
+            for (int index : actual)
+                kept_above_class_0 += boxes.label[index] > 0;
+        }
+
+        std::printf("%d frames, %zu candidates, %zu kept (%zu of classes 1-2)\n", frames, candidates, kept, kept_above_class_0);
+        EXPECT_EQ(0, differing_frames);
+        // The frames must exercise suppression within clusters and the offset classes
+        EXPECT(kept * 4 < candidates);
+        EXPECT(kept_above_class_0 > 0);
+    }
+
+    std::remove(model_path.c_str());
+    test_degenerate_iou();
+    std::printf("nms_parity_test: %d failures\n", test_failures());
+    return test_failures();
+}
@@ -0,0 +1,103 @@
+// rknn_wrapper::forward_async against the mock runtime: frames submitted back to back come back in order with
+// their own outputs, and blocking forward() calls made from another thread while frames are in flight take
+// turns with them on the context instead of running on it at the same time.
+#include <deque>
+#include <thread>
+#include <vector>
+#include <string>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+
+#include <opencv2/opencv.hpp>
+
+#include "RKNN2Wrapper/rknn2_wrapper.hpp"
+#include "rknn_api_mock.hpp"
+#include "test_support.hpp"
+
+using namespace glasssix::rknnwrapper;
+
+namespace
+{
+    constexpr int input_size = 16;
+    constexpr int frames = 200;
+    constexpr std::uint8_t blocking_tag = 255;
+
+    using result_type = std::unordered_map<std::string, std::shared_ptr<glasssix::memory::tensor<float>>>;
+
+    int wrong_elements(const result_type& outputs, std::uint8_t tag)
+    {
+        int wrong = 0;
+        for (auto& output : outputs)
+        {
+            const float* data = output.second->cpu_data();
+            for (int i = 0; i < output.second->count(); i++)
+                wrong += data[i] != tag;
+        }
+        return wrong;
+    }
+
+    void test_in_order(rknn_wrapper& wrapper)
+    {
+        cv::Mat image(input_size, input_size, CV_8UC3);
+        std::deque<std::pair<std::uint8_t, std::shared_future<result_type>>> pending;
+        int wrong = 0;
+        for (int frame = 0; frame < frames; frame++)
+        {
+            std::uint8_t tag = static_cast<std::uint8_t>(frame % blocking_tag);
+            image.data[0] = tag;
+            pending.emplace_back(tag, wrapper.forward_async(image));
+            if (pending.size() == 2)
+            {
+                wrong += wrong_elements(pending.front().second.get(), pending.front().first);
+                pending.pop_front();
+            }
+        }
+        for (auto& frame : pending)
+            wrong += wrong_elements(frame.second.get(), frame.first);
+
+        EXPECT_EQ(0, wrong);
+    }
+
+    void test_blocking_calls_meanwhile(rknn_wrapper& wrapper)
+    {
+        mock_rknn::reset();
+        mock_rknn::set_run_latency(std::chrono::microseconds(200));
+
+        std::atomic<int> blocking_wrong(0);
+        std::thread blocking([&wrapper, &blocking_wrong]() {
+            std::vector<std::uint8_t> frame(input_size * input_size * 3, 0);
+            frame[0] = blocking_tag;
+            std::vector<int> shape = { 1, input_size, input_size, 3 };
+            for (int call = 0; call < frames; call++)
+                blocking_wrong += wrong_elements(wrapper.forward(frame.data(), shape, RKNN_TENSOR_NHWC), blocking_tag);
+        });
+        test_in_order(wrapper);
+        blocking.join();
+
+        auto counters = mock_rknn::snapshot();
+        EXPECT_EQ(0, blocking_wrong.load());
+        EXPECT_EQ(2 * frames, counters.run);
+        EXPECT_EQ(0, counters.overlapped_runs);
+    }
+}
+
+int main()
+{
+    mock_rknn::tensor_desc output;
+    output.name = "output";
+    output.dims = { 1, 4, 8, 8 };
+    mock_rknn::set_model(mock_rknn::image_model(input_size, input_size, { output }));
+
+    std::string model_path = "rknn_forward_async_test.rknn";
+    mock_rknn::write_model_file(model_path);
+    {
+        rknn_wrapper wrapper({}, model_path);
+        test_in_order(wrapper);
+        test_blocking_calls_meanwhile(wrapper);
+    }
+
+    std::remove(model_path.c_str());
+    std::printf("rknn_forward_async_test: %d failures\n", test_failures());
+    return test_failures();
+}
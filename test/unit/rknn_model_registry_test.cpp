@@ -0,0 +1,121 @@
+// rknn_model_registry against the mock runtime: models are shared by content whatever the path they are
+// opened through, and the digest of a path is recomputed only when the file's size or modification time
+// changes. The mock counts the contexts initialized on shared weights.
+#include <string>
+#include <memory>
+#include <cstdio>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include "RKNN2Wrapper/rknn_model_registry.hpp"
+#include "rknn_api_mock.hpp"
+#include "test_support.hpp"
+
+using namespace glasssix::rknnwrapper;
+
+namespace
+{
+    constexpr int input_size = 16;
+
+    void write_file(const std::string& path, const std::string& content)
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file << content;
+    }
+
+    void set_mtime(const std::string& path, const struct timespec& mtime)
+    {
+        struct timespec times[2] = { mtime, mtime };
+        utimensat(AT_FDCWD, path.c_str(), times, 0);
+    }
+
+    struct timespec mtime_of(const std::string& path)
+    {
+        struct stat st;
+        stat(path.c_str(), &st);
+        return st.st_mtim;
+    }
+
+    void test_resolve_model_path()
+    {
+        EXPECT(resolve_model_path("models/head.racy") == "models/head.rknn");
+        EXPECT(resolve_model_path("models/head.rknn") == "models/head.rknn");
+    }
+
+    void test_shared_by_content()
+    {
+        auto& registry = rknn_model_registry::instance();
+        write_file("registry_a.rknn", "RKNN mock model a");
+        write_file("registry_b.rknn", "RKNN mock model a");
+        mock_rknn::reset();
+
+        auto first = registry.acquire({}, "registry_a.racy");
+        auto second = registry.acquire({}, "registry_a.rknn");
+        auto copy = registry.acquire({}, "registry_b.racy");
+        EXPECT_EQ(3, mock_rknn::snapshot().init);
+        EXPECT_EQ(2, mock_rknn::snapshot().shared_weight_init);
+
+        // A file rewritten with other content is another model once its size or modification time moved
+        write_file("registry_a.rknn", "RKNN mock model a, retrained");
+        auto retrained = registry.acquire({}, "registry_a.racy");
+        EXPECT_EQ(4, mock_rknn::snapshot().init);
+        EXPECT_EQ(2, mock_rknn::snapshot().shared_weight_init);
+    }
+
+    void test_digest_cached()
+    {
+        auto& registry = rknn_model_registry::instance();
+        write_file("registry_c.rknn", "RKNN mock model c");
+        mock_rknn::reset();
+
+        auto first = registry.acquire({}, "registry_c.racy");
+
+        // Same size and modification time: the cached digest is used and the file is not hashed again,
+        // so the new content still shares the first model
+        struct timespec mtime = mtime_of("registry_c.rknn");
+        write_file("registry_c.rknn", "RKNN mock model C");
+        set_mtime("registry_c.rknn", mtime);
+        auto cached = registry.acquire({}, "registry_c.racy");
+        EXPECT_EQ(1, mock_rknn::snapshot().shared_weight_init);
+
+        // Touching the file invalidates the entry
+        mtime.tv_sec += 1;
+        set_mtime("registry_c.rknn", mtime);
+        auto rehashed = registry.acquire({}, "registry_c.racy");
+        EXPECT_EQ(3, mock_rknn::snapshot().init);
+        EXPECT_EQ(1, mock_rknn::snapshot().shared_weight_init);
+    }
+
+    void test_missing_file()
+    {
+        bool thrown = false;
+        try
+        {
+            rknn_model_registry::instance().acquire({}, "registry_missing.racy");
+        }
+        catch (const rknn_exception& e)
+        {
+            thrown = e.what_code() == RKNN_ERR_MODEL_INVALID;
+        }
+        EXPECT(thrown);
+    }
+}
+
+int main()
+{
+    mock_rknn::tensor_desc output;
+    output.name = "output";
+    output.dims = { 1, 4, 8, 8 };
+    mock_rknn::set_model(mock_rknn::image_model(input_size, input_size, { output }));
+
+    test_resolve_model_path();
+    test_shared_by_content();
+    test_digest_cached();
+    test_missing_file();
+
+    for (const char* path : { "registry_a.rknn", "registry_b.rknn", "registry_c.rknn" })
+        std::remove(path);
+    std::printf("rknn_model_registry_test: %d failures\n", test_failures());
+    return test_failures();
+}
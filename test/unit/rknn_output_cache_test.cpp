@@ -0,0 +1,108 @@
+// Reuse of rknn_wrapper's output tensors against the mock runtime: results dropped by the caller are reused,
+// results still referenced are never written into, and forward_async's two pending futures do not force a
+// new allocation on every frame.
+#include <set>
+#include <vector>
+#include <string>
+#include <cstdio>
+
+#include <opencv2/opencv.hpp>
+
+#include "RKNN2Wrapper/rknn2_wrapper.hpp"
+#include "rknn_api_mock.hpp"
+#include "test_support.hpp"
+
+using namespace glasssix::rknnwrapper;
+
+namespace
+{
+    constexpr int input_size = 16;
+
+    const float* output_data(const std::unordered_map<std::string, std::shared_ptr<glasssix::memory::tensor<float>>>& outputs)
+    {
+        return outputs.at("output")->cpu_data();
+    }
+
+    void test_forward(rknn_wrapper& wrapper)
+    {
+        cv::Mat image(input_size, input_size, CV_8UC3);
+        image.data[0] = 1;
+        const float* first = output_data(wrapper.forward(image));
+        const float* second = output_data(wrapper.forward(image));
+        EXPECT(first == second);
+
+        // A kept result is neither reused nor overwritten
+        auto kept = wrapper.forward(image);
+        image.data[0] = 2;
+        auto next = wrapper.forward(image);
+        EXPECT(output_data(kept) != output_data(next));
+        EXPECT_EQ(1, static_cast<int>(output_data(kept)[0]));
+        EXPECT_EQ(2, static_cast<int>(output_data(next)[0]));
+
+        // Both dropped: later calls stay within the cached sets
+        kept.clear();
+        next.clear();
+        std::set<const float*> seen;
+        for (int i = 0; i < 10; i++)
+            seen.insert(output_data(wrapper.forward(image)));
+        EXPECT_EQ(1, seen.size());
+    }
+
+    void test_forward_async(rknn_wrapper& wrapper)
+    {
+        cv::Mat image(input_size, input_size, CV_8UC3);
+        std::set<const float*> seen;
+        auto pending = wrapper.forward_async(image);
+        for (int frame = 1; frame <= 30; frame++)
+        {
+            image.data[0] = static_cast<std::uint8_t>(frame);
+            auto next = wrapper.forward_async(image);
+            {
+                auto outputs = pending.get();
+                seen.insert(output_data(outputs));
+                EXPECT_EQ(frame - 1, static_cast<int>(output_data(outputs)[0]));
+            }
+            pending = next;
+        }
+        pending.get();
+
+        // Two slots in flight plus the one being decoded
+        EXPECT(seen.size() <= 3);
+    }
+
+    void test_forward_quantized(rknn_wrapper& wrapper)
+    {
+        cv::Mat image(input_size, input_size, CV_8UC3);
+        const std::int8_t* first = wrapper.forward_quantized(image).at("output").data->cpu_data();
+        const std::int8_t* second = wrapper.forward_quantized(image).at("output").data->cpu_data();
+        EXPECT(first == second);
+
+        auto kept = wrapper.forward_quantized(image);
+        auto next = wrapper.forward_quantized(image);
+        EXPECT(kept.at("output").data->cpu_data() != next.at("output").data->cpu_data());
+    }
+}
+
+int main()
+{
+    mock_rknn::tensor_desc output;
+    output.name = "output";
+    output.dims = { 1, 4, 8, 8 };
+    mock_rknn::set_model(mock_rknn::image_model(input_size, input_size, { output }));
+
+    std::string model_path = "rknn_output_cache_test.rknn";
+    mock_rknn::write_model_file(model_path);
+    {
+        rknn_wrapper wrapper({}, model_path);
+        test_forward(wrapper);
+        test_forward_quantized(wrapper);
+    }
+    {
+        rknn_wrapper wrapper({}, model_path);
+        test_forward_async(wrapper);
+    }
+
+    std::remove(model_path.c_str());
+    std::printf("rknn_output_cache_test: %d failures\n", test_failures());
+    return test_failures();
+}
@@ -0,0 +1,160 @@
+// The vectorized output conversions against their scalar references, compared bit for bit: every int8 value
+// under several zero points and scales, every fp16 value (zeros, subnormals, normals, infinities, quiet and
+// signaling NaNs), runs of every length around the vector widths, and NC1HWC2 layouts with partial planes,
+// several blocks per plane and the C2 > block fallback.
+#include <random>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+
+#include "RKNN2Wrapper/rknn_output_conversions.hpp"
+#include "test_support.hpp"
+
+using namespace glasssix::rknnwrapper;
+
+namespace
+{
+    std::uint32_t bits_of(float value)
+    {
+        std::uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    // Number of elements of actual whose bits differ from expected
+    int mismatches(const std::vector<float>& expected, const std::vector<float>& actual)
+    {
+        int count = 0;
+        for (std::size_t i = 0; i < expected.size(); i++)
+            count += bits_of(expected[i]) != bits_of(actual[i]);
+        return count;
+    }
+
+    void test_int8_to_f32()
+    {
+        std::vector<std::int8_t> src;
+        for (int value = -128; value < 128; value++)
+            src.push_back(static_cast<std::int8_t>(value));
+
+        const std::int32_t zero_points[] = { -128, -14, 0, 5, 127 };
+        const float scales[] = { 1.f, 0.0039215686f, 0.1f, 17.25f };
+        for (std::int32_t zp : zero_points)
+        {
+            for (float scale : scales)
+            {
+                std::vector<float> expected(src.size());
+                std::vector<float> actual(src.size());
+                int8_to_f32_ref(src.data(), expected.data(), src.size(), zp, scale);
+                int8_to_f32(src.data(), actual.data(), src.size(), zp, scale);
+                EXPECT_EQ(0, mismatches(expected, actual));
+            }
+        }
+
+        // Every length up to a few vectors, from an unaligned start
+        for (std::size_t length = 0; length <= 67; length++)
+        {
+            std::vector<float> expected(length + 1, -1.f);
+            std::vector<float> actual(length + 1, -1.f);
+            int8_to_f32_ref(src.data() + 1, expected.data() + 1, length, -14, 0.1f);
+            int8_to_f32(src.data() + 1, actual.data() + 1, length, -14, 0.1f);
+            EXPECT_EQ(0, mismatches(expected, actual));
+        }
+    }
+
+    void test_f16_to_f32()
+    {
+        std::vector<std::uint16_t> src(65536);
+        for (std::size_t i = 0; i < src.size(); i++)
+            src[i] = static_cast<std::uint16_t>(i);
+
+        std::vector<float> expected(src.size());
+        std::vector<float> actual(src.size());
+        f16_to_f32_ref(src.data(), expected.data(), src.size());
+        f16_to_f32(src.data(), actual.data(), src.size());
+        EXPECT_EQ(0, mismatches(expected, actual));
+
+        // Known values, so the reference itself is checked
+        EXPECT_EQ(0x00000000u, bits_of(f16_to_f32_ref(std::uint16_t(0x0000))));
+        EXPECT_EQ(0x80000000u, bits_of(f16_to_f32_ref(std::uint16_t(0x8000))));
+        EXPECT_EQ(0x3F800000u, bits_of(f16_to_f32_ref(std::uint16_t(0x3C00))));
+        EXPECT_EQ(0x33800000u, bits_of(f16_to_f32_ref(std::uint16_t(0x0001))));   // smallest subnormal, 2^-24
+        EXPECT_EQ(0x387FC000u, bits_of(f16_to_f32_ref(std::uint16_t(0x03FF))));   // largest subnormal
+        EXPECT_EQ(0xB8800000u, bits_of(f16_to_f32_ref(std::uint16_t(0x8400))));   // smallest negative normal
+        EXPECT_EQ(0x477FE000u, bits_of(f16_to_f32_ref(std::uint16_t(0x7BFF))));   // 65504
+        EXPECT_EQ(0x7F800000u, bits_of(f16_to_f32_ref(std::uint16_t(0x7C00))));
+        EXPECT_EQ(0xFF800000u, bits_of(f16_to_f32_ref(std::uint16_t(0xFC00))));
+        EXPECT_EQ(0x7FC00000u, bits_of(f16_to_f32_ref(std::uint16_t(0x7E00))));   // quiet NaN
+        EXPECT_EQ(0x7FC02000u, bits_of(f16_to_f32_ref(std::uint16_t(0x7C01))));   // signaling NaN comes back quiet
+        EXPECT_EQ(0xFFFFE000u, bits_of(f16_to_f32_ref(std::uint16_t(0xFFFF))));
+
+        for (std::size_t length = 0; length <= 35; length++)
+        {
+            std::vector<float> expected_run(length + 1, -1.f);
+            std::vector<float> actual_run(length + 1, -1.f);
+            f16_to_f32_ref(src.data() + 0x7BF0, expected_run.data() + 1, length);
+            f16_to_f32(src.data() + 0x7BF0, actual_run.data() + 1, length);
+            EXPECT_EQ(0, mismatches(expected_run, actual_run));
+        }
+    }
+
+    template <typename T, typename Fill, typename Reference, typename Convert>
+    void test_NC1HWC2(std::vector<int> dims, int channel, Fill&& fill, Reference&& reference, Convert&& convert)
+    {
+        std::size_t src_elems = 1;
+        for (int dim : dims)
+            src_elems *= dim;
+        std::vector<T> src(src_elems);
+        for (auto& value : src)
+            value = fill();
+
+        int h = dims[2];
+        int w = dims[3];
+        std::size_t dst_elems = static_cast<std::size_t>(dims[0]) * channel * h * w;
+        std::vector<float> expected(dst_elems);
+        std::vector<float> actual(dst_elems);
+        NC1HWC2_to_NCHW_ref(src.data(), expected.data(), dims.data(), channel, h, w, reference);
+        convert(src.data(), actual.data(), dims.data(), channel, h, w);
+        EXPECT_EQ(0, mismatches(expected, actual));
+    }
+
+    void test_NC1HWC2_to_NCHW()
+    {
+        std::mt19937 random(7);
+        std::uniform_int_distribution<int> int8_values(-128, 127);
+        std::uniform_int_distribution<int> f16_values(0, 65535);
+        auto int8_fill = [&]() { return static_cast<std::int8_t>(int8_values(random)); };
+        auto f16_fill = [&]() { return static_cast<std::uint16_t>(f16_values(random)); };
+
+        const std::int32_t zp = -3;
+        const float scale = 0.047f;
+        auto int8_reference = [zp, scale](std::int8_t value) { return deqnt_affine_to_f32_ref(value, zp, scale); };
+        auto int8_convert = [zp, scale](const std::int8_t* src, float* dst, const int* dims, int channel, int h, int w) {
+            NC1HWC2_int8_to_NCHW_float(src, dst, dims, channel, h, w, zp, scale);
+        };
+        auto f16_reference = [](std::uint16_t value) { return f16_to_f32_ref(value); };
+        auto f16_convert = [](const std::uint16_t* src, float* dst, const int* dims, int channel, int h, int w) {
+            NC1HWC2_f16_to_NCHW_float(src, dst, dims, channel, h, w);
+        };
+
+        // Full planes; a partial last plane (65 channels in 16-wide planes); several 1024-element blocks per
+        // plane with a short last block; C2 wider than a block
+        const std::vector<std::vector<int>> layouts = { { 1, 4, 5, 7, 16 }, { 2, 5, 20, 20, 16 }, { 1, 3, 9, 11, 32 }, { 1, 1, 3, 2, 1100 } };
+        const int channels[] = { 64, 65, 80, 1100 };
+        for (std::size_t i = 0; i < layouts.size(); i++)
+        {
+            test_NC1HWC2<std::int8_t>(layouts[i], channels[i], int8_fill, int8_reference, int8_convert);
+            test_NC1HWC2<std::uint16_t>(layouts[i], channels[i], f16_fill, f16_reference, f16_convert);
+        }
+    }
+}
+
+int main()
+{
+    test_int8_to_f32();
+    test_f16_to_f32();
+    test_NC1HWC2_to_NCHW();
+
+    std::printf("rknn_output_conversions_test: %d failures\n", test_failures());
+    return test_failures();
+}
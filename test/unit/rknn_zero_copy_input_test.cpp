@@ -0,0 +1,90 @@
+// rknn_wrapper's zero-copy input on a batch-4 model against the mock runtime: a short batch fed after a full one
+// runs with its unused slots of the bound input memory zeroed, like the staged path pads them, instead of the
+// previous batch's frames, and its real samples still come back with their own outputs.
+#include <set>
+#include <vector>
+#include <string>
+#include <cstdio>
+
+#include "RKNN2Wrapper/rknn2_wrapper.hpp"
+#include "rknn_api_mock.hpp"
+#include "test_support.hpp"
+
+using namespace glasssix::rknnwrapper;
+
+namespace
+{
+    constexpr int input_size = 16;
+    constexpr std::uint32_t model_batch = 4;
+    constexpr std::uint8_t full_tag = 7;
+    constexpr std::uint8_t short_tag = 9;
+
+    using result_type = std::unordered_map<std::string, std::shared_ptr<glasssix::memory::tensor<float>>>;
+
+    // count HWC samples whose first byte is tag
+    std::vector<std::uint8_t> make_samples(int count, std::uint8_t tag)
+    {
+        std::size_t size = static_cast<std::size_t>(input_size) * input_size * 3;
+        std::vector<std::uint8_t> samples(count * size, 1);
+        for (int b = 0; b < count; b++)
+            samples[b * size] = tag;
+        return samples;
+    }
+
+    result_type forward(rknn_wrapper& wrapper, int count, std::uint8_t tag)
+    {
+        std::vector<std::uint8_t> samples = make_samples(count, tag);
+        return wrapper.forward(samples.data(), { count, input_size, input_size, 3 }, RKNN_TENSOR_NHWC);
+    }
+
+    int wrong_elements(const result_type& outputs, std::uint8_t tag)
+    {
+        int wrong = 0;
+        for (auto& output : outputs)
+        {
+            const float* data = output.second->cpu_data();
+            for (int i = 0; i < output.second->count(); i++)
+                wrong += data[i] != tag;
+        }
+        return wrong;
+    }
+
+    void test_short_batch(rknn_wrapper& wrapper, int count)
+    {
+        mock_rknn::set_output_pattern(nullptr);
+        EXPECT_EQ(0, wrong_elements(forward(wrapper, model_batch, full_tag), full_tag));
+
+        // Every sample the model ran on, padding included
+        std::set<float> tags;
+        mock_rknn::set_output_pattern([&](std::size_t, std::size_t, float tag) {
+            tags.insert(tag);
+            return tag;
+            });
+        result_type outputs = forward(wrapper, count, short_tag);
+        EXPECT_EQ(count, outputs.at("output")->num());
+        EXPECT_EQ(0, wrong_elements(outputs, short_tag));
+        EXPECT(tags.count(full_tag) == 0);
+        EXPECT(tags.count(0.f) == 1);
+    }
+}
+
+int main()
+{
+    mock_rknn::tensor_desc output;
+    output.name = "output";
+    output.dims = { model_batch, 4, 8, 8 };
+    mock_rknn::set_model(mock_rknn::image_model(input_size, input_size, { output }, model_batch));
+
+    std::string model_path = "rknn_zero_copy_input_test.rknn";
+    mock_rknn::write_model_file(model_path);
+    {
+        rknn_wrapper wrapper({}, model_path, -1, 0, true);
+        EXPECT(wrapper.zero_copy_input());
+        for (int count = 1; count < static_cast<int>(model_batch); count++)
+            test_short_batch(wrapper, count);
+    }
+
+    std::remove(model_path.c_str());
+    std::printf("rknn_zero_copy_input_test: %d failures\n", test_failures());
+    return test_failures();
+}
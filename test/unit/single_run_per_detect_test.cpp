@@ -0,0 +1,149 @@
+// body and peoplehead, loaded through their C entry point create() like the host application does, against the
+// mock runtime: every detect call, on either module and through every detect entry point, runs the model exactly
+// once. A frame run twice (a redundant warm-up, a retry, a second pass for the debug image) shows up as an extra
+// rknn_run in the mock's counters.
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <dlfcn.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <opencv2/opencv.hpp>
+
+#include "algorithm_base.hpp"
+#include "rknn_api_mock.hpp"
+#include "test_support.hpp"
+
+#if !defined(BODY_MOCK_MODULE)
+#define BODY_MOCK_MODULE "libbody_mock.so"
+#endif
+#if !defined(PEOPLEHEAD_MOCK_MODULE)
+#define PEOPLEHEAD_MOCK_MODULE "libpeoplehead_mock.so"
+#endif
+
+namespace
+{
+    constexpr int frames = 10;
+
+    struct module
+    {
+        void* handle = nullptr;
+        AlgorithmBase* algorithm = nullptr;
+    };
+
+    module load(const char* path, const std::string& model_path)
+    {
+        module result;
+        result.handle = dlopen(path, RTLD_NOW);
+        if (result.handle == nullptr)
+        {
+            std::fprintf(stderr, "dlopen %s: %s\n", path, dlerror());
+            return result;
+        }
+        auto create = reinterpret_cast<create_t*>(dlsym(result.handle, "create"));
+        if (create == nullptr)
+            return result;
+        result.algorithm = create();
+        result.algorithm->init(model_path);
+        return result;
+    }
+
+    void unload(module& loaded)
+    {
+        delete loaded.algorithm;
+        if (loaded.handle != nullptr)
+            dlclose(loaded.handle);
+    }
+
+    long runs()
+    {
+        return mock_rknn::snapshot().run;
+    }
+
+    void test_detect(AlgorithmBase& algorithm)
+    {
+        cv::Mat image(720, 1280, CV_8UC3, cv::Scalar(0, 0, 0));
+        AlgorithmResult result;
+
+        long before = runs();
+        for (int frame = 0; frame < frames; frame++)
+            algorithm.detect(image, result);
+        EXPECT_EQ(frames, runs() - before);
+
+        before = runs();
+        for (int frame = 0; frame < frames; frame++)
+            algorithm.detect(image);
+        EXPECT_EQ(frames, runs() - before);
+    }
+
+    void test_detect_prepared(AlgorithmBase& algorithm)
+    {
+        AlgorithmInputSpec spec;
+        EXPECT(algorithm.input_spec(spec));
+        AlgorithmPreparedInput input{ cv::Mat(spec.height, spec.width, CV_8UC3, cv::Scalar(0, 0, 0)), 1.f, 0, 0, cv::Size(spec.width, spec.height) };
+        AlgorithmResult result;
+
+        long before = runs();
+        for (int frame = 0; frame < frames; frame++)
+            algorithm.detect_prepared(input, result);
+        EXPECT_EQ(frames, runs() - before);
+    }
+}
+
+int main()
+{
+    // YOLOv8 detection head of both models: 1280x736 input, three levels of 64 box + 1 class channels.
+    // Every class logit is low, so the frames carry no detections and NMS stays out of the way
+    std::vector<mock_rknn::tensor_desc> outputs;
+    for (std::uint32_t stride : { 8u, 16u, 32u })
+    {
+        mock_rknn::tensor_desc output;
+        output.name = "output" + std::to_string(stride);
+        output.dims = { 1, 65, 736 / stride, 1280 / stride };
+        outputs.push_back(output);
+    }
+    mock_rknn::set_model(mock_rknn::image_model(1280, 736, outputs));
+    mock_rknn::set_output_pattern([](std::size_t, std::size_t, float) { return -10.f; });
+
+    std::string model_path = "single_run_models";
+    mkdir(model_path.c_str(), 0755);
+    mock_rknn::write_model_file(model_path + "/pedestrian.rknn");
+    mock_rknn::write_model_file(model_path + "/head.rknn");
+    {
+        module body = load(BODY_MOCK_MODULE, model_path);
+        module peoplehead = load(PEOPLEHEAD_MOCK_MODULE, model_path);
+        EXPECT(body.algorithm != nullptr);
+        EXPECT(peoplehead.algorithm != nullptr);
+        if (body.algorithm != nullptr && peoplehead.algorithm != nullptr)
+        {
+            // Loading and init run nothing
+            EXPECT_EQ(0, runs());
+
+            test_detect(*body.algorithm);
+            test_detect(*peoplehead.algorithm);
+            test_detect_prepared(*body.algorithm);
+            test_detect_prepared(*peoplehead.algorithm);
+
+            // Interleaved frames of both modules
+            cv::Mat image(720, 1280, CV_8UC3, cv::Scalar(0, 0, 0));
+            AlgorithmResult result;
+            long before = runs();
+            for (int frame = 0; frame < frames; frame++)
+            {
+                body.algorithm->detect(image, result);
+                peoplehead.algorithm->detect(image, result);
+            }
+            EXPECT_EQ(2 * frames, runs() - before);
+            EXPECT_EQ(runs(), mock_rknn::snapshot().outputs_get);
+        }
+        unload(peoplehead);
+        unload(body);
+    }
+
+    std::remove((model_path + "/pedestrian.rknn").c_str());
+    std::remove((model_path + "/head.rknn").c_str());
+    rmdir(model_path.c_str());
+    std::printf("single_run_per_detect_test: %d failures\n", test_failures());
+    return test_failures();
+}
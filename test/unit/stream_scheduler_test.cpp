@@ -0,0 +1,125 @@
+// stream_scheduler with an AlgorithmBase whose batch detect() throws on some frames and a result callback that throws
+// on others: the workers survive both, the failed frames are counted and reported through error_callback, every
+// other frame still gets its result callback in submit order, and submitted == processed + failed.
+#include <mutex>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <cstdio>
+#include <stdexcept>
+
+#include <opencv2/opencv.hpp>
+
+#include "stream_scheduler.hpp"
+#include "test_support.hpp"
+
+using namespace glasssix;
+
+namespace
+{
+    constexpr int frames = 60;
+
+    int tag_of(const cv::Mat& frame)
+    {
+        return frame.data[0];
+    }
+
+    bool detect_throws(int tag)
+    {
+        return tag % 3 == 0;
+    }
+
+    bool callback_throws(int tag)
+    {
+        return !detect_throws(tag) && tag % 5 == 0;
+    }
+
+    // One object per frame, labelled with the frame's tag; throws for the tags detect_throws() picks
+    class tagging_algorithm : public AlgorithmBase
+    {
+    public:
+        using AlgorithmBase::detect;
+
+        void detect(cv::Mat) override {}
+
+        void detect(const cv::Mat& input_image, AlgorithmResult& result) override
+        {
+            result.clear();
+            int tag = tag_of(input_image);
+            if (detect_throws(tag))
+                throw std::runtime_error("detect failed");
+            result.add(0, 0, 1, 1, tag, 1.f, nullptr, 0);
+        }
+
+        void init(std::string) override {}
+        void release() override {}
+    };
+}
+
+int main()
+{
+    std::mutex mutex;
+    std::vector<int> delivered;
+    int errors_reported = 0;
+
+    stream_scheduler_options options;
+    options.max_batch = 1;
+    options.stream_queue_capacity = frames;
+    options.error_callback = [&](std::exception_ptr error) {
+        std::lock_guard<std::mutex> lock(mutex);
+        EXPECT(error != nullptr);
+        errors_reported++;
+    };
+
+    int expected_failed = 0;
+    int expected_errors = 0;
+    std::vector<int> expected_delivered;
+    for (int tag = 0; tag < frames; tag++)
+    {
+        expected_failed += detect_throws(tag);
+        expected_errors += detect_throws(tag) || callback_throws(tag);
+        if (!detect_throws(tag))
+            expected_delivered.push_back(tag);
+    }
+
+    {
+        stream_scheduler scheduler({ std::make_shared<tagging_algorithm>(), std::make_shared<tagging_algorithm>() }, options);
+        int stream = scheduler.add_stream([&](const cv::Mat& frame, const AlgorithmResult& result) {
+            int tag = tag_of(frame);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                EXPECT_EQ(static_cast<std::size_t>(1), result.objects.size());
+                if (!result.objects.empty())
+                    EXPECT_EQ(tag, result.objects[0].category);
+                delivered.push_back(tag);
+            }
+            if (callback_throws(tag))
+                throw std::runtime_error("callback failed");
+        });
+
+        for (int tag = 0; tag < frames; tag++)
+            scheduler.submit(stream, cv::Mat(4, 4, CV_8UC3, cv::Scalar(tag, tag, tag)));
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        stream_scheduler_statistics statistics = scheduler.statistics();
+        while (statistics.processed + statistics.failed < frames && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            statistics = scheduler.statistics();
+        }
+        scheduler.stop();
+        statistics = scheduler.statistics();
+
+        EXPECT_EQ(static_cast<std::uint64_t>(frames), statistics.submitted);
+        EXPECT_EQ(static_cast<std::uint64_t>(0), statistics.dropped);
+        EXPECT_EQ(static_cast<std::uint64_t>(expected_failed), statistics.failed);
+        EXPECT_EQ(static_cast<std::uint64_t>(frames - expected_failed), statistics.processed);
+        EXPECT_EQ(static_cast<std::uint64_t>(expected_errors), statistics.errors);
+    }
+
+    EXPECT_EQ(expected_errors, errors_reported);
+    EXPECT(expected_delivered == delivered);
+
+    std::printf("stream_scheduler_test: %d failures\n", test_failures());
+    return test_failures();
+}
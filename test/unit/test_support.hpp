@@ -0,0 +1,34 @@
+#pragma once
+#ifndef _TEST_SUPPORT_HPP_
+#define _TEST_SUPPORT_HPP_
+
+#include <cstdio>
+
+// Minimal checks for the unit tests: a failed EXPECT prints its location and the test keeps going,
+// main() returns test_failures() so ctest sees the result.
+inline int& test_failures()
+{
+    static int failures = 0;
+    return failures;
+}
+
+#define EXPECT(condition) \
+    do { \
+        if (!(condition)) { \
+            std::fprintf(stderr, "%s:%d: EXPECT(%s) failed\n", __FILE__, __LINE__, #condition); \
+            test_failures()++; \
+        } \
+    } while (0)
+
+#define EXPECT_EQ(expected, actual) \
+    do { \
+        auto expected_value = (expected); \
+        auto actual_value = (actual); \
+        if (!(expected_value == actual_value)) { \
+            std::fprintf(stderr, "%s:%d: EXPECT_EQ(%s, %s) failed: %lld != %lld\n", __FILE__, __LINE__, #expected, #actual, \
+                static_cast<long long>(expected_value), static_cast<long long>(actual_value)); \
+            test_failures()++; \
+        } \
+    } while (0)
+
+#endif
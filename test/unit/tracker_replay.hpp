@@ -0,0 +1,101 @@
+#pragma once
+#ifndef _TRACKER_REPLAY_HPP_
+#define _TRACKER_REPLAY_HPP_
+
+#include <map>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+
+#include "Tracker/byte_tracker.hpp"
+
+// Recorded detections for replaying through tracker::byte_tracker, shared by the tracker test and benchmark.
+// The file (test/data/byte_tracker_replay.txt) has one detection per line, "frame id x1 y1 x2 y2 score category",
+// frames numbered from 1 and '#' lines ignored; id is the ground-truth object, -1 for clutter.
+namespace tracker_replay
+{
+    struct detection
+    {
+        float x1;
+        float y1;
+        float x2;
+        float y2;
+        float score;
+        int category;
+        int object;
+    };
+
+    // Detections of every frame, frames[0] being frame 1; empty when the file cannot be read
+    inline std::vector<std::vector<detection>> load(const std::string& path)
+    {
+        std::vector<std::vector<detection>> frames;
+        std::ifstream file(path);
+        std::string line;
+        while (std::getline(file, line))
+        {
+            if (line.empty() || line[0] == '#')
+                continue;
+            std::istringstream fields(line);
+            std::size_t frame;
+            detection value;
+            if (!(fields >> frame >> value.object >> value.x1 >> value.y1 >> value.x2 >> value.y2 >> value.score >> value.category) || frame == 0)
+                return {};
+            if (frames.size() < frame)
+                frames.resize(frame);
+            frames[frame - 1].push_back(value);
+        }
+        return frames;
+    }
+
+    // Tracking quality of a replay against the recorded ids
+    struct summary
+    {
+        // confirmed tracks reported, summed over the frames
+        std::size_t outputs = 0;
+        // outputs matched to clutter
+        std::size_t clutter = 0;
+        // times an object's track id differs from the one it had when last reported
+        std::size_t identity_switches = 0;
+        // distinct track ids given to recorded objects
+        std::size_t object_tracks = 0;
+    };
+
+    class scorer
+    {
+    public:
+        void add(const std::vector<detection>& frame, const std::vector<tracker::tracked_object>& tracks)
+        {
+            for (const tracker::tracked_object& track : tracks)
+            {
+                result_.outputs++;
+                if (track.detection < 0 || track.detection >= static_cast<int>(frame.size()))
+                    continue;
+                int object = frame[track.detection].object;
+                if (object < 0)
+                {
+                    result_.clutter++;
+                    continue;
+                }
+                auto last = last_track_.find(object);
+                if (last != last_track_.end() && last->second != track.track_id)
+                    result_.identity_switches++;
+                last_track_[object] = track.track_id;
+                if (object_tracks_.emplace(track.track_id, object).second)
+                    result_.object_tracks++;
+            }
+        }
+
+        const summary& result() const
+        {
+            return result_;
+        }
+
+    private:
+        summary result_;
+        std::map<int, int> last_track_;
+        std::map<int, int> object_tracks_;
+    };
+}
+
+#endif
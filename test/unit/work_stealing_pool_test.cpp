@@ -0,0 +1,137 @@
+// work_stealing_pool::parallel_for: every index runs exactly once for any count, indices are handed out as
+// contiguous per-runner ranges (so a sweep over row blocks stays in few runs per thread), a runner stuck on one
+// index has the rest of its range stolen, the first exception is rethrown and leaves the pool usable, nested calls
+// from inside a body finish, and a pool without workers runs everything on the calling thread.
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <cstdio>
+#include <stdexcept>
+
+#include "Primitives/work_stealing_pool.hpp"
+#include "test_support.hpp"
+
+using namespace glasssix;
+
+namespace
+{
+    void test_each_index_once(work_stealing_pool& pool)
+    {
+        for (std::size_t count : { 1u, 2u, 3u, 4u, 7u, 100u, 1000u })
+        {
+            std::vector<std::atomic<int>> calls(count);
+            pool.parallel_for(count, [&](std::size_t i) { calls[i].fetch_add(1); });
+            int wrong = 0;
+            for (auto& call : calls)
+                wrong += call.load() != 1;
+            EXPECT_EQ(0, wrong);
+        }
+    }
+
+    void busy_wait(std::chrono::microseconds duration)
+    {
+        auto end = std::chrono::steady_clock::now() + duration;
+        while (std::chrono::steady_clock::now() < end)
+            ;
+    }
+
+    // Neighbouring indices run on the same thread: one shared counter would interleave the threads index by index
+    void test_contiguous_ranges(work_stealing_pool& pool)
+    {
+        constexpr std::size_t count = 4096;
+        std::vector<std::thread::id> runner(count);
+        pool.parallel_for(count, [&](std::size_t i) {
+            busy_wait(std::chrono::microseconds(2));
+            runner[i] = std::this_thread::get_id();
+            });
+
+        std::size_t runs = 1;
+        for (std::size_t i = 1; i < count; i++)
+            runs += runner[i] != runner[i - 1];
+        EXPECT(runs <= count / 8);
+        EXPECT(runner[0] == std::this_thread::get_id());
+    }
+
+    // Index 0 belongs to the calling thread's range and blocks until every other index is done,
+    // so the rest of that range has to be stolen
+    void test_stealing(work_stealing_pool& pool)
+    {
+        constexpr std::size_t count = 64;
+        std::atomic<std::size_t> done{ 0 };
+        bool finished_others = false;
+        pool.parallel_for(count, [&](std::size_t i) {
+            if (i != 0)
+            {
+                done.fetch_add(1);
+                return;
+            }
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+            while (done.load() < count - 1 && std::chrono::steady_clock::now() < deadline)
+                std::this_thread::yield();
+            finished_others = done.load() == count - 1;
+            });
+        EXPECT(finished_others);
+    }
+
+    void test_exception(work_stealing_pool& pool)
+    {
+        bool caught = false;
+        try
+        {
+            pool.parallel_for(100, [](std::size_t i) {
+                if (i == 5)
+                    throw std::runtime_error("body failed");
+                });
+        }
+        catch (const std::runtime_error&)
+        {
+            caught = true;
+        }
+        EXPECT(caught);
+
+        std::atomic<std::size_t> calls{ 0 };
+        pool.parallel_for(100, [&](std::size_t) { calls.fetch_add(1); });
+        EXPECT_EQ(static_cast<std::size_t>(100), calls.load());
+    }
+
+    void test_nested(work_stealing_pool& pool)
+    {
+        std::atomic<std::size_t> calls{ 0 };
+        pool.parallel_for(16, [&](std::size_t) {
+            pool.parallel_for(16, [&](std::size_t) { calls.fetch_add(1); });
+            });
+        EXPECT_EQ(static_cast<std::size_t>(256), calls.load());
+    }
+
+    void test_no_workers()
+    {
+        work_stealing_pool pool(0);
+        EXPECT_EQ(static_cast<std::size_t>(0), pool.threads());
+        std::vector<std::size_t> order;
+        std::thread::id caller = std::this_thread::get_id();
+        pool.parallel_for(10, [&](std::size_t i) {
+            EXPECT(std::this_thread::get_id() == caller);
+            order.push_back(i);
+            });
+        EXPECT_EQ(static_cast<std::size_t>(10), order.size());
+        for (std::size_t i = 0; i < order.size(); i++)
+            EXPECT_EQ(i, order[i]);
+    }
+}
+
+int main()
+{
+    {
+        work_stealing_pool pool(3);
+        test_each_index_once(pool);
+        test_contiguous_ranges(pool);
+        test_stealing(pool);
+        test_exception(pool);
+        test_nested(pool);
+    }
+    test_no_workers();
+
+    std::printf("work_stealing_pool_test: %d failures\n", test_failures());
+    return test_failures();
+}
@@ -0,0 +1,193 @@
+// Compile-time YOLOv8 heads (yolo_wrapper::yolov8_head): the unrolled kernels give bit-identical results to plain
+// loops (dfl_expectation over the bins, threshold_compact / threshold_compact_best_class over the classes),
+// dfl_distances gives every candidate the same distances however the candidates are grouped, and a
+// Yolov8 with a fixed head decodes random outputs to the same boxes as the runtime decoder, for detection,
+// Exception, posture and Exception posture heads. The fixed head scans every level whole, so the runtime decoder's
+// parallel row blocks must also come out in the same order, class-major within a level, for NMS to break ties alike.
+#include <cmath>
+#include <tuple>
+#include <random>
+#include <vector>
+#include <cstdio>
+#include <algorithm>
+#include <type_traits>
+
+#include "YoloFamily/Yolo_wrapper.hpp"
+#include "test_support.hpp"
+
+namespace
+{
+    std::vector<float> random_values(std::size_t count, std::mt19937& random, float mean = -3.f, float deviation = 2.f)
+    {
+        std::normal_distribution<float> distribution(mean, deviation);
+        std::vector<float> values(count);
+        for (float& value : values)
+            value = distribution(random);
+        return values;
+    }
+
+    template <int Bins>
+    float dfl_expectation_loop(const float* x, std::size_t stride)
+    {
+        float max_value = x[0];
+        for (int i = 1; i < Bins; i++)
+            max_value = std::max(max_value, x[i * stride]);
+
+        float sum = 0.f;
+        float weighted_sum = 0.f;
+        for (int i = 0; i < Bins; i++)
+        {
+            float e = std::exp(x[i * stride] - max_value);
+            sum += e;
+            weighted_sum += e * i;
+        }
+        return weighted_sum / sum;
+    }
+
+    template <int Bins>
+    void test_dfl_expectation(std::mt19937& random)
+    {
+        constexpr std::size_t stride = 7;
+        std::vector<float> bins = random_values(Bins * stride, random, 0.f, 3.f);
+        for (std::size_t offset = 0; offset < stride; offset++)
+        {
+            float expected = dfl_expectation_loop<Bins>(bins.data() + offset, stride);
+            float actual = yolo_wrapper::dfl_expectation<Bins>(bins.data() + offset, stride);
+            EXPECT(expected == actual);
+        }
+    }
+
+    // A candidate's distances do not depend on which other candidates share the call or where it sits in it
+    template <int Bins>
+    void test_dfl_distances_grouping(std::mt19937& random)
+    {
+        constexpr std::size_t count = 37;
+        std::vector<float> bins = random_values(4 * Bins * count, random, 0.f, 3.f);
+        std::vector<float> whole(4 * count);
+        yolo_wrapper::dfl_distances<Bins>(bins.data(), count, count, whole.data(), count);
+
+        for (std::size_t first : { 0u, 3u, 8u, 30u })
+            for (std::size_t group = 1; first + group <= count; group += 5)
+            {
+                std::vector<float> part(4 * group);
+                yolo_wrapper::dfl_distances<Bins>(bins.data() + first, count, group, part.data(), group);
+                for (int side = 0; side < 4; side++)
+                    for (std::size_t k = 0; k < group; k++)
+                        EXPECT(part[side * group + k] == whole[side * count + first + k]);
+            }
+    }
+
+    template <int Classes>
+    void test_threshold_compact(std::mt19937& random)
+    {
+        // Cell counts around the vector widths, so that both the vector body and the scalar tail run
+        for (std::size_t cells : { 1u, 7u, 8u, 13u, 64u, 333u })
+        {
+            std::vector<float> scores = random_values(Classes * cells, random);
+            std::vector<int> expected_cells(Classes * cells), expected_labels(Classes * cells);
+            std::vector<int> actual_cells(Classes * cells), actual_labels(Classes * cells);
+            std::integral_constant<int, Classes> classes;
+
+            std::size_t expected = yolo_wrapper::threshold_compact(scores.data(), cells, 0, cells, Classes, -1.f, expected_cells.data(), expected_labels.data());
+            std::size_t actual = yolo_wrapper::threshold_compact(scores.data(), cells, 0, cells, classes, -1.f, actual_cells.data(), actual_labels.data());
+            EXPECT_EQ(expected, actual);
+            EXPECT(std::equal(expected_cells.begin(), expected_cells.begin() + expected, actual_cells.begin()));
+            EXPECT(std::equal(expected_labels.begin(), expected_labels.begin() + expected, actual_labels.begin()));
+
+            expected = yolo_wrapper::threshold_compact_best_class(scores.data(), cells, 0, cells, Classes, -2.f, expected_cells.data(), expected_labels.data());
+            actual = yolo_wrapper::threshold_compact_best_class(scores.data(), cells, 0, cells, classes, -2.f, actual_cells.data(), actual_labels.data());
+            EXPECT_EQ(expected, actual);
+            EXPECT(std::equal(expected_cells.begin(), expected_cells.begin() + expected, actual_cells.begin()));
+            EXPECT(std::equal(expected_labels.begin(), expected_labels.begin() + expected, actual_labels.begin()));
+        }
+    }
+
+    struct no_pipeline {};
+
+    template <bool Exception, bool Posture, typename Head>
+    class decoder : public Yolov8<no_pipeline, Exception, Posture, Head>
+    {
+    public:
+        decoder() : Yolov8<no_pipeline, Exception, Posture, Head>(640, 640, nullptr) {}
+    };
+
+    using box = std::tuple<int, float, float, float, float, float, std::vector<float>>;
+
+    // The boxes of a batch as (label, x, y, w, h, score, key points), in decode order
+    std::vector<box> boxes_of(detection_batch& detections)
+    {
+        std::vector<box> boxes;
+        for (std::size_t i = 0; i < detections.size(); i++)
+        {
+            const float* key_points = detections.key_points_of(i);
+            boxes.emplace_back(detections.label[i], detections.x[i], detections.y[i], detections.w[i], detections.h[i], detections.score[i],
+                std::vector<float>(key_points, key_points + detections.key_point_count() * detection_batch::key_point_stride));
+        }
+        return boxes;
+    }
+
+    using tensors = std::vector<std::shared_ptr<memory::tensor<float>>>;
+
+    tensors random_outputs(const std::vector<std::vector<int>>& shapes, std::mt19937& random)
+    {
+        tensors outputs;
+        for (const auto& shape : shapes)
+        {
+            auto output = std::make_shared<memory::tensor<float>>(shape);
+            std::vector<float> values = random_values(output->count(), random);
+            std::copy(values.begin(), values.end(), output->mutable_cpu_data());
+            outputs.push_back(output);
+        }
+        return outputs;
+    }
+
+    template <bool Exception, bool Posture, typename Head>
+    void test_decoder(const tensors& outputs, bool best_class_only)
+    {
+        decoder<Exception, Posture, void> runtime;
+        decoder<Exception, Posture, Head> fixed;
+        runtime.set_best_class_only(best_class_only);
+        fixed.set_best_class_only(best_class_only);
+
+        detection_batch expected;
+        detection_batch actual;
+        tensors runtime_outputs = outputs;
+        tensors fixed_outputs = outputs;
+        runtime.yoloconcat(runtime_outputs, 0.3f, expected);
+        fixed.yoloconcat(fixed_outputs, 0.3f, actual);
+
+        EXPECT(expected.size() > 0);
+        EXPECT(boxes_of(expected) == boxes_of(actual));
+    }
+}
+
+int main()
+{
+    std::mt19937 random(3);
+
+    test_dfl_expectation<16>(random);
+    test_dfl_expectation<8>(random);
+    test_dfl_distances_grouping<16>(random);
+    test_dfl_distances_grouping<8>(random);
+    test_threshold_compact<1>(random);
+    test_threshold_compact<3>(random);
+    test_threshold_compact<80>(random);
+
+    using detection_head = yolo_wrapper::yolov8_head<640, 640, 16, 3, 0, 32, 16, 8>;
+    using posture_head = yolo_wrapper::yolov8_head<640, 640, 16, 1, 17, 32, 16, 8>;
+
+    tensors detection = random_outputs({ { 1, 67, 20, 20 }, { 1, 67, 40, 40 }, { 1, 67, 80, 80 } }, random);
+    for (bool best_class_only : { false, true })
+    {
+        test_decoder<false, false, detection_head>(detection, best_class_only);
+        test_decoder<true, false, detection_head>(detection, best_class_only);
+    }
+
+    tensors posture = random_outputs({ { 1, 51, 20, 20 }, { 1, 65, 20, 20 }, { 1, 51, 40, 40 }, { 1, 65, 40, 40 }, { 1, 51, 80, 80 }, { 1, 65, 80, 80 } }, random);
+    test_decoder<false, true, posture_head>(posture, false);
+    tensors exception_posture = random_outputs({ { 1, 34, 20, 20 }, { 1, 65, 20, 20 }, { 1, 34, 40, 40 }, { 1, 65, 40, 40 }, { 1, 34, 80, 80 }, { 1, 65, 80, 80 } }, random);
+    test_decoder<true, true, posture_head>(exception_posture, false);
+
+    std::printf("yolo_fixed_head_test: %d failures\n", test_failures());
+    return test_failures();
+}
@@ -0,0 +1,95 @@
+// The int8 YOLOv8 decoder (yolov8concat_general_quantized) against the float one (yolov8concat_general) on the
+// same outputs: the int8 tensors, and their dequantized copies. Both share the templated decode_general, so the
+// candidates must be identical and the boxes equal up to the rounding of the DFL kernel.
+#include <cmath>
+#include <random>
+#include <vector>
+#include <memory>
+#include <cstdio>
+
+#include "YoloFamily/Yolo_wrapper.hpp"
+#include "test_support.hpp"
+
+using namespace glasssix;
+
+namespace
+{
+    constexpr int model_size = 320;
+    constexpr int classes = 2;
+
+    // Exposes the two decoders; the pipeline is never used
+    class decoder : public Yolov8<rknnwrapper::rknn_wrapper>
+    {
+    public:
+        decoder() :Yolov8<rknnwrapper::rknn_wrapper>(model_size, model_size, nullptr) {}
+        using Yolov8<rknnwrapper::rknn_wrapper>::yolov8concat_general;
+        using Yolov8<rknnwrapper::rknn_wrapper>::yolov8concat_general_quantized;
+    };
+
+    void compare(bool parallel, bool best_class_only)
+    {
+        std::mt19937 random(parallel * 2 + best_class_only);
+        std::uniform_int_distribution<int> box_values(-128, 127);
+        std::uniform_int_distribution<int> score_values(-128, 0);
+
+        std::vector<rknnwrapper::quantized_tensor> quantized;
+        std::vector<std::shared_ptr<memory::tensor<float>>> dequantized;
+        // Levels in the order sort_model_result gives them: smallest grid (stride 32) first
+        for (int stride : { 32, 16, 8 })
+        {
+            int grid = model_size / stride;
+            std::vector<int> shape = { 1, 64 + classes, grid, grid };
+            rknnwrapper::quantized_tensor level{ std::make_shared<memory::tensor<std::int8_t>>(shape), -10, 0.1f };
+            auto level_float = std::make_shared<memory::tensor<float>>(shape);
+
+            std::int8_t* data = level.data->mutable_cpu_data();
+            float* data_float = level_float->mutable_cpu_data();
+            int cells = grid * grid;
+            for (int i = 0; i < level.data->count(); i++)
+            {
+                data[i] = static_cast<std::int8_t>(i < 64 * cells ? box_values(random) : score_values(random));
+                data_float[i] = yolo_wrapper::dequantize(data[i], level.zp, level.scale);
+            }
+            quantized.push_back(level);
+            dequantized.push_back(level_float);
+        }
+
+        decoder float_decoder;
+        decoder int8_decoder;
+        float_decoder.set_parallel_decode(parallel);
+        int8_decoder.set_parallel_decode(parallel);
+        float_decoder.set_best_class_only(best_class_only);
+        int8_decoder.set_best_class_only(best_class_only);
+
+        detection_batch expected;
+        detection_batch actual;
+        float_decoder.yolov8concat_general(dequantized, 0.5f, expected);
+        int8_decoder.yolov8concat_general_quantized(quantized, 0.5f, actual);
+
+        EXPECT(expected.size() > 0);
+        EXPECT_EQ(expected.size(), actual.size());
+        if (expected.size() != actual.size())
+            return;
+
+        int mismatches = 0;
+        for (std::size_t i = 0; i < expected.size(); i++)
+        {
+            bool same = expected.label[i] == actual.label[i] && expected.score[i] == actual.score[i] &&
+                std::fabs(expected.x[i] - actual.x[i]) < 1e-3f && std::fabs(expected.y[i] - actual.y[i]) < 1e-3f &&
+                std::fabs(expected.w[i] - actual.w[i]) < 1e-3f && std::fabs(expected.h[i] - actual.h[i]) < 1e-3f;
+            mismatches += !same;
+        }
+        EXPECT_EQ(0, mismatches);
+    }
+}
+
+int main()
+{
+    compare(false, false);
+    compare(true, false);
+    compare(false, true);
+    compare(true, true);
+
+    std::printf("yolov8_quantized_decode_test: %d failures\n", test_failures());
+    return test_failures();
+}